@@ -15,6 +15,11 @@ extern "C"
     typedef void *UNIGD_RENDERERS_HANDLE;
     typedef void *UNIGD_RENDERERS_ENTRY_HANDLE;
     typedef void *UNIGD_FIND_HANDLE;
+    typedef void *UNIGD_HIT_HANDLE;
+    typedef void *UNIGD_TILES_HANDLE;
+    typedef void *UNIGD_ASYNC_RENDER_HANDLE;
+    typedef void *UNIGD_BATCH_HANDLE;
+    typedef void *UNIGD_DELTA_HANDLE;
     typedef const char *UNIGD_RENDERER_ID;
     typedef uint32_t UNIGD_PLOT_ID;
     typedef uint32_t UNIGD_PLOT_INDEX;
@@ -25,6 +30,8 @@ extern "C"
     {
         void (*start)(void *);
         void (*close)(void *);
+        // Called from a unigd thread if the device merges state changes (see
+        // notify_window of ugd()), the last state change is always delivered.
         void (*state_change)(void *);
         const char *(*info)(void *);
     };
@@ -66,6 +73,18 @@ extern "C"
         uint64_t size;
     };
 
+    // Client memory a plot is rendered into (see device_render_into).
+    struct unigd_render_buffer
+    {
+        uint8_t *buffer;
+        uint64_t capacity;
+        // Called when the output does not fit: returns a buffer of at least `capacity`
+        // bytes that starts with the `used` bytes of the old one (like realloc), or NULL.
+        // May be NULL. Must not block, the plot is locked while it runs.
+        uint8_t *(*grow)(void *user_data, uint8_t *buffer, uint64_t used, uint64_t capacity);
+        void *user_data;
+    };
+
     struct unigd_find_results
     {
         unigd_device_state state;
@@ -73,6 +92,73 @@ extern "C"
         UNIGD_PLOT_ID *ids;
     };
 
+    struct unigd_rect
+    {
+        double x;
+        double y;
+        double width;
+        double height;
+    };
+
+    struct unigd_hit_results
+    {
+        uint64_t size;
+        const uint64_t *indices;
+    };
+
+    // Position in the draw calls of a plot. Sequence 0 is before the first draw call
+    // of every plot.
+    struct unigd_delta_cursor
+    {
+        UNIGD_PLOT_ID id;
+        uint64_t sequence;
+    };
+
+    struct unigd_delta_results
+    {
+        // Cursor to pass with the next request.
+        unigd_delta_cursor next;
+        // The data holds the whole plot, draw calls received before are gone (the plot
+        // has been cleared or replayed).
+        bool reset;
+        const uint8_t *buffer;
+        uint64_t size;
+    };
+
+    struct unigd_tile_args
+    {
+        int32_t zoom;
+        uint32_t x;
+        uint32_t y;
+    };
+
+    struct unigd_batch_args
+    {
+        UNIGD_PLOT_ID id;
+        UNIGD_RENDERER_ID renderer;
+        unigd_render_args args;
+    };
+
+    enum unigd_async_status
+    {
+        UNIGD_ASYNC_PENDING = 0,
+        UNIGD_ASYNC_DONE = 1,
+        UNIGD_ASYNC_FAILED = 2,
+        UNIGD_ASYNC_CANCELLED = 3
+    };
+
+    // Called once when an asynchronous render is done or failed (never for cancelled
+    // renders), from a unigd worker thread (or the calling thread for cached renders),
+    // never from the R thread. It may call other unigd functions, synchronous renders
+    // run on the thread that calls them. The buffer stays valid until the render handle
+    // is destroyed.
+    typedef void (*unigd_render_callback)(void *user_data, unigd_async_status status, unigd_render_access access);
+
+    // Receives the output of a streamed render one chunk at a time. The chunk is only
+    // valid during the call. Return false to stop the render. Must not block, the plot
+    // is locked while it runs (see device_render_stream).
+    typedef bool (*unigd_chunk_callback)(void *user_data, const uint8_t *data, uint64_t size);
+
     // unigd API access version 1
     struct unigd_api_v1
     {
@@ -141,6 +227,120 @@ extern "C"
 
         // Free memory of renderer lookup.
         void (*renderers_find_destroy)(UNIGD_RENDERERS_ENTRY_HANDLE);
+
+        // SPATIAL QUERIES
+
+        // Render a sub-rectangle of a plot. The region is given in plot coordinates
+        // (origin at the top left) of the plot at the size requested in the render args,
+        // the output has the size of the region times the scale.
+        // Free with device_render_destroy.
+        UNIGD_RENDER_HANDLE(*device_render_region_create)
+        (UNIGD_HANDLE, UNIGD_RENDERER_ID, UNIGD_PLOT_ID, unigd_render_args, unigd_rect region, unigd_render_access *);
+
+        // Find the draw calls whose bounding boxes intersect a rectangle (width and height
+        // of 0 for a point) in plot coordinates of the plot at its last rendered size.
+        // Draw calls are numbered in drawing order starting at 0, every element of a
+        // primitive run counts.
+        UNIGD_HIT_HANDLE(*device_plots_hit_test)
+        (UNIGD_HANDLE, UNIGD_PLOT_ID, unigd_rect rect, unigd_hit_results *results);
+
+        // Free hit test memory.
+        void (*device_plots_hit_test_destroy)(UNIGD_HIT_HANDLE);
+
+        // TILES
+
+        // Render tiles of a plot at its current size in parallel. At zoom level z the
+        // plot is rendered at scale 2^z, tile (x, y) covers the output pixels from
+        // (x * tile_size, y * tile_size) to ((x + 1) * tile_size, (y + 1) * tile_size).
+        // Fills one render access entry per tile (empty for tiles that failed).
+        // Tiles are cached until the plot changes.
+        UNIGD_TILES_HANDLE(*device_render_tiles_create)
+        (UNIGD_HANDLE, UNIGD_RENDERER_ID, UNIGD_PLOT_ID, const unigd_tile_args *tiles, uint64_t count, uint32_t tile_size, unigd_render_access *results);
+
+        // Free tile render memory.
+        void (*device_render_tiles_destroy)(UNIGD_TILES_HANDLE);
+
+        // ASYNCHRONOUS RENDERING
+
+        // Start rendering a plot without waiting for it. The render is done on unigd
+        // worker threads; plots that have to be replayed at a new size additionally wait
+        // for the R event loop. The callback may be NULL, in which case the render has
+        // to be polled. Cached renders complete (and call the callback) before this
+        // returns.
+        UNIGD_ASYNC_RENDER_HANDLE(*device_render_async_create)
+        (UNIGD_HANDLE, UNIGD_RENDERER_ID, UNIGD_PLOT_ID, unigd_render_args, unigd_render_callback callback, void *user_data);
+
+        // Get the status of an asynchronous render (does not block). Fills the render
+        // access if the render is done.
+        unigd_async_status (*device_render_async_poll)(UNIGD_ASYNC_RENDER_HANDLE, unigd_render_access *);
+
+        // Cancel an asynchronous render. Returns false if it has already finished.
+        // The callback is not called for cancelled renders.
+        bool (*device_render_async_cancel)(UNIGD_ASYNC_RENDER_HANDLE);
+
+        // Free asynchronous render memory (cancels pending renders).
+        void (*device_render_async_destroy)(UNIGD_ASYNC_RENDER_HANDLE);
+
+        // BATCH RENDERING
+
+        // Render several plots, renderers and sizes in one call. Plots stored at the
+        // requested size are rendered in parallel, all replays needed for the others
+        // are done in a single R event loop round trip. Fills one render access entry
+        // per request (empty for requests that failed).
+        UNIGD_BATCH_HANDLE(*device_render_batch_create)
+        (UNIGD_HANDLE, const unigd_batch_args *requests, uint64_t count, unigd_render_access *results);
+
+        // Free batch render memory.
+        void (*device_render_batch_destroy)(UNIGD_BATCH_HANDLE);
+
+        // STREAMING
+
+        // Render a plot and hand the output to the callback in chunks (of at most 64 KiB)
+        // while it is produced, instead of returning one buffer. Returns when the render
+        // is done. SVG output is flushed between draw calls, as soon as a chunk has been
+        // written (a single huge draw call is held until it is complete). PDF, PS, EPS
+        // and PNG output is flushed as it is encoded. Other renderers hand out their
+        // finished output in chunks. The callback is called on the calling thread and
+        // must not call into the same device. Until it returns the plot is locked
+        // against drawing and replays, which stalls the R session when it draws to the
+        // plot. So the callback must not block (e.g. on network I/O); slow consumers
+        // should copy the chunk and send it later. Returns false if the plot could not
+        // be rendered or the callback stopped the render.
+        bool (*device_render_stream)(UNIGD_HANDLE, UNIGD_RENDERER_ID, UNIGD_PLOT_ID, unigd_render_args, unigd_chunk_callback callback, void *user_data);
+
+        // Render a plot straight into client memory, no render handle is created. The
+        // renderer writes into the buffer as it produces the output (see
+        // device_render_stream), growing it with the grow callback when needed; the
+        // buffer and capacity fields are updated. The plot is locked against drawing
+        // and replays during the render, grow included, so grow must not block either.
+        // Sets size to the size of the output (also when it did not fit, so the client
+        // can retry with a large enough buffer). Returns false if the plot could not be
+        // rendered or the output did not fit.
+        bool (*device_render_into)(UNIGD_HANDLE, UNIGD_RENDERER_ID, UNIGD_PLOT_ID, unigd_render_args, unigd_render_buffer *buffer, uint64_t *size);
+
+        // DRAW CALL DELTAS
+
+        // Get the draw calls a plot received since the cursor, so clients can patch
+        // their scene instead of fetching the whole plot after a state change. The data
+        // uses the binary page encoding of unigd (host byte order): clip regions, the
+        // complete style table, the culled draw call count and the new draw calls. Fails
+        // (returns NULL) if the plot does not exist or its draw calls have been evicted
+        // to stay within the memory budget.
+        UNIGD_DELTA_HANDLE(*device_plots_delta)
+        (UNIGD_HANDLE, unigd_delta_cursor since, unigd_delta_results *results);
+
+        // Free delta memory.
+        void (*device_plots_delta_destroy)(UNIGD_DELTA_HANDLE);
+
+        // LEVEL OF DETAIL
+
+        // Render a plot simplified to a tolerance in output pixels: polylines, polygons
+        // and paths lose the vertices that would not change the output by more than lod
+        // pixels, circles drawn on top of an identical circle are dropped. A lod of 0
+        // renders all details (like device_render_create).
+        // Free with device_render_destroy.
+        UNIGD_RENDER_HANDLE(*device_render_lod_create)
+        (UNIGD_HANDLE, UNIGD_RENDERER_ID, UNIGD_PLOT_ID, unigd_render_args, double lod, unigd_render_access *);
     };
 
 #ifdef __cplusplus
@@ -0,0 +1,247 @@
+#ifndef __UNIGD_ARENA_LIST_H__
+#define __UNIGD_ARENA_LIST_H__
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace unigd
+{
+// Sequence of polymorphic objects (derived from T) that live in memory blocks owned by
+// the list.
+//
+// Objects are bump allocated into blocks that grow geometrically, so recording many
+// small objects costs a handful of allocations instead of one per object. Splicing two
+// lists hands over the blocks, except for small lists whose objects are moved into the
+// blocks of the receiving list (see splice). Otherwise objects never move. Clearing
+// destroys all objects and frees the blocks wholesale. T needs a virtual destructor, and
+// the objects have to be move constructible.
+template <class T>
+class arena_list
+{
+ public:
+  using iterator = typename std::vector<T*>::const_iterator;
+
+  arena_list() = default;
+  ~arena_list() { m_destroy(); }
+
+  arena_list(const arena_list&) = delete;
+  arena_list& operator=(const arena_list&) = delete;
+
+  arena_list(arena_list&& t_other) noexcept
+      : m_items(std::move(t_other.m_items)),
+        m_moves(std::move(t_other.m_moves)),
+        m_blocks(std::move(t_other.m_blocks)),
+        m_pos(t_other.m_pos),
+        m_end(t_other.m_end),
+        m_bytes(t_other.m_bytes),
+        m_allocations(t_other.m_allocations)
+  {
+    t_other.m_reset();
+  }
+
+  arena_list& operator=(arena_list&& t_other) noexcept
+  {
+    if (this != &t_other)
+    {
+      m_destroy();
+      m_items = std::move(t_other.m_items);
+      m_moves = std::move(t_other.m_moves);
+      m_blocks = std::move(t_other.m_blocks);
+      m_pos = t_other.m_pos;
+      m_end = t_other.m_end;
+      m_bytes = t_other.m_bytes;
+      m_allocations = t_other.m_allocations;
+      t_other.m_reset();
+    }
+    return *this;
+  }
+
+  template <class U, class... Args>
+  U* emplace(Args&&... t_args)
+  {
+    static_assert(std::is_base_of<T, U>::value, "only objects derived from T");
+    static_assert(alignof(U) <= alignof(std::max_align_t), "unsupported alignment");
+    m_items.push_back(nullptr);
+    U* obj;
+    try
+    {
+      m_moves.push_back(&m_move_to<U>);
+      obj = new (m_allocate(sizeof(U))) U(std::forward<Args>(t_args)...);
+    }
+    catch (...)
+    {
+      m_items.pop_back();
+      m_moves.resize(m_items.size());
+      throw;
+    }
+    m_items.back() = obj;
+    return obj;
+  }
+
+  // Destroys the last object. Its memory is only reclaimed by clear().
+  void pop_back()
+  {
+    m_items.back()->~T();
+    m_items.pop_back();
+    m_moves.pop_back();
+  }
+
+  // Destroys all objects for which t_pred returns true and returns their number. Their
+  // memory is only reclaimed by clear().
+  template <class P>
+  std::size_t remove_if(P t_pred)
+  {
+    std::size_t kept = 0;
+    for (std::size_t i = 0; i != m_items.size(); ++i)
+    {
+      if (t_pred(m_items[i]))
+      {
+        m_items[i]->~T();
+        continue;
+      }
+      m_items[kept] = m_items[i];
+      m_moves[kept] = m_moves[i];
+      ++kept;
+    }
+    const std::size_t removed = m_items.size() - kept;
+    m_items.resize(kept);
+    m_moves.resize(kept);
+    return removed;
+  }
+
+  // Moves all objects of t_other to the end of this list.
+  void splice(arena_list&& t_other)
+  {
+    if (m_items.empty() && m_blocks.empty())
+    {
+      *this = std::move(t_other);
+      return;
+    }
+    if (t_other.m_bytes <= move_limit)
+    {
+      // Taking over the blocks of many small lists (e.g. a flush of the device buffer
+      // after every low level plot call) would keep a mostly empty block alive for each
+      // of them.
+      m_items.reserve(m_items.size() + t_other.m_items.size());
+      for (std::size_t i = 0; i != t_other.m_items.size(); ++i)
+      {
+        t_other.m_moves[i](t_other.m_items[i], this);
+      }
+      m_allocations += t_other.m_allocations;
+      t_other.clear();
+      return;
+    }
+    m_items.insert(m_items.end(), t_other.m_items.begin(), t_other.m_items.end());
+    m_moves.insert(m_moves.end(), t_other.m_moves.begin(), t_other.m_moves.end());
+    m_blocks.insert(m_blocks.end(), std::make_move_iterator(t_other.m_blocks.begin()),
+                    std::make_move_iterator(t_other.m_blocks.end()));
+    m_bytes += t_other.m_bytes;
+    m_allocations += t_other.m_allocations;
+    // Keep allocating from whichever tail block has more room left.
+    if (t_other.m_end - t_other.m_pos > m_end - m_pos)
+    {
+      m_pos = t_other.m_pos;
+      m_end = t_other.m_end;
+    }
+    t_other.m_items.clear();
+    t_other.m_moves.clear();
+    t_other.m_blocks.clear();
+    t_other.m_reset();
+  }
+
+  void clear()
+  {
+    m_destroy();
+    m_reset();
+  }
+
+  std::size_t size() const { return m_items.size(); }
+  bool empty() const { return m_items.empty(); }
+
+  iterator begin() const { return m_items.begin(); }
+  iterator end() const { return m_items.end(); }
+  T* operator[](std::size_t t_index) const { return m_items[t_index]; }
+  T* back() const { return m_items.back(); }
+
+  // Number of memory blocks held (i.e. heap allocations made for the objects).
+  std::size_t blocks() const { return m_blocks.size(); }
+  // Total size of the memory blocks held (in bytes).
+  std::size_t capacity() const { return m_bytes; }
+  // Number of blocks ever allocated for the objects held, including the blocks of
+  // spliced lists that have been freed after moving their objects.
+  std::size_t allocations() const { return m_allocations; }
+
+ private:
+  static constexpr std::size_t min_block_size = 1024;
+  static constexpr std::size_t max_block_size = 64 * 1024;
+  static constexpr std::size_t align = alignof(std::max_align_t);
+  // Spliced lists with at most this many bytes of blocks have their objects moved.
+  static constexpr std::size_t move_limit = 4 * min_block_size;
+
+  using move_fn = void (*)(T*, arena_list*);
+
+  std::vector<T*> m_items{};
+  std::vector<move_fn> m_moves{};  // per item, to move it into another list
+  std::vector<std::unique_ptr<unsigned char[]>> m_blocks{};
+  unsigned char* m_pos = nullptr;
+  unsigned char* m_end = nullptr;
+  std::size_t m_bytes = 0;
+  std::size_t m_allocations = 0;
+
+  template <class U>
+  static void m_move_to(T* t_item, arena_list* t_list)
+  {
+    t_list->template emplace<U>(std::move(*static_cast<U*>(t_item)));
+  }
+
+  void* m_allocate(std::size_t t_size)
+  {
+    t_size = (t_size + align - 1) & ~(align - 1);
+    if (static_cast<std::size_t>(m_end - m_pos) < t_size)
+    {
+      // Small lists (most flushes of the device buffer) stay small, long ones quickly
+      // reach the maximum block size.
+      const std::size_t average = m_blocks.empty() ? 0 : m_bytes / m_blocks.size();
+      const std::size_t size = std::max(
+          t_size, std::min(max_block_size, std::max(min_block_size, average * 2)));
+      std::unique_ptr<unsigned char[]> block(new unsigned char[size]);
+      m_blocks.push_back(std::move(block));
+      m_pos = m_blocks.back().get();
+      m_end = m_pos + size;
+      m_bytes += size;
+      m_allocations++;
+    }
+    void* mem = m_pos;
+    m_pos += t_size;
+    return mem;
+  }
+
+  void m_destroy()
+  {
+    for (T* item : m_items)
+    {
+      item->~T();
+    }
+    m_items.clear();
+    m_moves.clear();
+    m_blocks.clear();
+  }
+
+  void m_reset()
+  {
+    m_pos = nullptr;
+    m_end = nullptr;
+    m_bytes = 0;
+    m_allocations = 0;
+  }
+};
+
+}  // namespace unigd
+
+#endif /* __UNIGD_ARENA_LIST_H__ */
@@ -1,11 +1,18 @@
 #ifndef __UNIGD_ASYNC_UTILS_H__
 #define __UNIGD_ASYNC_UTILS_H__
 
+#include <algorithm>
+#include <atomic>
 #include <condition_variable>
+#include <exception>
 #include <functional>
+#include <future>
 #include <memory>
 #include <mutex>
 #include <queue>
+#include <thread>
+#include <type_traits>
+#include <vector>
 
 namespace unigd
 {
@@ -116,6 +123,8 @@ class function_wrapper
 
   void call() { impl->call(); }
 
+  explicit operator bool() const { return impl != nullptr; }
+
   function_wrapper(function_wrapper&& other) : impl(std::move(other.impl)) {}
 
   function_wrapper& operator=(function_wrapper&& other)
@@ -128,6 +137,142 @@ class function_wrapper
   function_wrapper(function_wrapper&) = delete;
   function_wrapper& operator=(const function_wrapper&) = delete;
 };
+
+// Fixed set of worker threads that run submitted tasks in submission order. Empty
+// tasks tell a worker to stop, the destructor finishes all queued tasks first.
+class thread_pool
+{
+  threadsafe_queue<function_wrapper> work_queue;
+  std::vector<std::thread> threads;
+
+  void worker_thread()
+  {
+    for (;;)
+    {
+      function_wrapper task;
+      work_queue.wait_and_pop(task);
+      if (!task)
+      {
+        return;
+      }
+      task.call();
+    }
+  }
+
+ public:
+  explicit thread_pool(unsigned thread_count)
+  {
+    thread_count = std::max(thread_count, 1U);
+    for (unsigned i = 0; i != thread_count; ++i)
+    {
+      threads.emplace_back(&thread_pool::worker_thread, this);
+    }
+  }
+
+  ~thread_pool()
+  {
+    for (std::size_t i = 0; i != threads.size(); ++i)
+    {
+      work_queue.push(function_wrapper());
+    }
+    for (auto& t : threads)
+    {
+      t.join();
+    }
+  }
+
+  thread_pool(const thread_pool&) = delete;
+  thread_pool& operator=(const thread_pool&) = delete;
+
+  template <typename FunctionType>
+  std::future<std::invoke_result_t<FunctionType>> submit(FunctionType f)
+  {
+    typedef std::invoke_result_t<FunctionType> result_type;
+    std::packaged_task<result_type()> task(std::move(f));
+    std::future<result_type> res(task.get_future());
+    work_queue.push(std::move(task));
+    return res;
+  }
+
+  std::size_t size() const { return threads.size(); }
+};
+
+// Worker threads shared by all parallel_for() calls of the process, one per core.
+inline thread_pool& shared_pool()
+{
+  static thread_pool pool(std::thread::hardware_concurrency());
+  return pool;
+}
+
+// Calls t_fn(i) for every i below t_count, on the calling thread and on up to
+// t_threads - 1 workers of the shared pool. Returns when all calls are done, rethrowing
+// the first exception.
+//
+// The caller only waits for calls that have already started, helpers that are still
+// queued find no work left once they run. So parallel_for() may be called from pool
+// tasks and nested (e.g. raster bands within tiles) without ever starting more threads
+// than the shared pool has.
+template <typename F>
+void parallel_for(std::size_t t_count, unsigned t_threads, F t_fn)
+{
+  struct state
+  {
+    std::atomic<std::size_t> next{0};
+    std::size_t count;
+    std::function<void(std::size_t)> fn;
+    std::mutex mutex;
+    std::condition_variable cv;
+    unsigned running = 0;
+    std::exception_ptr error;
+
+    void work()
+    {
+      for (std::size_t i = next++; i < count; i = next++)
+      {
+        try
+        {
+          fn(i);
+        }
+        catch (...)
+        {
+          const std::lock_guard<std::mutex> lock(mutex);
+          if (!error)
+          {
+            error = std::current_exception();
+          }
+        }
+      }
+    }
+  };
+
+  auto st = std::make_shared<state>();
+  st->count = t_count;
+  st->fn = std::move(t_fn);
+  const auto helpers = std::min<std::size_t>(
+      t_count, std::min<std::size_t>(std::max(t_threads, 1U), shared_pool().size()));
+  for (std::size_t h = 1; h < helpers; ++h)
+  {
+    shared_pool().submit(
+        [st]()
+        {
+          {
+            const std::lock_guard<std::mutex> lock(st->mutex);
+            st->running++;
+          }
+          st->work();
+          const std::lock_guard<std::mutex> lock(st->mutex);
+          st->running--;
+          st->cv.notify_all();
+        });
+  }
+  st->work();
+  std::unique_lock<std::mutex> lock(st->mutex);
+  st->cv.wait(lock, [&] { return st->running == 0; });
+  if (st->error)
+  {
+    std::rethrow_exception(st->error);
+  }
+}
 }  // namespace async
 
 }  // namespace unigd
@@ -13,42 +13,59 @@ const static char encode_lookup[] =
     "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
 const static char pad_character = '=';
 
-std::string base64_encode(const std::uint8_t* buffer, size_t size)
+// Writes exactly base64_size(size) characters to out.
+static void base64_encode(const std::uint8_t* buffer, size_t size, char* out)
 {
-  std::string encoded_string;
-  encoded_string.reserve(((size / 3) + (size % 3 > 0)) * 4);
   std::uint32_t temp{};
-  int index = 0;
+  size_t index = 0;
   for (size_t idx = 0; idx < size / 3; idx++)
   {
     temp = buffer[index++] << 16;  // Convert to big endian
     temp += buffer[index++] << 8;
     temp += buffer[index++];
-    encoded_string.append(1, encode_lookup[(temp & 0x00FC0000) >> 18]);
-    encoded_string.append(1, encode_lookup[(temp & 0x0003F000) >> 12]);
-    encoded_string.append(1, encode_lookup[(temp & 0x00000FC0) >> 6]);
-    encoded_string.append(1, encode_lookup[(temp & 0x0000003F)]);
+    *out++ = encode_lookup[(temp & 0x00FC0000) >> 18];
+    *out++ = encode_lookup[(temp & 0x0003F000) >> 12];
+    *out++ = encode_lookup[(temp & 0x00000FC0) >> 6];
+    *out++ = encode_lookup[(temp & 0x0000003F)];
   }
   switch (size % 3)
   {
     case 1:
       temp = buffer[index++] << 16;  // Convert to big endian
-      encoded_string.append(1, encode_lookup[(temp & 0x00FC0000) >> 18]);
-      encoded_string.append(1, encode_lookup[(temp & 0x0003F000) >> 12]);
-      encoded_string.append(2, pad_character);
+      *out++ = encode_lookup[(temp & 0x00FC0000) >> 18];
+      *out++ = encode_lookup[(temp & 0x0003F000) >> 12];
+      *out++ = pad_character;
+      *out++ = pad_character;
       break;
     case 2:
       temp = buffer[index++] << 16;  // Convert to big endian
       temp += buffer[index++] << 8;
-      encoded_string.append(1, encode_lookup[(temp & 0x00FC0000) >> 18]);
-      encoded_string.append(1, encode_lookup[(temp & 0x0003F000) >> 12]);
-      encoded_string.append(1, encode_lookup[(temp & 0x00000FC0) >> 6]);
-      encoded_string.append(1, pad_character);
+      *out++ = encode_lookup[(temp & 0x00FC0000) >> 18];
+      *out++ = encode_lookup[(temp & 0x0003F000) >> 12];
+      *out++ = encode_lookup[(temp & 0x00000FC0) >> 6];
+      *out++ = pad_character;
       break;
   }
+}
+
+size_t base64_size(size_t size)
+{
+  return ((size / 3) + (size % 3 > 0)) * 4;
+}
+
+std::string base64_encode(const std::uint8_t* buffer, size_t size)
+{
+  std::string encoded_string(base64_size(size), '\0');
+  base64_encode(buffer, size, &encoded_string[0]);
   return encoded_string;
 }
 
+void base64_encode(const std::uint8_t* buffer, size_t size, byte_sink* out)
+{
+  // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+  base64_encode(buffer, size, reinterpret_cast<char*>(out->extend(base64_size(size))));
+}
+
 static void png_memory_write(png_structp png_ptr, png_bytep data, png_size_t length)
 {
   std::vector<uint8_t>* p = (std::vector<uint8_t>*)png_get_io_ptr(png_ptr);
@@ -3,11 +3,15 @@
 
 #include <cstdint>
 
+#include "byte_sink.h"
 #include "draw_data.h"
 
 namespace unigd
 {
+size_t base64_size(size_t size);
 std::string base64_encode(const std::uint8_t* buffer, size_t size);
+// Appends the encoded buffer to out.
+void base64_encode(const std::uint8_t* buffer, size_t size, byte_sink* out);
 std::string raster_base64(const renderers::Raster& t_raster);
 
 }  // namespace unigd
@@ -0,0 +1,134 @@
+#ifndef __UNIGD_BYTE_SINK_H__
+#define __UNIGD_BYTE_SINK_H__
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <memory>
+
+namespace unigd
+{
+// Receives output chunks, returns false to stop the output.
+using chunk_fn = std::function<bool(const uint8_t*, std::size_t)>;
+
+// Output buffer of the binary renderers.
+//
+// Encoders (Cairo and libtiff write callbacks, base64, gzip) write their chunks straight
+// into the sink, and clients get a pointer to the finished bytes. The sink is the only
+// place the finished output exists, so it is never copied as a whole. The bytes that
+// are moved when the sink has to grow are counted (see total_copied()), renderers that
+// know the rough size of their output reserve it up front.
+//
+// A sink can also forward its output (see forward()), then it never holds much more
+// than one chunk and the output does not exist as a whole at all.
+class byte_sink
+{
+ public:
+  byte_sink() = default;
+
+  byte_sink(const byte_sink&) = delete;
+  byte_sink& operator=(const byte_sink&) = delete;
+
+  void reserve(std::size_t t_capacity)
+  {
+    m_grow(m_forward ? std::min(t_capacity, m_chunk_size) : t_capacity);
+  }
+
+  // Hands the output to t_forward in chunks of t_chunk_size bytes as soon as they are
+  // written instead of keeping it. An empty function keeps the output again.
+  void forward(chunk_fn t_forward, std::size_t t_chunk_size)
+  {
+    m_forward = std::move(t_forward);
+    m_chunk_size = t_chunk_size;
+    m_stopped = false;
+  }
+
+  // Hands the bytes not forwarded yet to the chunk function. Returns false if the chunk
+  // function stopped the output, everything written after that is dropped.
+  bool flush()
+  {
+    if (!m_forward)
+    {
+      return true;
+    }
+    for (std::size_t pos = 0; !m_stopped && pos < m_size; pos += m_chunk_size)
+    {
+      m_stopped = !m_forward(m_data.get() + pos, std::min(m_chunk_size, m_size - pos));
+    }
+    m_size = 0;
+    return !m_stopped;
+  }
+
+  bool stopped() const { return m_stopped; }
+
+  // Room for t_size more bytes at the end, which count as written.
+  uint8_t* extend(std::size_t t_size)
+  {
+    if (m_size + t_size > m_capacity)
+    {
+      m_grow(std::max(m_size + t_size, 2 * m_capacity));
+    }
+    uint8_t* end = m_data.get() + m_size;
+    m_size += t_size;
+    return end;
+  }
+
+  // Keeps the first t_size bytes (e.g. to drop the unused part of extend()).
+  void truncate(std::size_t t_size) { m_size = std::min(m_size, t_size); }
+
+  void append(const void* t_data, std::size_t t_size)
+  {
+    if (t_size == 0 || m_stopped)
+    {
+      return;
+    }
+    std::memcpy(extend(t_size), t_data, t_size);
+    if (m_forward && m_size >= m_chunk_size)
+    {
+      flush();
+    }
+  }
+
+  void clear() { m_size = 0; }
+
+  uint8_t* data() { return m_data.get(); }
+  const uint8_t* data() const { return m_data.get(); }
+  std::size_t size() const { return m_size; }
+  std::size_t capacity() const { return m_capacity; }
+
+  // Bytes moved by all sinks because they had to grow.
+  static uint64_t total_copied() { return s_copied.load(std::memory_order_relaxed); }
+
+ private:
+  std::unique_ptr<uint8_t[]> m_data;
+  std::size_t m_size = 0;
+  std::size_t m_capacity = 0;
+  chunk_fn m_forward;
+  std::size_t m_chunk_size = 0;
+  bool m_stopped = false;
+
+  inline static std::atomic<uint64_t> s_copied{0};
+
+  void m_grow(std::size_t t_capacity)
+  {
+    if (t_capacity <= m_capacity)
+    {
+      return;
+    }
+    std::unique_ptr<uint8_t[]> data(new uint8_t[t_capacity]);
+    if (m_size != 0)
+    {
+      std::memcpy(data.get(), m_data.get(), m_size);
+      s_copied += m_size;
+    }
+    m_data = std::move(data);
+    m_capacity = t_capacity;
+  }
+};
+
+}  // namespace unigd
+
+#endif /* __UNIGD_BYTE_SINK_H__ */
@@ -1,5 +1,6 @@
 #include "compress.h"
 
+#include <algorithm>
 #include <string>
 #include <vector>
 #include <zlib.h>
@@ -55,9 +56,46 @@ inline std::vector<charTypeOut> compressToGzip(const charTypeIn* input, size_t i
   return buffer;
 }
 
-std::vector<uint8_t> compress(const uint8_t* input, size_t input_size)
+bool compress(const uint8_t* input, size_t input_size, byte_sink* out)
 {
-  return compressToGzip<uint8_t, uint8_t>(input, input_size);
+  z_stream zs;
+  zs.zalloc = Z_NULL;
+  zs.zfree = Z_NULL;
+  zs.opaque = Z_NULL;
+  zs.avail_in = static_cast<uInt>(input_size);
+  zs.next_in = const_cast<Bytef*>(input);
+
+  int ret = deflateInit2(&zs, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 | 16, 8,
+                         Z_DEFAULT_STRATEGY);
+  if (ret != Z_OK)
+  {
+    return false;
+  }
+
+  // Plots compress well, start with a quarter of the input and grow from there.
+  const size_t start = out->size();
+  out->reserve(start + input_size / 4 + 64);
+  for (;;)
+  {
+    const size_t chunk_size = std::min<size_t>(
+        std::max<size_t>(out->capacity() - out->size(), 16384), 1 << 30);
+    zs.avail_out = static_cast<uInt>(chunk_size);
+    zs.next_out = out->extend(chunk_size);
+    ret = deflate(&zs, Z_FINISH);
+    out->truncate(out->size() - zs.avail_out);
+    if (ret == Z_STREAM_ERROR)
+    {
+      deflateEnd(&zs);
+      out->truncate(start);
+      return false;
+    }
+    if (zs.avail_out != 0)
+    {
+      break;
+    }
+  }
+  deflateEnd(&zs);
+  return true;
 }
 
 std::vector<unsigned char> compress_str(const std::string& s)
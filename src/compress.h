@@ -5,11 +5,14 @@
 #include <string>
 #include <vector>
 
+#include "byte_sink.h"
+
 namespace unigd
 {
 namespace compr
 {
-std::vector<uint8_t> compress(const uint8_t* input, size_t input_size);
+// Appends the gzip compressed input to out.
+bool compress(const uint8_t* input, size_t input_size, byte_sink* out);
 
 std::vector<unsigned char> compress_str(const std::string& s);
 
@@ -6,10 +6,10 @@
 #include <R_ext/Visibility.h>
 
 // unigd.cpp
-int unigd_ugd_(std::string bg, double width, double height, double pointsize, cpp11::list aliases, bool reset_par);
-extern "C" SEXP _unigd_unigd_ugd_(SEXP bg, SEXP width, SEXP height, SEXP pointsize, SEXP aliases, SEXP reset_par) {
+int unigd_ugd_(std::string bg, double width, double height, double pointsize, cpp11::list aliases, bool reset_par, double cache_size, double memory_limit, std::string spill_dir, bool primitive_runs, int raster_threads, double notify_window);
+extern "C" SEXP _unigd_unigd_ugd_(SEXP bg, SEXP width, SEXP height, SEXP pointsize, SEXP aliases, SEXP reset_par, SEXP cache_size, SEXP memory_limit, SEXP spill_dir, SEXP primitive_runs, SEXP raster_threads, SEXP notify_window) {
   BEGIN_CPP11
-    return cpp11::as_sexp(unigd_ugd_(cpp11::as_cpp<cpp11::decay_t<std::string>>(bg), cpp11::as_cpp<cpp11::decay_t<double>>(width), cpp11::as_cpp<cpp11::decay_t<double>>(height), cpp11::as_cpp<cpp11::decay_t<double>>(pointsize), cpp11::as_cpp<cpp11::decay_t<cpp11::list>>(aliases), cpp11::as_cpp<cpp11::decay_t<bool>>(reset_par)));
+    return cpp11::as_sexp(unigd_ugd_(cpp11::as_cpp<cpp11::decay_t<std::string>>(bg), cpp11::as_cpp<cpp11::decay_t<double>>(width), cpp11::as_cpp<cpp11::decay_t<double>>(height), cpp11::as_cpp<cpp11::decay_t<double>>(pointsize), cpp11::as_cpp<cpp11::decay_t<cpp11::list>>(aliases), cpp11::as_cpp<cpp11::decay_t<bool>>(reset_par), cpp11::as_cpp<cpp11::decay_t<double>>(cache_size), cpp11::as_cpp<cpp11::decay_t<double>>(memory_limit), cpp11::as_cpp<cpp11::decay_t<std::string>>(spill_dir), cpp11::as_cpp<cpp11::decay_t<bool>>(primitive_runs), cpp11::as_cpp<cpp11::decay_t<int>>(raster_threads), cpp11::as_cpp<cpp11::decay_t<double>>(notify_window)));
   END_CPP11
 }
 // unigd.cpp
@@ -41,10 +41,80 @@ extern "C" SEXP _unigd_unigd_plot_find_(SEXP devnum, SEXP plot_id) {
   END_CPP11
 }
 // unigd.cpp
-SEXP unigd_render_(int devnum, int page, double width, double height, double zoom, std::string renderer_id);
-extern "C" SEXP _unigd_unigd_render_(SEXP devnum, SEXP page, SEXP width, SEXP height, SEXP zoom, SEXP renderer_id) {
+SEXP unigd_render_(int devnum, int page, double width, double height, double zoom, std::string renderer_id, double lod, cpp11::doubles region);
+extern "C" SEXP _unigd_unigd_render_(SEXP devnum, SEXP page, SEXP width, SEXP height, SEXP zoom, SEXP renderer_id, SEXP lod, SEXP region) {
   BEGIN_CPP11
-    return cpp11::as_sexp(unigd_render_(cpp11::as_cpp<cpp11::decay_t<int>>(devnum), cpp11::as_cpp<cpp11::decay_t<int>>(page), cpp11::as_cpp<cpp11::decay_t<double>>(width), cpp11::as_cpp<cpp11::decay_t<double>>(height), cpp11::as_cpp<cpp11::decay_t<double>>(zoom), cpp11::as_cpp<cpp11::decay_t<std::string>>(renderer_id)));
+    return cpp11::as_sexp(unigd_render_(cpp11::as_cpp<cpp11::decay_t<int>>(devnum), cpp11::as_cpp<cpp11::decay_t<int>>(page), cpp11::as_cpp<cpp11::decay_t<double>>(width), cpp11::as_cpp<cpp11::decay_t<double>>(height), cpp11::as_cpp<cpp11::decay_t<double>>(zoom), cpp11::as_cpp<cpp11::decay_t<std::string>>(renderer_id), cpp11::as_cpp<cpp11::decay_t<double>>(lod), cpp11::as_cpp<cpp11::decay_t<cpp11::doubles>>(region)));
+  END_CPP11
+}
+// unigd.cpp
+cpp11::list unigd_render_batch_(int devnum, cpp11::integers page, cpp11::doubles width, cpp11::doubles height, cpp11::doubles zoom, cpp11::strings renderer_id);
+extern "C" SEXP _unigd_unigd_render_batch_(SEXP devnum, SEXP page, SEXP width, SEXP height, SEXP zoom, SEXP renderer_id) {
+  BEGIN_CPP11
+    return cpp11::as_sexp(unigd_render_batch_(cpp11::as_cpp<cpp11::decay_t<int>>(devnum), cpp11::as_cpp<cpp11::decay_t<cpp11::integers>>(page), cpp11::as_cpp<cpp11::decay_t<cpp11::doubles>>(width), cpp11::as_cpp<cpp11::decay_t<cpp11::doubles>>(height), cpp11::as_cpp<cpp11::decay_t<cpp11::doubles>>(zoom), cpp11::as_cpp<cpp11::decay_t<cpp11::strings>>(renderer_id)));
+  END_CPP11
+}
+// unigd.cpp
+cpp11::list unigd_delta_(int devnum, int plot_id, double sequence);
+extern "C" SEXP _unigd_unigd_delta_(SEXP devnum, SEXP plot_id, SEXP sequence) {
+  BEGIN_CPP11
+    return cpp11::as_sexp(unigd_delta_(cpp11::as_cpp<cpp11::decay_t<int>>(devnum), cpp11::as_cpp<cpp11::decay_t<int>>(plot_id), cpp11::as_cpp<cpp11::decay_t<double>>(sequence)));
+  END_CPP11
+}
+// unigd.cpp
+cpp11::writable::raws unigd_delta_apply_(cpp11::raws page, cpp11::raws delta);
+extern "C" SEXP _unigd_unigd_delta_apply_(SEXP page, SEXP delta) {
+  BEGIN_CPP11
+    return cpp11::as_sexp(unigd_delta_apply_(cpp11::as_cpp<cpp11::decay_t<cpp11::raws>>(page), cpp11::as_cpp<cpp11::decay_t<cpp11::raws>>(delta)));
+  END_CPP11
+}
+// unigd.cpp
+cpp11::integers unigd_hit_test_(int devnum, int plot_id, double x, double y, double width, double height);
+extern "C" SEXP _unigd_unigd_hit_test_(SEXP devnum, SEXP plot_id, SEXP x, SEXP y, SEXP width, SEXP height) {
+  BEGIN_CPP11
+    return cpp11::as_sexp(unigd_hit_test_(cpp11::as_cpp<cpp11::decay_t<int>>(devnum), cpp11::as_cpp<cpp11::decay_t<int>>(plot_id), cpp11::as_cpp<cpp11::decay_t<double>>(x), cpp11::as_cpp<cpp11::decay_t<double>>(y), cpp11::as_cpp<cpp11::decay_t<double>>(width), cpp11::as_cpp<cpp11::decay_t<double>>(height)));
+  END_CPP11
+}
+// unigd.cpp
+cpp11::list unigd_render_tiles_(int devnum, int plot_id, std::string renderer_id, int zoom, cpp11::integers x, cpp11::integers y, int tile_size);
+extern "C" SEXP _unigd_unigd_render_tiles_(SEXP devnum, SEXP plot_id, SEXP renderer_id, SEXP zoom, SEXP x, SEXP y, SEXP tile_size) {
+  BEGIN_CPP11
+    return cpp11::as_sexp(unigd_render_tiles_(cpp11::as_cpp<cpp11::decay_t<int>>(devnum), cpp11::as_cpp<cpp11::decay_t<int>>(plot_id), cpp11::as_cpp<cpp11::decay_t<std::string>>(renderer_id), cpp11::as_cpp<cpp11::decay_t<int>>(zoom), cpp11::as_cpp<cpp11::decay_t<cpp11::integers>>(x), cpp11::as_cpp<cpp11::decay_t<cpp11::integers>>(y), cpp11::as_cpp<cpp11::decay_t<int>>(tile_size)));
+  END_CPP11
+}
+// unigd.cpp
+cpp11::list unigd_render_concurrent_(int devnum, int plot_id, std::string renderer_id, int threads, int iterations);
+extern "C" SEXP _unigd_unigd_render_concurrent_(SEXP devnum, SEXP plot_id, SEXP renderer_id, SEXP threads, SEXP iterations) {
+  BEGIN_CPP11
+    return cpp11::as_sexp(unigd_render_concurrent_(cpp11::as_cpp<cpp11::decay_t<int>>(devnum), cpp11::as_cpp<cpp11::decay_t<int>>(plot_id), cpp11::as_cpp<cpp11::decay_t<std::string>>(renderer_id), cpp11::as_cpp<cpp11::decay_t<int>>(threads), cpp11::as_cpp<cpp11::decay_t<int>>(iterations)));
+  END_CPP11
+}
+// unigd.cpp
+cpp11::list unigd_render_sizes_(int devnum, int plot_id, std::string renderer_id, cpp11::doubles widths, cpp11::doubles heights, int iterations);
+extern "C" SEXP _unigd_unigd_render_sizes_(SEXP devnum, SEXP plot_id, SEXP renderer_id, SEXP widths, SEXP heights, SEXP iterations) {
+  BEGIN_CPP11
+    return cpp11::as_sexp(unigd_render_sizes_(cpp11::as_cpp<cpp11::decay_t<int>>(devnum), cpp11::as_cpp<cpp11::decay_t<int>>(plot_id), cpp11::as_cpp<cpp11::decay_t<std::string>>(renderer_id), cpp11::as_cpp<cpp11::decay_t<cpp11::doubles>>(widths), cpp11::as_cpp<cpp11::decay_t<cpp11::doubles>>(heights), cpp11::as_cpp<cpp11::decay_t<int>>(iterations)));
+  END_CPP11
+}
+// unigd.cpp
+cpp11::list unigd_render_async_(int devnum, int plot_id, std::string renderer_id, int count, bool cancel);
+extern "C" SEXP _unigd_unigd_render_async_(SEXP devnum, SEXP plot_id, SEXP renderer_id, SEXP count, SEXP cancel) {
+  BEGIN_CPP11
+    return cpp11::as_sexp(unigd_render_async_(cpp11::as_cpp<cpp11::decay_t<int>>(devnum), cpp11::as_cpp<cpp11::decay_t<int>>(plot_id), cpp11::as_cpp<cpp11::decay_t<std::string>>(renderer_id), cpp11::as_cpp<cpp11::decay_t<int>>(count), cpp11::as_cpp<cpp11::decay_t<bool>>(cancel)));
+  END_CPP11
+}
+// unigd.cpp
+cpp11::list unigd_render_stream_(int devnum, int plot_id, std::string renderer_id, int limit);
+extern "C" SEXP _unigd_unigd_render_stream_(SEXP devnum, SEXP plot_id, SEXP renderer_id, SEXP limit) {
+  BEGIN_CPP11
+    return cpp11::as_sexp(unigd_render_stream_(cpp11::as_cpp<cpp11::decay_t<int>>(devnum), cpp11::as_cpp<cpp11::decay_t<int>>(plot_id), cpp11::as_cpp<cpp11::decay_t<std::string>>(renderer_id), cpp11::as_cpp<cpp11::decay_t<int>>(limit)));
+  END_CPP11
+}
+// unigd.cpp
+cpp11::list unigd_render_into_(int devnum, int plot_id, std::string renderer_id, double capacity, bool grow);
+extern "C" SEXP _unigd_unigd_render_into_(SEXP devnum, SEXP plot_id, SEXP renderer_id, SEXP capacity, SEXP grow) {
+  BEGIN_CPP11
+    return cpp11::as_sexp(unigd_render_into_(cpp11::as_cpp<cpp11::decay_t<int>>(devnum), cpp11::as_cpp<cpp11::decay_t<int>>(plot_id), cpp11::as_cpp<cpp11::decay_t<std::string>>(renderer_id), cpp11::as_cpp<cpp11::decay_t<double>>(capacity), cpp11::as_cpp<cpp11::decay_t<bool>>(grow)));
   END_CPP11
 }
 // unigd.cpp
@@ -91,21 +161,47 @@ extern "C" SEXP _unigd_unigd_ipc_close_() {
     return R_NilValue;
   END_CPP11
 }
+// unigd.cpp
+cpp11::data_frame unigd_bench_writer_(int iterations);
+extern "C" SEXP _unigd_unigd_bench_writer_(SEXP iterations) {
+  BEGIN_CPP11
+    return cpp11::as_sexp(unigd_bench_writer_(cpp11::as_cpp<cpp11::decay_t<int>>(iterations)));
+  END_CPP11
+}
+// unigd.cpp
+double unigd_copied_bytes_();
+extern "C" SEXP _unigd_unigd_copied_bytes_() {
+  BEGIN_CPP11
+    return cpp11::as_sexp(unigd_copied_bytes_());
+  END_CPP11
+}
 
 extern "C" {
 static const R_CallMethodDef CallEntries[] = {
-    {"_unigd_unigd_clear_",     (DL_FUNC) &_unigd_unigd_clear_,     1},
-    {"_unigd_unigd_id_",        (DL_FUNC) &_unigd_unigd_id_,        3},
-    {"_unigd_unigd_info_",      (DL_FUNC) &_unigd_unigd_info_,      1},
-    {"_unigd_unigd_ipc_close_", (DL_FUNC) &_unigd_unigd_ipc_close_, 0},
-    {"_unigd_unigd_ipc_open_",  (DL_FUNC) &_unigd_unigd_ipc_open_,  0},
-    {"_unigd_unigd_plot_find_", (DL_FUNC) &_unigd_unigd_plot_find_, 2},
-    {"_unigd_unigd_remove_",    (DL_FUNC) &_unigd_unigd_remove_,    2},
-    {"_unigd_unigd_remove_id_", (DL_FUNC) &_unigd_unigd_remove_id_, 2},
-    {"_unigd_unigd_render_",    (DL_FUNC) &_unigd_unigd_render_,    6},
-    {"_unigd_unigd_renderers_", (DL_FUNC) &_unigd_unigd_renderers_, 0},
-    {"_unigd_unigd_state_",     (DL_FUNC) &_unigd_unigd_state_,     1},
-    {"_unigd_unigd_ugd_",       (DL_FUNC) &_unigd_unigd_ugd_,       6},
+    {"_unigd_unigd_bench_writer_",      (DL_FUNC) &_unigd_unigd_bench_writer_,      1},
+    {"_unigd_unigd_clear_",             (DL_FUNC) &_unigd_unigd_clear_,             1},
+    {"_unigd_unigd_copied_bytes_",      (DL_FUNC) &_unigd_unigd_copied_bytes_,      0},
+    {"_unigd_unigd_delta_",             (DL_FUNC) &_unigd_unigd_delta_,             3},
+    {"_unigd_unigd_delta_apply_",       (DL_FUNC) &_unigd_unigd_delta_apply_,       2},
+    {"_unigd_unigd_hit_test_",          (DL_FUNC) &_unigd_unigd_hit_test_,          6},
+    {"_unigd_unigd_id_",                (DL_FUNC) &_unigd_unigd_id_,                3},
+    {"_unigd_unigd_info_",              (DL_FUNC) &_unigd_unigd_info_,              1},
+    {"_unigd_unigd_ipc_close_",         (DL_FUNC) &_unigd_unigd_ipc_close_,         0},
+    {"_unigd_unigd_ipc_open_",          (DL_FUNC) &_unigd_unigd_ipc_open_,          0},
+    {"_unigd_unigd_plot_find_",         (DL_FUNC) &_unigd_unigd_plot_find_,         2},
+    {"_unigd_unigd_remove_",            (DL_FUNC) &_unigd_unigd_remove_,            2},
+    {"_unigd_unigd_remove_id_",         (DL_FUNC) &_unigd_unigd_remove_id_,         2},
+    {"_unigd_unigd_render_",            (DL_FUNC) &_unigd_unigd_render_,            8},
+    {"_unigd_unigd_render_async_",      (DL_FUNC) &_unigd_unigd_render_async_,      5},
+    {"_unigd_unigd_render_batch_",      (DL_FUNC) &_unigd_unigd_render_batch_,      6},
+    {"_unigd_unigd_render_concurrent_", (DL_FUNC) &_unigd_unigd_render_concurrent_, 5},
+    {"_unigd_unigd_render_into_",       (DL_FUNC) &_unigd_unigd_render_into_,       5},
+    {"_unigd_unigd_render_sizes_",      (DL_FUNC) &_unigd_unigd_render_sizes_,      6},
+    {"_unigd_unigd_render_stream_",     (DL_FUNC) &_unigd_unigd_render_stream_,     4},
+    {"_unigd_unigd_render_tiles_",      (DL_FUNC) &_unigd_unigd_render_tiles_,      7},
+    {"_unigd_unigd_renderers_",         (DL_FUNC) &_unigd_unigd_renderers_,         0},
+    {"_unigd_unigd_state_",             (DL_FUNC) &_unigd_unigd_state_,             1},
+    {"_unigd_unigd_ugd_",               (DL_FUNC) &_unigd_unigd_ugd_,               12},
     {NULL, NULL, 0}
 };
 }
@@ -1,6 +1,8 @@
 #include "draw_data.h"
 
-#include <iterator>
+#include <algorithm>
+#include <cmath>
+#include <utility>
 
 namespace unigd
 {
@@ -8,49 +10,139 @@ namespace renderers
 {
 
 Text::Text(color_t t_col, gvertex<double> t_pos, std::string&& t_str, double t_rot,
-           double t_hadj, TextInfo&& t_text)
-    : col(t_col), pos(t_pos), rot(t_rot), hadj(t_hadj), str(t_str), text(t_text)
+           double t_hadj, style_id_t t_text, double t_txtwidth_px)
+    : col(t_col),
+      pos(t_pos),
+      rot(t_rot),
+      hadj(t_hadj),
+      str(std::move(t_str)),
+      text(t_text),
+      txtwidth_px(t_txtwidth_px)
 {
 }
 
-Circle::Circle(LineInfo&& t_line, color_t t_fill, gvertex<double> t_pos, double t_radius)
+Circle::Circle(style_id_t t_line, color_t t_fill, gvertex<double> t_pos, double t_radius)
     : line(t_line), fill(t_fill), pos(t_pos), radius(t_radius)
 {
 }
 
-Line::Line(LineInfo&& t_line, gvertex<double> t_orig, gvertex<double> t_dest)
+Line::Line(style_id_t t_line, gvertex<double> t_orig, gvertex<double> t_dest)
     : line(t_line), orig(t_orig), dest(t_dest)
 {
 }
 
-Rect::Rect(LineInfo&& t_line, color_t t_fill, grect<double> t_rect)
+Rect::Rect(style_id_t t_line, color_t t_fill, grect<double> t_rect)
     : line(t_line), fill(t_fill), rect(t_rect)
 {
 }
 
-Polyline::Polyline(LineInfo&& t_line, std::vector<gvertex<double>>&& t_points)
-    : line(t_line), points(t_points)
+Polyline::Polyline(style_id_t t_line, std::vector<gvertex<double>>&& t_points)
+    : line(t_line), points(std::move(t_points))
 {
 }
 
-Polygon::Polygon(LineInfo&& t_line, color_t t_fill,
+Polygon::Polygon(style_id_t t_line, color_t t_fill,
                  std::vector<gvertex<double>>&& t_points)
-    : line(t_line), fill(t_fill), points(t_points)
+    : line(t_line), fill(t_fill), points(std::move(t_points))
 {
 }
 
-Path::Path(LineInfo&& t_line, color_t t_fill, std::vector<gvertex<double>>&& t_points,
+Path::Path(style_id_t t_line, color_t t_fill, std::vector<gvertex<double>>&& t_points,
            std::vector<int>&& t_nper, bool t_winding)
-    : line(t_line), fill(t_fill), points(t_points), nper(t_nper), winding(t_winding)
+    : line(t_line),
+      fill(t_fill),
+      points(std::move(t_points)),
+      nper(std::move(t_nper)),
+      winding(t_winding)
 {
 }
 
 Raster::Raster(std::vector<unsigned int>&& t_raster, gvertex<int> t_wh,
                grect<double> t_rect, double t_rot, bool t_interpolate)
-    : raster(t_raster), wh(t_wh), rect(t_rect), rot(t_rot), interpolate(t_interpolate)
+    : raster(std::move(t_raster)),
+      wh(t_wh),
+      rect(t_rect),
+      rot(t_rot),
+      interpolate(t_interpolate)
 {
 }
 
+std::size_t Text::mem_size() const
+{
+  return sizeof(*this) + str.capacity();
+}
+
+std::size_t Circle::mem_size() const
+{
+  return sizeof(*this);
+}
+
+std::size_t Line::mem_size() const
+{
+  return sizeof(*this);
+}
+
+std::size_t Rect::mem_size() const
+{
+  return sizeof(*this);
+}
+
+std::size_t Polyline::mem_size() const
+{
+  return sizeof(*this) + points.capacity() * sizeof(gvertex<double>);
+}
+
+std::size_t Polygon::mem_size() const
+{
+  return sizeof(*this) + points.capacity() * sizeof(gvertex<double>);
+}
+
+std::size_t Path::mem_size() const
+{
+  return sizeof(*this) + points.capacity() * sizeof(gvertex<double>) +
+         nper.capacity() * sizeof(int);
+}
+
+std::size_t Raster::mem_size() const
+{
+  return sizeof(*this) + raster.capacity() * sizeof(unsigned int);
+}
+
+void Text::remap_styles(const style_remap& t_map)
+{
+  text = t_map.texts[text];
+}
+
+void Circle::remap_styles(const style_remap& t_map)
+{
+  line = t_map.lines[line];
+}
+
+void Line::remap_styles(const style_remap& t_map)
+{
+  line = t_map.lines[line];
+}
+
+void Rect::remap_styles(const style_remap& t_map)
+{
+  line = t_map.lines[line];
+}
+
+void Polyline::remap_styles(const style_remap& t_map)
+{
+  line = t_map.lines[line];
+}
+
+void Polygon::remap_styles(const style_remap& t_map)
+{
+  line = t_map.lines[line];
+}
+
+void Path::remap_styles(const style_remap& t_map)
+{
+  line = t_map.lines[line];
+}
+
 void Text::visit(draw_call_visitor* t_visitor) const
 {
   t_visitor->visit(this);
@@ -91,34 +183,590 @@ void Raster::visit(draw_call_visitor* t_visitor) const
   t_visitor->visit(this);
 }
 
+namespace
+{
+inline void hash_combine(std::size_t* t_seed, std::size_t t_value)
+{
+  *t_seed ^= t_value + 0x9e3779b9 + (*t_seed << 6) + (*t_seed >> 2);
+}
+
+std::size_t style_hash(const LineInfo& t_line)
+{
+  std::size_t seed = std::hash<color_t>()(t_line.col);
+  hash_combine(&seed, std::hash<double>()(t_line.lwd));
+  hash_combine(&seed, std::hash<int>()(t_line.lty));
+  hash_combine(&seed, std::hash<int>()(t_line.lend));
+  hash_combine(&seed, std::hash<int>()(t_line.ljoin));
+  hash_combine(&seed, std::hash<double>()(t_line.lmitre));
+  return seed;
+}
+
+std::size_t style_hash(const TextInfo& t_text)
+{
+  std::size_t seed = std::hash<int>()(t_text.weight);
+  hash_combine(&seed, std::hash<std::string>()(t_text.features));
+  hash_combine(&seed, std::hash<std::string>()(t_text.font_family));
+  hash_combine(&seed, std::hash<double>()(t_text.fontsize));
+  hash_combine(&seed, std::hash<bool>()(t_text.italic));
+  return seed;
+}
+
+bool same_style(const LineInfo& t_a, const LineInfo& t_b)
+{
+  return t_a.col == t_b.col && t_a.lwd == t_b.lwd && t_a.lty == t_b.lty &&
+         t_a.lend == t_b.lend && t_a.ljoin == t_b.ljoin && t_a.lmitre == t_b.lmitre;
+}
+
+bool same_style(const TextInfo& t_a, const TextInfo& t_b)
+{
+  return t_a.weight == t_b.weight && t_a.fontsize == t_b.fontsize &&
+         t_a.italic == t_b.italic && t_a.features == t_b.features &&
+         t_a.font_family == t_b.font_family;
+}
+
+bool same_style(style_id_t t_a, style_id_t t_b)
+{
+  return t_a == t_b;
+}
+
+bool same_style(const ShapeStyle& t_a, const ShapeStyle& t_b)
+{
+  return t_a.line == t_b.line && t_a.fill == t_b.fill;
+}
+
+template <class S>
+style_id_t intern_into(std::vector<S>* t_styles,
+                       std::unordered_multimap<std::size_t, style_id_t>* t_ids,
+                       const S& t_style)
+{
+  const auto hash = style_hash(t_style);
+  const auto range = t_ids->equal_range(hash);
+  for (auto it = range.first; it != range.second; ++it)
+  {
+    if (same_style((*t_styles)[it->second], t_style))
+    {
+      return it->second;
+    }
+  }
+  const auto id = static_cast<style_id_t>(t_styles->size());
+  t_styles->push_back(t_style);
+  t_ids->emplace(hash, id);
+  return id;
+}
+
+// Index of the style in the table of a run. Only the most recently added styles are
+// searched, which keeps appending cheap for plots that color every point differently.
+template <class S>
+uint32_t intern_style(std::vector<S>* t_styles, const S& t_style)
+{
+  constexpr std::size_t search_depth = 8;
+  const std::size_t n = t_styles->size();
+  for (std::size_t i = n; i > 0 && n - i < search_depth; --i)
+  {
+    if (same_style((*t_styles)[i - 1], t_style))
+    {
+      return static_cast<uint32_t>(i - 1);
+    }
+  }
+  t_styles->push_back(t_style);
+  return static_cast<uint32_t>(n);
+}
+
+template <class T, class R>
+void append_to_run(draw_call_list* t_dcs, T&& t_dc)
+{
+  if (!t_dcs->empty())
+  {
+    if (auto* run = dynamic_cast<R*>(t_dcs->back()))
+    {
+      run->push_back(t_dc);
+      return;
+    }
+    if (const auto* prev = dynamic_cast<const T*>(t_dcs->back()))
+    {
+      const T first = *prev;
+      t_dcs->pop_back();
+      t_dcs->template emplace<R>(first)->push_back(t_dc);
+      return;
+    }
+  }
+  t_dcs->template emplace<T>(std::move(t_dc));
+}
+
+// How far the stroke of a line style may reach beyond the geometry: half the line width
+// (1 lwd = 1/96", page units are 1/72"), with room for square caps and mitre joins.
+double stroke_margin(const style_table& t_styles, style_id_t t_line)
+{
+  const auto& line = t_styles.line(t_line);
+  return line.lwd / 96.0 * 72 / 2 * std::max(line.lmitre, 1.5);
+}
+
+grect<double> expand(grect<double> t_rect, double t_margin)
+{
+  return {t_rect.x - t_margin, t_rect.y - t_margin, t_rect.width + 2 * t_margin,
+          t_rect.height + 2 * t_margin};
+}
+
+grect<double> circle_bounds(gvertex<double> t_pos, double t_radius, double t_margin)
+{
+  return expand({t_pos.x, t_pos.y, 0, 0}, std::fabs(t_radius) + t_margin);
+}
+
+grect<double> line_bounds(gvertex<double> t_orig, gvertex<double> t_dest,
+                          double t_margin)
+{
+  return expand(normalize_rect(t_orig.x, t_orig.y, t_dest.x, t_dest.y), t_margin);
+}
+
+grect<double> points_bounds(const std::vector<gvertex<double>>& t_points,
+                            double t_margin)
+{
+  if (t_points.empty())
+  {
+    return {0, 0, -1, -1};  // intersects nothing
+  }
+  gvertex<double> lo = t_points.front();
+  gvertex<double> hi = lo;
+  for (const auto& p : t_points)
+  {
+    lo = {std::min(lo.x, p.x), std::min(lo.y, p.y)};
+    hi = {std::max(hi.x, p.x), std::max(hi.y, p.y)};
+  }
+  return expand(normalize_rect(lo.x, lo.y, hi.x, hi.y), t_margin);
+}
+
+grect<double> unite(grect<double> t_a, grect<double> t_b)
+{
+  const double x0 = std::min(t_a.x, t_b.x);
+  const double y0 = std::min(t_a.y, t_b.y);
+  return {x0, y0, std::max(t_a.x + t_a.width, t_b.x + t_b.width) - x0,
+          std::max(t_a.y + t_a.height, t_b.y + t_b.height) - y0};
+}
+
+// Removes the elements i of all columns for which t_keep(i) is false.
+template <class F, class... Cols>
+std::size_t remove_elements(std::size_t t_size, F t_keep, Cols*... t_cols)
+{
+  std::size_t n = 0;
+  for (std::size_t i = 0; i != t_size; ++i)
+  {
+    if (t_keep(i))
+    {
+      if (n != i)
+      {
+        (((*t_cols)[n] = (*t_cols)[i]), ...);
+      }
+      n++;
+    }
+  }
+  (t_cols->resize(n), ...);
+  return t_size - n;
+}
+}  // namespace
+
+grect<double> Text::bounds(const style_table& t_styles) const
+{
+  // Any rotation and adjustment of the text stays within this distance of the anchor.
+  return expand({pos.x, pos.y, 0, 0},
+                std::fabs(txtwidth_px) + 2 * t_styles.text(text).fontsize);
+}
+
+grect<double> Circle::bounds(const style_table& t_styles) const
+{
+  return circle_bounds(pos, radius, stroke_margin(t_styles, line));
+}
+
+grect<double> Line::bounds(const style_table& t_styles) const
+{
+  return line_bounds(orig, dest, stroke_margin(t_styles, line));
+}
+
+grect<double> Rect::bounds(const style_table& t_styles) const
+{
+  return expand(rect, stroke_margin(t_styles, line));
+}
+
+grect<double> Polyline::bounds(const style_table& t_styles) const
+{
+  return points_bounds(points, stroke_margin(t_styles, line));
+}
+
+grect<double> Polygon::bounds(const style_table& t_styles) const
+{
+  return points_bounds(points, stroke_margin(t_styles, line));
+}
+
+grect<double> Path::bounds(const style_table& t_styles) const
+{
+  return points_bounds(points, stroke_margin(t_styles, line));
+}
+
+grect<double> Raster::bounds(const style_table& t_styles) const
+{
+  if (rot == 0)
+  {
+    return rect;
+  }
+  // Rotation is around a corner, so the image stays within its diagonal of the rect.
+  return expand(rect, std::fabs(rect.width) + std::fabs(rect.height));
+}
+
+style_id_t style_table::intern(const LineInfo& t_line)
+{
+  return intern_into(&m_lines, &m_line_ids, t_line);
+}
+
+style_id_t style_table::intern(const TextInfo& t_text)
+{
+  return intern_into(&m_texts, &m_text_ids, t_text);
+}
+
+void style_table::clear()
+{
+  m_lines.clear();
+  m_texts.clear();
+  m_line_ids.clear();
+  m_text_ids.clear();
+}
+
+std::size_t style_table::mem_size() const
+{
+  constexpr std::size_t id_entry_size = sizeof(std::size_t) + sizeof(style_id_t) + 16;
+  std::size_t size = m_lines.capacity() * sizeof(LineInfo) +
+                     m_texts.capacity() * sizeof(TextInfo) +
+                     (m_line_ids.size() + m_text_ids.size()) * id_entry_size;
+  for (const auto& text : m_texts)
+  {
+    size += text.features.capacity() + text.font_family.capacity();
+  }
+  return size;
+}
+
+void draw_call_visitor::visit(const CircleRun* t_run)
+{
+  for (std::size_t i = 0; i != t_run->size(); ++i)
+  {
+    if (i != 0)
+    {
+      run_separator();
+    }
+    const auto circle = t_run->at(i);
+    visit(&circle);
+  }
+}
+
+void draw_call_visitor::visit(const LineRun* t_run)
+{
+  for (std::size_t i = 0; i != t_run->size(); ++i)
+  {
+    if (i != 0)
+    {
+      run_separator();
+    }
+    const auto line = t_run->at(i);
+    visit(&line);
+  }
+}
+
+void draw_call_visitor::visit(const RectRun* t_run)
+{
+  for (std::size_t i = 0; i != t_run->size(); ++i)
+  {
+    if (i != 0)
+    {
+      run_separator();
+    }
+    const auto rect = t_run->at(i);
+    visit(&rect);
+  }
+}
+
+CircleRun::CircleRun(const Circle& t_circle)
+{
+  push_back(t_circle);
+}
+
+void CircleRun::push_back(const Circle& t_circle)
+{
+  style.push_back(intern_style(&styles, ShapeStyle{t_circle.line, t_circle.fill}));
+  pos.push_back(t_circle.pos);
+  radius.push_back(t_circle.radius);
+}
+
+Circle CircleRun::at(std::size_t t_index) const
+{
+  const auto& s = styles[style[t_index]];
+  Circle circle(s.line, s.fill, pos[t_index], radius[t_index]);
+  circle.clip_id = clip_id;
+  return circle;
+}
+
+std::size_t CircleRun::mem_size() const
+{
+  return sizeof(*this) + styles.capacity() * sizeof(ShapeStyle) +
+         style.capacity() * sizeof(uint32_t) + pos.capacity() * sizeof(gvertex<double>) +
+         radius.capacity() * sizeof(double);
+}
+
+void CircleRun::remap_styles(const style_remap& t_map)
+{
+  for (auto& s : styles)
+  {
+    s.line = t_map.lines[s.line];
+  }
+}
+
+grect<double> CircleRun::bounds(const style_table& t_styles) const
+{
+  grect<double> box{0, 0, -1, -1};
+  for (std::size_t i = 0; i != size(); ++i)
+  {
+    const auto b =
+        circle_bounds(pos[i], radius[i], stroke_margin(t_styles, styles[style[i]].line));
+    box = i == 0 ? b : unite(box, b);
+  }
+  return box;
+}
+
+std::size_t CircleRun::cull(const grect<double>& t_clip, const style_table& t_styles)
+{
+  return remove_elements(
+      size(),
+      [&](std::size_t i)
+      {
+        const double margin = stroke_margin(t_styles, styles[style[i]].line);
+        return rect_intersects(circle_bounds(pos[i], radius[i], margin), t_clip);
+      },
+      &style, &pos, &radius);
+}
+
+void CircleRun::visit(draw_call_visitor* t_visitor) const
+{
+  t_visitor->visit(this);
+}
+
+LineRun::LineRun(const Line& t_line)
+{
+  push_back(t_line);
+}
+
+void LineRun::push_back(const Line& t_line)
+{
+  style.push_back(intern_style(&styles, t_line.line));
+  orig.push_back(t_line.orig);
+  dest.push_back(t_line.dest);
+}
+
+Line LineRun::at(std::size_t t_index) const
+{
+  Line line(styles[style[t_index]], orig[t_index], dest[t_index]);
+  line.clip_id = clip_id;
+  return line;
+}
+
+std::size_t LineRun::mem_size() const
+{
+  return sizeof(*this) + styles.capacity() * sizeof(style_id_t) +
+         style.capacity() * sizeof(uint32_t) +
+         (orig.capacity() + dest.capacity()) * sizeof(gvertex<double>);
+}
+
+void LineRun::remap_styles(const style_remap& t_map)
+{
+  for (auto& s : styles)
+  {
+    s = t_map.lines[s];
+  }
+}
+
+grect<double> LineRun::bounds(const style_table& t_styles) const
+{
+  grect<double> box{0, 0, -1, -1};
+  for (std::size_t i = 0; i != size(); ++i)
+  {
+    const auto b =
+        line_bounds(orig[i], dest[i], stroke_margin(t_styles, styles[style[i]]));
+    box = i == 0 ? b : unite(box, b);
+  }
+  return box;
+}
+
+std::size_t LineRun::cull(const grect<double>& t_clip, const style_table& t_styles)
+{
+  return remove_elements(
+      size(),
+      [&](std::size_t i)
+      {
+        return rect_intersects(
+            line_bounds(orig[i], dest[i], stroke_margin(t_styles, styles[style[i]])),
+            t_clip);
+      },
+      &style, &orig, &dest);
+}
+
+void LineRun::visit(draw_call_visitor* t_visitor) const
+{
+  t_visitor->visit(this);
+}
+
+RectRun::RectRun(const Rect& t_rect)
+{
+  push_back(t_rect);
+}
+
+void RectRun::push_back(const Rect& t_rect)
+{
+  style.push_back(intern_style(&styles, ShapeStyle{t_rect.line, t_rect.fill}));
+  rect.push_back(t_rect.rect);
+}
+
+Rect RectRun::at(std::size_t t_index) const
+{
+  const auto& s = styles[style[t_index]];
+  Rect r(s.line, s.fill, rect[t_index]);
+  r.clip_id = clip_id;
+  return r;
+}
+
+std::size_t RectRun::mem_size() const
+{
+  return sizeof(*this) + styles.capacity() * sizeof(ShapeStyle) +
+         style.capacity() * sizeof(uint32_t) + rect.capacity() * sizeof(grect<double>);
+}
+
+void RectRun::remap_styles(const style_remap& t_map)
+{
+  for (auto& s : styles)
+  {
+    s.line = t_map.lines[s.line];
+  }
+}
+
+grect<double> RectRun::bounds(const style_table& t_styles) const
+{
+  grect<double> box{0, 0, -1, -1};
+  for (std::size_t i = 0; i != size(); ++i)
+  {
+    const auto b = expand(rect[i], stroke_margin(t_styles, styles[style[i]].line));
+    box = i == 0 ? b : unite(box, b);
+  }
+  return box;
+}
+
+std::size_t RectRun::cull(const grect<double>& t_clip, const style_table& t_styles)
+{
+  return remove_elements(
+      size(),
+      [&](std::size_t i)
+      {
+        return rect_intersects(
+            expand(rect[i], stroke_margin(t_styles, styles[style[i]].line)), t_clip);
+      },
+      &style, &rect);
+}
+
+void RectRun::visit(draw_call_visitor* t_visitor) const
+{
+  t_visitor->visit(this);
+}
+
+void append_primitive(draw_call_list* t_dcs, Circle&& t_circle)
+{
+  append_to_run<Circle, CircleRun>(t_dcs, std::move(t_circle));
+}
+
+void append_primitive(draw_call_list* t_dcs, Line&& t_line)
+{
+  append_to_run<Line, LineRun>(t_dcs, std::move(t_line));
+}
+
+void append_primitive(draw_call_list* t_dcs, Rect&& t_rect)
+{
+  append_to_run<Rect, RectRun>(t_dcs, std::move(t_rect));
+}
+
 Page::Page(page_id_t t_id, gvertex<double> t_size) : id(t_id), size(t_size), dcs(), cps()
 {
   clip({0, 0, size.x, size.y});
 }
 
-void Page::put(std::unique_ptr<DrawCall>&& t_dc)
+void Page::put(draw_call_list&& t_dcs, const style_table& t_styles)
 {
-  t_dc->clip_id = cps.back().id;
-  dcs.emplace_back(std::move(t_dc));
+  const auto styles_size = styles.mem_size();
+  style_remap map;
+  bool identity = true;
+  for (const auto& line : t_styles.lines())
+  {
+    map.lines.push_back(styles.intern(line));
+    identity = identity && map.lines.back() == map.lines.size() - 1;
+  }
+  for (const auto& text : t_styles.texts())
+  {
+    map.texts.push_back(styles.intern(text));
+    identity = identity && map.texts.back() == map.texts.size() - 1;
+  }
+  mem_size += styles.mem_size() - styles_size;
+
+  const auto& clip = cps.back();
+  for (auto* dc : t_dcs)
+  {
+    dc->clip_id = clip.id;
+    if (!identity)
+    {
+      dc->remap_styles(map);
+    }
+  }
+  // Nothing outside of the clip rectangle is ever visible
+  t_dcs.remove_if(
+      [&](DrawCall* t_dc)
+      {
+        if (!rect_intersects(t_dc->bounds(styles), clip.rect))
+        {
+          culled += t_dc->elements();
+          return true;
+        }
+        culled += t_dc->cull(clip.rect, styles);
+        return false;
+      });
+  for (const auto* dc : t_dcs)
+  {
+    mem_size += sizeof(dc) + dc->mem_size();
+  }
+  dcs.splice(std::move(t_dcs));
+  m_index.reset();
 }
 
-void Page::put(std::vector<std::unique_ptr<DrawCall>>&& t_dcs)
+void Page::append(draw_call_list&& t_dcs)
 {
-  for (auto& cp : t_dcs)
+  for (const auto* dc : t_dcs)
   {
-    cp->clip_id = cps.back().id;
+    mem_size += sizeof(dc) + dc->mem_size();
   }
-  dcs.insert(dcs.end(), std::make_move_iterator(t_dcs.begin()),
-             std::make_move_iterator(t_dcs.end()));
+  dcs.splice(std::move(t_dcs));
+  m_index.reset();
 }
 
 void Page::clear()
 {
   dcs.clear();
   cps.clear();
+  styles.clear();
+  mem_size = 0;
+  culled = 0;
+  m_index.reset();
   clip({0, 0, size.x, size.y});
 }
 
+std::size_t Page::draw_call_count() const
+{
+  std::size_t count = 0;
+  for (const auto* dc : dcs)
+  {
+    count += dc->elements();
+  }
+  return count;
+}
+
 void Page::clip(grect<double> t_rect)
 {
   const auto cps_count = cps.size();
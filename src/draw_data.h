@@ -1,11 +1,14 @@
 #ifndef __UNIGD_DRAW_DATA_H__
 #define __UNIGD_DRAW_DATA_H__
 
+#include <cstddef>
 #include <cstdint>
 #include <memory>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
+#include "arena_list.h"
 #include "geom.h"
 
 // Do not include any R headers here !
@@ -150,12 +153,49 @@ struct TextInfo
   std::string font_family;
   double fontsize;
   bool italic;
-  double txtwidth_px;
+};
+
+using style_id_t = uint32_t;
+
+// Distinct line and text styles of a page.
+//
+// Most plots use a handful of styles, draw calls refer to them by id so that every style
+// is stored (and formatted by renderers) only once.
+class style_table
+{
+ public:
+  // Returns the id of the style, adding it to the table if it is new.
+  style_id_t intern(const LineInfo& t_line);
+  style_id_t intern(const TextInfo& t_text);
+
+  const LineInfo& line(style_id_t t_id) const { return m_lines[t_id]; }
+  const TextInfo& text(style_id_t t_id) const { return m_texts[t_id]; }
+  const std::vector<LineInfo>& lines() const { return m_lines; }
+  const std::vector<TextInfo>& texts() const { return m_texts; }
+
+  void clear();
+  // Approximate memory held by the table (in bytes)
+  std::size_t mem_size() const;
+
+ private:
+  std::vector<LineInfo> m_lines{};
+  std::vector<TextInfo> m_texts{};
+  // hash -> id
+  std::unordered_multimap<std::size_t, style_id_t> m_line_ids{};
+  std::unordered_multimap<std::size_t, style_id_t> m_text_ids{};
+};
+
+// Maps the style ids of one table to the ids of another.
+struct style_remap
+{
+  std::vector<style_id_t> lines;
+  std::vector<style_id_t> texts;
 };
 
 // Draw calls
 
 class Page;
+class page_index;
 class DrawCall;
 class Rect;
 class Text;
@@ -165,6 +205,9 @@ class Polyline;
 class Polygon;
 class Path;
 class Raster;
+class CircleRun;
+class LineRun;
+class RectRun;
 
 struct draw_call_visitor
 {
@@ -176,6 +219,13 @@ struct draw_call_visitor
   virtual void visit(const Polygon* t_polygon) = 0;
   virtual void visit(const Path* t_path) = 0;
   virtual void visit(const Raster* t_raster) = 0;
+
+  // Runs are passed on element by element, unless the visitor handles them itself.
+  virtual void visit(const CircleRun* t_run);
+  virtual void visit(const LineRun* t_run);
+  virtual void visit(const RectRun* t_run);
+  // Called between two elements of a run that is passed on element by element.
+  virtual void run_separator() {}
 };
 
 class DrawCall
@@ -183,6 +233,21 @@ class DrawCall
  public:
   virtual ~DrawCall() = default;
   virtual void visit(draw_call_visitor* t_visitor) const = 0;
+  // Approximate memory held by this draw call (in bytes)
+  virtual std::size_t mem_size() const = 0;
+  // Number of primitives drawn (more than one for primitive runs)
+  virtual std::size_t elements() const { return 1; }
+  // Replaces style ids, used when draw calls move to a different style table.
+  virtual void remap_styles(const style_remap& t_map) {}
+  // Box (in page coordinates) that contains everything the draw call paints, including
+  // the stroke. May be larger than necessary.
+  virtual grect<double> bounds(const style_table& t_styles) const = 0;
+  // Removes the elements of a primitive run that lie outside of t_clip and returns
+  // their number.
+  virtual std::size_t cull(const grect<double>& t_clip, const style_table& t_styles)
+  {
+    return 0;
+  }
 
   clip_id_t clip_id = 0;
 };
@@ -191,23 +256,30 @@ class Text : public DrawCall
 {
  public:
   Text(color_t t_col, gvertex<double> t_pos, std::string&& t_str, double t_rot,
-       double t_hadj, TextInfo&& t_text);
+       double t_hadj, style_id_t t_text, double t_txtwidth_px);
   void visit(draw_call_visitor* t_visitor) const override;
+  std::size_t mem_size() const override;
+  grect<double> bounds(const style_table& t_styles) const override;
+  void remap_styles(const style_remap& t_map) override;
 
   color_t col;
   gvertex<double> pos;
   double rot, hadj;
   std::string str;
-  TextInfo text;
+  style_id_t text;
+  double txtwidth_px;
 };
 
 class Circle : public DrawCall
 {
  public:
-  Circle(LineInfo&& t_line, color_t t_fill, gvertex<double> t_pos, double t_radius);
+  Circle(style_id_t t_line, color_t t_fill, gvertex<double> t_pos, double t_radius);
   void visit(draw_call_visitor* t_visitor) const override;
+  std::size_t mem_size() const override;
+  grect<double> bounds(const style_table& t_styles) const override;
+  void remap_styles(const style_remap& t_map) override;
 
-  LineInfo line;
+  style_id_t line;
   color_t fill;
   gvertex<double> pos;
   double radius;
@@ -216,20 +288,26 @@ class Circle : public DrawCall
 class Line : public DrawCall
 {
  public:
-  Line(LineInfo&& t_line, gvertex<double> t_orig, gvertex<double> t_dest);
+  Line(style_id_t t_line, gvertex<double> t_orig, gvertex<double> t_dest);
   void visit(draw_call_visitor* t_visitor) const override;
+  std::size_t mem_size() const override;
+  grect<double> bounds(const style_table& t_styles) const override;
+  void remap_styles(const style_remap& t_map) override;
 
-  LineInfo line;
+  style_id_t line;
   gvertex<double> orig, dest;
 };
 
 class Rect : public DrawCall
 {
  public:
-  Rect(LineInfo&& t_line, color_t t_fill, grect<double> t_rect);
+  Rect(style_id_t t_line, color_t t_fill, grect<double> t_rect);
   void visit(draw_call_visitor* t_visitor) const override;
+  std::size_t mem_size() const override;
+  grect<double> bounds(const style_table& t_styles) const override;
+  void remap_styles(const style_remap& t_map) override;
 
-  LineInfo line;
+  style_id_t line;
   color_t fill;
   grect<double> rect;
 };
@@ -237,20 +315,26 @@ class Rect : public DrawCall
 class Polyline : public DrawCall
 {
  public:
-  Polyline(LineInfo&& t_line, std::vector<gvertex<double>>&& t_points);
+  Polyline(style_id_t t_line, std::vector<gvertex<double>>&& t_points);
   void visit(draw_call_visitor* t_visitor) const override;
+  std::size_t mem_size() const override;
+  grect<double> bounds(const style_table& t_styles) const override;
+  void remap_styles(const style_remap& t_map) override;
 
-  LineInfo line;
+  style_id_t line;
   std::vector<gvertex<double>> points;
 };
 
 class Polygon : public DrawCall
 {
  public:
-  Polygon(LineInfo&& t_line, color_t t_fill, std::vector<gvertex<double>>&& t_points);
+  Polygon(style_id_t t_line, color_t t_fill, std::vector<gvertex<double>>&& t_points);
   void visit(draw_call_visitor* t_visitor) const override;
+  std::size_t mem_size() const override;
+  grect<double> bounds(const style_table& t_styles) const override;
+  void remap_styles(const style_remap& t_map) override;
 
-  LineInfo line;
+  style_id_t line;
   color_t fill;
   std::vector<gvertex<double>> points;
 };
@@ -258,11 +342,14 @@ class Polygon : public DrawCall
 class Path : public DrawCall
 {
  public:
-  Path(LineInfo&& t_line, color_t t_fill, std::vector<gvertex<double>>&& t_points,
+  Path(style_id_t t_line, color_t t_fill, std::vector<gvertex<double>>&& t_points,
        std::vector<int>&& t_nper, bool t_winding);
   void visit(draw_call_visitor* t_visitor) const override;
+  std::size_t mem_size() const override;
+  grect<double> bounds(const style_table& t_styles) const override;
+  void remap_styles(const style_remap& t_map) override;
 
-  LineInfo line;
+  style_id_t line;
   color_t fill;
   std::vector<gvertex<double>> points;
   std::vector<int> nper;
@@ -275,6 +362,8 @@ class Raster : public DrawCall
   Raster(std::vector<unsigned int>&& t_raster, gvertex<int> t_wh, grect<double> t_rect,
          double t_rot, bool t_interpolate);
   void visit(draw_call_visitor* t_visitor) const override;
+  std::size_t mem_size() const override;
+  grect<double> bounds(const style_table& t_styles) const override;
 
   std::vector<unsigned int> raster;
   gvertex<int> wh;
@@ -283,6 +372,82 @@ class Raster : public DrawCall
   bool interpolate;
 };
 
+// Primitive runs
+//
+// Consecutive circles, lines and rectangles are stored in typed columns instead of one
+// draw call per primitive (see append_primitive()). The styles of a run are kept in a
+// small table and referenced by index.
+
+struct ShapeStyle
+{
+  style_id_t line;
+  color_t fill;
+};
+
+class CircleRun : public DrawCall
+{
+ public:
+  CircleRun() = default;
+  explicit CircleRun(const Circle& t_circle);
+  void visit(draw_call_visitor* t_visitor) const override;
+  std::size_t mem_size() const override;
+  grect<double> bounds(const style_table& t_styles) const override;
+  std::size_t elements() const override { return size(); }
+  void remap_styles(const style_remap& t_map) override;
+  std::size_t cull(const grect<double>& t_clip, const style_table& t_styles) override;
+
+  std::size_t size() const { return pos.size(); }
+  void push_back(const Circle& t_circle);
+  Circle at(std::size_t t_index) const;
+
+  std::vector<ShapeStyle> styles;
+  std::vector<uint32_t> style;
+  std::vector<gvertex<double>> pos;
+  std::vector<double> radius;
+};
+
+class LineRun : public DrawCall
+{
+ public:
+  LineRun() = default;
+  explicit LineRun(const Line& t_line);
+  void visit(draw_call_visitor* t_visitor) const override;
+  std::size_t mem_size() const override;
+  grect<double> bounds(const style_table& t_styles) const override;
+  std::size_t elements() const override { return size(); }
+  void remap_styles(const style_remap& t_map) override;
+  std::size_t cull(const grect<double>& t_clip, const style_table& t_styles) override;
+
+  std::size_t size() const { return orig.size(); }
+  void push_back(const Line& t_line);
+  Line at(std::size_t t_index) const;
+
+  std::vector<style_id_t> styles;
+  std::vector<uint32_t> style;
+  std::vector<gvertex<double>> orig, dest;
+};
+
+class RectRun : public DrawCall
+{
+ public:
+  RectRun() = default;
+  explicit RectRun(const Rect& t_rect);
+  void visit(draw_call_visitor* t_visitor) const override;
+  std::size_t mem_size() const override;
+  grect<double> bounds(const style_table& t_styles) const override;
+  std::size_t elements() const override { return size(); }
+  void remap_styles(const style_remap& t_map) override;
+  std::size_t cull(const grect<double>& t_clip, const style_table& t_styles) override;
+
+  std::size_t size() const { return rect.size(); }
+  void push_back(const Rect& t_rect);
+  Rect at(std::size_t t_index) const;
+
+  std::vector<ShapeStyle> styles;
+  std::vector<uint32_t> style;
+  std::vector<grect<double>> rect;
+};
+
 class Clip
 {
  public:
@@ -295,6 +460,15 @@ class Clip
   grect<double> rect;
 };
 
+// Draw calls are allocated in bulk, see arena_list.
+using draw_call_list = arena_list<DrawCall>;
+
+// Appends a primitive. If the last draw call is of the same type, both are merged into
+// a run.
+void append_primitive(draw_call_list* t_dcs, Circle&& t_circle);
+void append_primitive(draw_call_list* t_dcs, Line&& t_line);
+void append_primitive(draw_call_list* t_dcs, Rect&& t_rect);
+
 class Page
 {
  public:
@@ -307,17 +481,36 @@ class Page
   Page(Page&&) = default;
   Page& operator=(Page&&) = default;
 
-  void put(std::unique_ptr<DrawCall>&& t_dc);
-  void put(std::vector<std::unique_ptr<DrawCall>>&& t_dcs);
+  // Appends draw calls whose style ids refer to t_styles. Draw calls (and elements of
+  // primitive runs) that lie outside of the current clip rectangle are dropped.
+  void put(draw_call_list&& t_dcs, const style_table& t_styles);
+  // Appends draw calls as they are, keeping their clip and style ids (e.g. decoded ones).
+  void append(draw_call_list&& t_dcs);
   void clear();
   void clip(grect<double> t_rect);
+  // Number of draw calls, counting every element of primitive runs.
+  std::size_t draw_call_count() const;
+  // Spatial index over the draw calls (see page_index.h). It is built on first use and
+  // dropped whenever draw calls are added or cleared. Concurrent readers may call this,
+  // but not while the page is being modified.
+  std::shared_ptr<const page_index> index() const;
 
   page_id_t id;
   gvertex<double> size;
   color_t fill;
 
-  std::vector<std::unique_ptr<DrawCall>> dcs;
+  draw_call_list dcs;
   std::vector<Clip> cps;
+  style_table styles;
+
+  // Approximate memory held by the draw calls and styles (in bytes)
+  std::size_t mem_size = 0;
+  // Number of draw calls dropped because they were clipped entirely, counting every
+  // element of primitive runs.
+  std::size_t culled = 0;
+
+ private:
+  mutable std::shared_ptr<const page_index> m_index;
 };
 
 }  // namespace renderers
@@ -35,6 +35,13 @@ bool rect_equals(const grect<T>& r0, const grect<T>& r1, T eps)
          (std::fabs(r0.height - r1.height) < eps);
 }
 
+template <class T>
+bool rect_intersects(const grect<T>& r0, const grect<T>& r1)
+{
+  return r0.x <= r1.x + r1.width && r1.x <= r0.x + r0.width && r0.y <= r1.y + r1.height &&
+         r1.y <= r0.y + r0.height;
+}
+
 }  // namespace unigd
 
 #endif /* __UNIGD_GEOM_H__ */
@@ -0,0 +1,133 @@
+#include "mapped_file.h"
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace unigd
+{
+mapped_file::~mapped_file()
+{
+  close();
+}
+
+#ifdef _WIN32
+
+bool mapped_file::open(const std::string& t_path)
+{
+  close();
+  HANDLE file = CreateFileA(t_path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                            OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+  if (file == INVALID_HANDLE_VALUE)
+  {
+    return false;
+  }
+  m_file = file;
+
+  LARGE_INTEGER size;
+  if (!GetFileSizeEx(file, &size))
+  {
+    close();
+    return false;
+  }
+  if (size.QuadPart == 0)
+  {
+    return true;
+  }
+
+  HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  if (!mapping)
+  {
+    close();
+    return false;
+  }
+  m_mapping = mapping;
+
+  const void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+  if (!view)
+  {
+    close();
+    return false;
+  }
+  m_data = static_cast<const uint8_t*>(view);
+  m_size = static_cast<std::size_t>(size.QuadPart);
+  return true;
+}
+
+void mapped_file::close()
+{
+  if (m_data)
+  {
+    UnmapViewOfFile(m_data);
+  }
+  if (m_mapping)
+  {
+    CloseHandle(m_mapping);
+  }
+  if (m_file)
+  {
+    CloseHandle(m_file);
+  }
+  m_data = nullptr;
+  m_size = 0;
+  m_mapping = nullptr;
+  m_file = nullptr;
+}
+
+#else
+
+bool mapped_file::open(const std::string& t_path)
+{
+  close();
+  const int fd = ::open(t_path.c_str(), O_RDONLY);
+  if (fd < 0)
+  {
+    return false;
+  }
+
+  struct stat st;
+  if (fstat(fd, &st) != 0)
+  {
+    ::close(fd);
+    return false;
+  }
+  if (st.st_size == 0)
+  {
+    ::close(fd);
+    return true;
+  }
+
+  void* addr = mmap(nullptr, static_cast<std::size_t>(st.st_size), PROT_READ, MAP_PRIVATE,
+                    fd, 0);
+  // The mapping stays valid after the descriptor is closed.
+  ::close(fd);
+  if (addr == MAP_FAILED)
+  {
+    return false;
+  }
+  m_data = static_cast<const uint8_t*>(addr);
+  m_size = static_cast<std::size_t>(st.st_size);
+  return true;
+}
+
+void mapped_file::close()
+{
+  if (m_data)
+  {
+    munmap(const_cast<uint8_t*>(m_data), m_size);
+  }
+  m_data = nullptr;
+  m_size = 0;
+}
+
+#endif
+
+}  // namespace unigd
@@ -0,0 +1,37 @@
+#ifndef __UNIGD_MAPPED_FILE_H__
+#define __UNIGD_MAPPED_FILE_H__
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace unigd
+{
+// Read-only memory mapping of a whole file.
+class mapped_file
+{
+ public:
+  mapped_file() = default;
+  ~mapped_file();
+
+  mapped_file(const mapped_file&) = delete;
+  mapped_file& operator=(const mapped_file&) = delete;
+
+  bool open(const std::string& t_path);
+  void close();
+
+  const uint8_t* data() const { return m_data; }
+  std::size_t size() const { return m_size; }
+
+ private:
+  const uint8_t* m_data{nullptr};
+  std::size_t m_size{0};
+#ifdef _WIN32
+  void* m_file{nullptr};
+  void* m_mapping{nullptr};
+#endif
+};
+
+}  // namespace unigd
+
+#endif /* __UNIGD_MAPPED_FILE_H__ */
@@ -0,0 +1,707 @@
+#include "page_codec.h"
+
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include <type_traits>
+
+namespace unigd
+{
+namespace renderers
+{
+namespace codec
+{
+namespace
+{
+constexpr uint32_t page_magic = 0x50444755;  // "UGDP"
+constexpr uint16_t page_format = 4;
+
+enum class tag : uint8_t
+{
+  rect = 1,
+  text,
+  circle,
+  line,
+  polyline,
+  polygon,
+  path,
+  raster,
+  circle_run,
+  line_run,
+  rect_run
+};
+
+template <class T>
+inline void put(std::vector<uint8_t>* t_out, T t_value)
+{
+  static_assert(std::is_trivially_copyable<T>::value, "only plain values");
+  const auto* p = reinterpret_cast<const uint8_t*>(&t_value);
+  t_out->insert(t_out->end(), p, p + sizeof(T));
+}
+
+inline void put(std::vector<uint8_t>* t_out, const std::string& t_value)
+{
+  put(t_out, static_cast<uint32_t>(t_value.size()));
+  t_out->insert(t_out->end(), t_value.begin(), t_value.end());
+}
+
+template <class T>
+inline void put(std::vector<uint8_t>* t_out, const std::vector<T>& t_values)
+{
+  static_assert(std::is_trivially_copyable<T>::value, "only plain values");
+  put(t_out, static_cast<uint32_t>(t_values.size()));
+  const auto* p = reinterpret_cast<const uint8_t*>(t_values.data());
+  t_out->insert(t_out->end(), p, p + t_values.size() * sizeof(T));
+}
+
+inline void put(std::vector<uint8_t>* t_out, const LineInfo& t_line)
+{
+  put(t_out, t_line.col);
+  put(t_out, t_line.lwd);
+  put(t_out, t_line.lty);
+  put(t_out, static_cast<uint8_t>(t_line.lend));
+  put(t_out, static_cast<uint8_t>(t_line.ljoin));
+  put(t_out, t_line.lmitre);
+}
+
+inline void put(std::vector<uint8_t>* t_out, const TextInfo& t_text)
+{
+  put(t_out, t_text.weight);
+  put(t_out, t_text.features);
+  put(t_out, t_text.font_family);
+  put(t_out, t_text.fontsize);
+  put(t_out, static_cast<uint8_t>(t_text.italic));
+}
+
+inline void put(std::vector<uint8_t>* t_out, const ShapeStyle& t_style)
+{
+  put(t_out, t_style.line);
+  put(t_out, t_style.fill);
+}
+
+template <class S>
+inline void put_styles(std::vector<uint8_t>* t_out, const std::vector<S>& t_styles)
+{
+  put(t_out, static_cast<uint32_t>(t_styles.size()));
+  for (const auto& style : t_styles)
+  {
+    put(t_out, style);
+  }
+}
+
+inline void put_header(std::vector<uint8_t>* t_out, tag t_tag, const DrawCall* t_dc)
+{
+  put(t_out, static_cast<uint8_t>(t_tag));
+  put(t_out, t_dc->clip_id);
+}
+
+class encoder : public draw_call_visitor
+{
+ public:
+  explicit encoder(std::vector<uint8_t>* t_out) : m_out(t_out) {}
+
+  void visit(const Rect* t_rect) override
+  {
+    put_header(m_out, tag::rect, t_rect);
+    put(m_out, t_rect->line);
+    put(m_out, t_rect->fill);
+    put(m_out, t_rect->rect);
+  }
+
+  void visit(const Text* t_text) override
+  {
+    put_header(m_out, tag::text, t_text);
+    put(m_out, t_text->col);
+    put(m_out, t_text->pos);
+    put(m_out, t_text->rot);
+    put(m_out, t_text->hadj);
+    put(m_out, t_text->str);
+    put(m_out, t_text->text);
+    put(m_out, t_text->txtwidth_px);
+  }
+
+  void visit(const Circle* t_circle) override
+  {
+    put_header(m_out, tag::circle, t_circle);
+    put(m_out, t_circle->line);
+    put(m_out, t_circle->fill);
+    put(m_out, t_circle->pos);
+    put(m_out, t_circle->radius);
+  }
+
+  void visit(const Line* t_line) override
+  {
+    put_header(m_out, tag::line, t_line);
+    put(m_out, t_line->line);
+    put(m_out, t_line->orig);
+    put(m_out, t_line->dest);
+  }
+
+  void visit(const Polyline* t_polyline) override
+  {
+    put_header(m_out, tag::polyline, t_polyline);
+    put(m_out, t_polyline->line);
+    put(m_out, t_polyline->points);
+  }
+
+  void visit(const Polygon* t_polygon) override
+  {
+    put_header(m_out, tag::polygon, t_polygon);
+    put(m_out, t_polygon->line);
+    put(m_out, t_polygon->fill);
+    put(m_out, t_polygon->points);
+  }
+
+  void visit(const Path* t_path) override
+  {
+    put_header(m_out, tag::path, t_path);
+    put(m_out, t_path->line);
+    put(m_out, t_path->fill);
+    put(m_out, t_path->points);
+    put(m_out, t_path->nper);
+    put(m_out, static_cast<uint8_t>(t_path->winding));
+  }
+
+  void visit(const Raster* t_raster) override
+  {
+    put_header(m_out, tag::raster, t_raster);
+    put(m_out, t_raster->raster);
+    put(m_out, t_raster->wh);
+    put(m_out, t_raster->rect);
+    put(m_out, t_raster->rot);
+    put(m_out, static_cast<uint8_t>(t_raster->interpolate));
+  }
+
+  void visit(const CircleRun* t_run) override
+  {
+    put_header(m_out, tag::circle_run, t_run);
+    put_styles(m_out, t_run->styles);
+    put(m_out, t_run->style);
+    put(m_out, t_run->pos);
+    put(m_out, t_run->radius);
+  }
+
+  void visit(const LineRun* t_run) override
+  {
+    put_header(m_out, tag::line_run, t_run);
+    put_styles(m_out, t_run->styles);
+    put(m_out, t_run->style);
+    put(m_out, t_run->orig);
+    put(m_out, t_run->dest);
+  }
+
+  void visit(const RectRun* t_run) override
+  {
+    put_header(m_out, tag::rect_run, t_run);
+    put_styles(m_out, t_run->styles);
+    put(m_out, t_run->style);
+    put(m_out, t_run->rect);
+  }
+
+ private:
+  std::vector<uint8_t>* m_out;
+};
+}  // namespace
+
+void encode(const DrawCall& t_dc, std::vector<uint8_t>* t_out)
+{
+  encoder enc(t_out);
+  t_dc.visit(&enc);
+}
+
+void encode(const Clip& t_clip, std::vector<uint8_t>* t_out)
+{
+  put(t_out, t_clip.id);
+  put(t_out, t_clip.rect);
+}
+
+void encode(const style_table& t_styles, std::vector<uint8_t>* t_out)
+{
+  put_styles(t_out, t_styles.lines());
+  put_styles(t_out, t_styles.texts());
+}
+
+void encode_page(const Page& t_page, std::vector<uint8_t>* t_out)
+{
+  encode_delta(t_page, 0, t_out);
+}
+
+void encode_delta(const Page& t_page, std::size_t t_from, std::vector<uint8_t>* t_out)
+{
+  t_from = std::min(t_from, t_page.dcs.size());
+  // Clip regions are only ever appended and draw calls use the newest one, so later
+  // draw calls can not refer to regions before the one of the last known draw call.
+  const auto first_clip =
+      t_from == 0 ? 0 : static_cast<std::size_t>(t_page.dcs.begin()[t_from - 1]->clip_id);
+  put(t_out, page_magic);
+  put(t_out, page_format);
+  put(t_out, static_cast<uint32_t>(t_page.cps.size() - first_clip));
+  for (auto it = t_page.cps.begin() + first_clip; it != t_page.cps.end(); ++it)
+  {
+    encode(*it, t_out);
+  }
+  encode(t_page.styles, t_out);
+  put(t_out, static_cast<uint32_t>(t_page.culled));
+  put(t_out, static_cast<uint32_t>(t_page.dcs.size() - t_from));
+  encoder enc(t_out);
+  for (auto it = t_page.dcs.begin() + t_from; it != t_page.dcs.end(); ++it)
+  {
+    (*it)->visit(&enc);
+  }
+}
+
+bool decode_page(const uint8_t* t_buf, std::size_t t_size, Page* t_page)
+{
+  t_page->clear();
+  t_page->cps.clear();
+
+  reader in(t_buf, t_size);
+  uint32_t n;
+  bool ok = in.page_header() && in.count(&n);
+  for (uint32_t i = 0; ok && i != n; ++i)
+  {
+    Clip cp;
+    // Renderers look clip regions up by id, which is their position in the list
+    ok = in.clip(&cp) && cp.id == static_cast<clip_id_t>(i);
+    t_page->cps.push_back(cp);
+  }
+  ok = ok && in.styles(&t_page->styles);
+  uint32_t culled = 0;
+  ok = ok && in.count(&culled);
+  ok = ok && in.count(&n);
+  draw_call_list dcs;
+  for (uint32_t i = 0; ok && i != n; ++i)
+  {
+    ok = in.draw_call(&dcs, t_page->cps.size());
+  }
+
+  if (!ok || !in.done() || t_page->cps.empty())
+  {
+    t_page->clear();
+    return false;
+  }
+  t_page->culled = culled;
+  t_page->mem_size = t_page->styles.mem_size();
+  for (const auto* dc : dcs)
+  {
+    t_page->mem_size += sizeof(dc) + dc->mem_size();
+  }
+  t_page->dcs = std::move(dcs);
+  return true;
+}
+
+bool decode_delta(const uint8_t* t_buf, std::size_t t_size, Page* t_page)
+{
+  reader in(t_buf, t_size);
+  uint32_t n;
+  std::vector<Clip> cps;
+  bool ok = in.page_header() && in.count(&n);
+  for (uint32_t i = 0; ok && i != n; ++i)
+  {
+    Clip cp;
+    // The regions continue (or overlap) the ones of the page without a gap
+    ok = in.clip(&cp) &&
+         (cps.empty()
+              ? cp.id >= 0 && static_cast<std::size_t>(cp.id) <= t_page->cps.size()
+              : cp.id == cps.back().id + 1);
+    cps.push_back(cp);
+  }
+  const auto clips = cps.empty()
+                         ? t_page->cps.size()
+                         : std::max(t_page->cps.size(),
+                                    static_cast<std::size_t>(cps.back().id) + 1);
+  style_table styles;
+  ok = ok && in.styles(&styles);
+  uint32_t culled = 0;
+  ok = ok && in.count(&culled);
+  ok = ok && in.count(&n);
+  draw_call_list dcs;
+  for (uint32_t i = 0; ok && i != n; ++i)
+  {
+    ok = in.draw_call(&dcs, clips);
+  }
+  if (!ok || !in.done())
+  {
+    return false;
+  }
+
+  for (const auto& cp : cps)
+  {
+    if (cp.id == static_cast<clip_id_t>(t_page->cps.size()))
+    {
+      t_page->cps.push_back(cp);
+    }
+  }
+  t_page->mem_size = t_page->mem_size - t_page->styles.mem_size() + styles.mem_size();
+  t_page->styles = std::move(styles);
+  t_page->culled = culled;
+  t_page->append(std::move(dcs));
+  return true;
+}
+
+reader::reader(const uint8_t* t_buf, std::size_t t_size)
+    : m_pos(t_buf), m_end(t_buf + t_size)
+{
+}
+
+bool reader::done() const
+{
+  return m_failed || m_pos == m_end;
+}
+
+bool reader::failed() const
+{
+  return m_failed;
+}
+
+template <class T>
+bool reader::m_read(T* t_value)
+{
+  static_assert(std::is_trivially_copyable<T>::value, "only plain values");
+  if (m_failed || static_cast<std::size_t>(m_end - m_pos) < sizeof(T))
+  {
+    m_failed = true;
+    return false;
+  }
+  std::memcpy(t_value, m_pos, sizeof(T));
+  m_pos += sizeof(T);
+  return true;
+}
+
+bool reader::m_read(std::string* t_value)
+{
+  uint32_t size;
+  if (!m_read(&size) || static_cast<std::size_t>(m_end - m_pos) < size)
+  {
+    m_failed = true;
+    return false;
+  }
+  t_value->assign(reinterpret_cast<const char*>(m_pos), size);
+  m_pos += size;
+  return true;
+}
+
+template <class T>
+bool reader::m_read(std::vector<T>* t_values)
+{
+  static_assert(std::is_trivially_copyable<T>::value, "only plain values");
+  uint32_t size;
+  if (!m_read(&size) || static_cast<std::size_t>(m_end - m_pos) / sizeof(T) < size)
+  {
+    m_failed = true;
+    return false;
+  }
+  t_values->resize(size);
+  if (size != 0)
+  {
+    std::memcpy(t_values->data(), m_pos, size * sizeof(T));
+    m_pos += size * sizeof(T);
+  }
+  return true;
+}
+
+bool reader::m_read(LineInfo* t_line)
+{
+  uint8_t lend = 0;
+  uint8_t ljoin = 0;
+  const bool ok = m_read(&t_line->col) && m_read(&t_line->lwd) && m_read(&t_line->lty) &&
+                  m_read(&lend) && m_read(&ljoin) && m_read(&t_line->lmitre);
+  if (!ok || lend < LineInfo::GC_ROUND_CAP || lend > LineInfo::GC_SQUARE_CAP ||
+      ljoin < LineInfo::GC_ROUND_JOIN || ljoin > LineInfo::GC_BEVEL_JOIN)
+  {
+    m_failed = true;
+    return false;
+  }
+  t_line->lend = static_cast<LineInfo::GC_lineend>(lend);
+  t_line->ljoin = static_cast<LineInfo::GC_linejoin>(ljoin);
+  return true;
+}
+
+bool reader::m_read(TextInfo* t_text)
+{
+  uint8_t italic = 0;
+  const bool ok = m_read(&t_text->weight) && m_read(&t_text->features) &&
+                  m_read(&t_text->font_family) && m_read(&t_text->fontsize) &&
+                  m_read(&italic);
+  t_text->italic = italic != 0;
+  return ok;
+}
+
+bool reader::m_read(ShapeStyle* t_style)
+{
+  return m_read_line(&t_style->line) && m_read(&t_style->fill);
+}
+
+bool reader::m_read_line(style_id_t* t_id)
+{
+  // Style ids have to point into the style table of the page.
+  m_failed = m_failed || !m_read(t_id) || *t_id >= m_lines;
+  return !m_failed;
+}
+
+bool reader::m_read_text(style_id_t* t_id)
+{
+  m_failed = m_failed || !m_read(t_id) || *t_id >= m_texts;
+  return !m_failed;
+}
+
+template <class S>
+bool reader::m_read_styles(std::vector<S>* t_styles)
+{
+  uint32_t size;
+  if (!m_read(&size) || static_cast<std::size_t>(m_end - m_pos) < size)
+  {
+    m_failed = true;
+    return false;
+  }
+  t_styles->resize(size);
+  for (auto& style : *t_styles)
+  {
+    if (!m_read(&style))
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool reader::m_read_styles(std::vector<style_id_t>* t_styles)
+{
+  uint32_t size;
+  if (!m_read(&size) ||
+      static_cast<std::size_t>(m_end - m_pos) / sizeof(style_id_t) < size)
+  {
+    m_failed = true;
+    return false;
+  }
+  t_styles->resize(size);
+  for (auto& style : *t_styles)
+  {
+    if (!m_read_line(&style))
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+template <class R>
+bool reader::m_check_run(const R& t_run, std::size_t t_size)
+{
+  // Every element needs a style index that points into the style table of the run.
+  const auto styles = t_run.styles.size();
+  const bool ok = t_run.style.size() == t_size &&
+                  std::all_of(t_run.style.begin(), t_run.style.end(),
+                              [&](uint32_t t_style) { return t_style < styles; });
+  m_failed = m_failed || !ok;
+  return ok;
+}
+
+bool reader::page_header()
+{
+  uint32_t magic;
+  uint16_t format;
+  if (!m_read(&magic) || !m_read(&format) || magic != page_magic ||
+      format != page_format)
+  {
+    m_failed = true;
+    return false;
+  }
+  return true;
+}
+
+bool reader::count(uint32_t* t_count)
+{
+  return m_read(t_count);
+}
+
+bool reader::clip(Clip* t_clip)
+{
+  return m_read(&t_clip->id) && m_read(&t_clip->rect);
+}
+
+bool reader::styles(style_table* t_styles)
+{
+  std::vector<LineInfo> lines;
+  std::vector<TextInfo> texts;
+  if (!m_read_styles(&lines) || !m_read_styles(&texts))
+  {
+    return false;
+  }
+  t_styles->clear();
+  for (const auto& line : lines)
+  {
+    t_styles->intern(line);
+  }
+  for (const auto& text : texts)
+  {
+    t_styles->intern(text);
+  }
+  // Duplicate entries would shift the ids of all following styles.
+  if (t_styles->lines().size() != lines.size() ||
+      t_styles->texts().size() != texts.size())
+  {
+    m_failed = true;
+    return false;
+  }
+  m_lines = lines.size();
+  m_texts = texts.size();
+  return true;
+}
+
+bool reader::draw_call(draw_call_list* t_dcs, std::size_t t_clips)
+{
+  uint8_t type;
+  clip_id_t clip_id;
+  if (!m_read(&type) || !m_read(&clip_id))
+  {
+    return false;
+  }
+  if (clip_id < 0 || static_cast<std::size_t>(clip_id) >= t_clips)
+  {
+    m_failed = true;
+    return false;
+  }
+
+  DrawCall* dc = nullptr;
+  style_id_t line;
+  color_t fill;
+  switch (static_cast<tag>(type))
+  {
+    case tag::rect:
+    {
+      grect<double> rect;
+      if (m_read_line(&line) && m_read(&fill) && m_read(&rect))
+      {
+        dc = t_dcs->emplace<Rect>(line, fill, rect);
+      }
+      break;
+    }
+    case tag::text:
+    {
+      color_t col;
+      gvertex<double> pos;
+      double rot, hadj;
+      std::string str;
+      style_id_t text;
+      double txtwidth_px;
+      if (m_read(&col) && m_read(&pos) && m_read(&rot) && m_read(&hadj) &&
+          m_read(&str) && m_read_text(&text) && m_read(&txtwidth_px))
+      {
+        dc = t_dcs->emplace<Text>(col, pos, std::move(str), rot, hadj, text, txtwidth_px);
+      }
+      break;
+    }
+    case tag::circle:
+    {
+      gvertex<double> pos;
+      double radius;
+      if (m_read_line(&line) && m_read(&fill) && m_read(&pos) && m_read(&radius))
+      {
+        dc = t_dcs->emplace<Circle>(line, fill, pos, radius);
+      }
+      break;
+    }
+    case tag::line:
+    {
+      gvertex<double> orig, dest;
+      if (m_read_line(&line) && m_read(&orig) && m_read(&dest))
+      {
+        dc = t_dcs->emplace<Line>(line, orig, dest);
+      }
+      break;
+    }
+    case tag::polyline:
+    {
+      std::vector<gvertex<double>> points;
+      if (m_read_line(&line) && m_read(&points))
+      {
+        dc = t_dcs->emplace<Polyline>(line, std::move(points));
+      }
+      break;
+    }
+    case tag::polygon:
+    {
+      std::vector<gvertex<double>> points;
+      if (m_read_line(&line) && m_read(&fill) && m_read(&points))
+      {
+        dc = t_dcs->emplace<Polygon>(line, fill, std::move(points));
+      }
+      break;
+    }
+    case tag::path:
+    {
+      std::vector<gvertex<double>> points;
+      std::vector<int> nper;
+      uint8_t winding;
+      if (m_read_line(&line) && m_read(&fill) && m_read(&points) && m_read(&nper) &&
+          m_read(&winding))
+      {
+        dc = t_dcs->emplace<Path>(line, fill, std::move(points),
+                                  std::move(nper), winding != 0);
+      }
+      break;
+    }
+    case tag::raster:
+    {
+      std::vector<unsigned int> raster;
+      gvertex<int> wh;
+      grect<double> rect;
+      double rot;
+      uint8_t interpolate;
+      if (m_read(&raster) && m_read(&wh) && m_read(&rect) && m_read(&rot) &&
+          m_read(&interpolate))
+      {
+        dc = t_dcs->emplace<Raster>(std::move(raster), wh, rect, rot,
+                                    interpolate != 0);
+      }
+      break;
+    }
+    case tag::circle_run:
+    {
+      CircleRun run;
+      if (m_read_styles(&run.styles) && m_read(&run.style) && m_read(&run.pos) &&
+          m_read(&run.radius) && run.pos.size() == run.radius.size() &&
+          m_check_run(run, run.pos.size()))
+      {
+        dc = t_dcs->emplace<CircleRun>(std::move(run));
+      }
+      break;
+    }
+    case tag::line_run:
+    {
+      LineRun run;
+      if (m_read_styles(&run.styles) && m_read(&run.style) && m_read(&run.orig) &&
+          m_read(&run.dest) && run.orig.size() == run.dest.size() &&
+          m_check_run(run, run.orig.size()))
+      {
+        dc = t_dcs->emplace<LineRun>(std::move(run));
+      }
+      break;
+    }
+    case tag::rect_run:
+    {
+      RectRun run;
+      if (m_read_styles(&run.styles) && m_read(&run.style) && m_read(&run.rect) &&
+          m_check_run(run, run.rect.size()))
+      {
+        dc = t_dcs->emplace<RectRun>(std::move(run));
+      }
+      break;
+    }
+    default:
+      break;
+  }
+
+  if (!dc)
+  {
+    m_failed = true;
+    return false;
+  }
+  dc->clip_id = clip_id;
+  return true;
+}
+
+}  // namespace codec
+}  // namespace renderers
+}  // namespace unigd
@@ -0,0 +1,88 @@
+#ifndef __UNIGD_PAGE_CODEC_H__
+#define __UNIGD_PAGE_CODEC_H__
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "draw_data.h"
+
+namespace unigd
+{
+namespace renderers
+{
+// Compact binary encoding of draw calls and clip regions.
+//
+// Numbers are stored in host byte order, the encoding is meant for data that does not
+// leave the machine (spill files, in-process streams).
+namespace codec
+{
+// Appends the encoding of a single draw call.
+void encode(const DrawCall& t_dc, std::vector<uint8_t>* t_out);
+// Appends the encoding of a clip region.
+void encode(const Clip& t_clip, std::vector<uint8_t>* t_out);
+// Appends the encoding of a style table.
+void encode(const style_table& t_styles, std::vector<uint8_t>* t_out);
+
+// Encodes clip regions, styles, the culled draw call count and draw calls of a page.
+void encode_page(const Page& t_page, std::vector<uint8_t>* t_out);
+// Replaces clip regions, styles and draw calls of the page with the decoded content.
+// Returns false (and leaves the page cleared) if the data is malformed.
+bool decode_page(const uint8_t* t_buf, std::size_t t_size, Page* t_page);
+
+// Encodes a page like encode_page(), but only the draw calls from list position t_from
+// on and the clip regions they may refer to. The style table is always complete.
+void encode_delta(const Page& t_page, std::size_t t_from, std::vector<uint8_t>* t_out);
+// Appends the draw calls of a delta to a page that holds the draw calls before it, adds
+// its new clip regions and replaces the style table. Returns false (and leaves the page
+// unchanged) if the data is malformed.
+bool decode_delta(const uint8_t* t_buf, std::size_t t_size, Page* t_page);
+
+class reader
+{
+ public:
+  reader(const uint8_t* t_buf, std::size_t t_size);
+
+  bool done() const;
+  bool failed() const;
+
+  bool page_header();
+  bool count(uint32_t* t_count);
+  bool clip(Clip* t_clip);
+  // Replaces the content of the table. Draw calls read afterwards may only refer to
+  // these styles.
+  bool styles(style_table* t_styles);
+  // Decodes the next draw call and appends it to the list. Fails for draw calls that
+  // refer to a clip region at or beyond t_clips.
+  bool draw_call(draw_call_list* t_dcs, std::size_t t_clips);
+
+ private:
+  const uint8_t* m_pos;
+  const uint8_t* m_end;
+  bool m_failed = false;
+  std::size_t m_lines = 0;
+  std::size_t m_texts = 0;
+
+  template <class T>
+  bool m_read(T* t_value);
+  bool m_read(std::string* t_value);
+  template <class T>
+  bool m_read(std::vector<T>* t_value);
+  bool m_read(LineInfo* t_value);
+  bool m_read(TextInfo* t_value);
+  bool m_read(ShapeStyle* t_value);
+  bool m_read_line(style_id_t* t_id);
+  bool m_read_text(style_id_t* t_id);
+  template <class S>
+  bool m_read_styles(std::vector<S>* t_styles);
+  bool m_read_styles(std::vector<style_id_t>* t_styles);
+  template <class R>
+  bool m_check_run(const R& t_run, std::size_t t_size);
+};
+}  // namespace codec
+}  // namespace renderers
+}  // namespace unigd
+
+#endif /* __UNIGD_PAGE_CODEC_H__ */
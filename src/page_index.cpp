@@ -0,0 +1,422 @@
+#include "page_index.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <limits>
+#include <utility>
+
+namespace unigd
+{
+namespace renderers
+{
+namespace
+{
+// Draw calls covering more cells than this are not sorted into the grid.
+constexpr int large_cells = 64;
+// Upper limit of grid cells per side
+constexpr int max_side = 256;
+
+grect<double> intersection(const grect<double>& t_a, const grect<double>& t_b)
+{
+  const double x0 = std::max(t_a.x, t_b.x);
+  const double y0 = std::max(t_a.y, t_b.y);
+  const double x1 = std::min(t_a.x + t_a.width, t_b.x + t_b.width);
+  const double y1 = std::min(t_a.y + t_a.height, t_b.y + t_b.height);
+  if (!(x0 <= x1) || !(y0 <= y1))
+  {
+    // Never visible, never intersects anything
+    const double nan = std::numeric_limits<double>::quiet_NaN();
+    return {nan, nan, nan, nan};
+  }
+  return {x0, y0, x1 - x0, y1 - y0};
+}
+
+bool is_finite(const grect<double>& t_rect)
+{
+  return std::isfinite(t_rect.x) && std::isfinite(t_rect.y) &&
+         std::isfinite(t_rect.width) && std::isfinite(t_rect.height);
+}
+
+// Collects the visible bounds of every draw call, runs element by element.
+class bounds_visitor : public draw_call_visitor
+{
+ public:
+  bounds_visitor(const Page& t_page, std::vector<grect<double>>* t_out)
+      : m_page(t_page), m_out(t_out)
+  {
+  }
+
+  void visit(const Rect* t_rect) override { m_put(t_rect); }
+  void visit(const Text* t_text) override { m_put(t_text); }
+  void visit(const Circle* t_circle) override { m_put(t_circle); }
+  void visit(const Line* t_line) override { m_put(t_line); }
+  void visit(const Polyline* t_polyline) override { m_put(t_polyline); }
+  void visit(const Polygon* t_polygon) override { m_put(t_polygon); }
+  void visit(const Path* t_path) override { m_put(t_path); }
+  void visit(const Raster* t_raster) override { m_put(t_raster); }
+
+ private:
+  const Page& m_page;
+  std::vector<grect<double>>* m_out;
+
+  void m_put(const DrawCall* t_dc)
+  {
+    auto bounds = t_dc->bounds(m_page.styles);
+    if (static_cast<std::size_t>(t_dc->clip_id) < m_page.cps.size())
+    {
+      bounds = intersection(bounds, m_page.cps[t_dc->clip_id].rect);
+    }
+    m_out->push_back(bounds);
+  }
+};
+
+// Copies the selected draw calls, moved by -t_offset.
+class region_visitor : public draw_call_visitor
+{
+ public:
+  region_visitor(const std::vector<std::size_t>& t_selected, gvertex<double> t_offset,
+                 draw_call_list* t_out)
+      : m_next(t_selected.begin()),
+        m_end(t_selected.end()),
+        m_offset(t_offset),
+        m_out(t_out)
+  {
+  }
+
+  void visit(const Rect* t_rect) override
+  {
+    if (m_take())
+    {
+      auto* dc = m_out->emplace<Rect>(*t_rect);
+      dc->rect.x -= m_offset.x;
+      dc->rect.y -= m_offset.y;
+    }
+  }
+
+  void visit(const Text* t_text) override
+  {
+    if (m_take())
+    {
+      m_move(&m_out->emplace<Text>(*t_text)->pos);
+    }
+  }
+
+  void visit(const Circle* t_circle) override
+  {
+    if (m_take())
+    {
+      m_move(&m_out->emplace<Circle>(*t_circle)->pos);
+    }
+  }
+
+  void visit(const Line* t_line) override
+  {
+    if (m_take())
+    {
+      auto* dc = m_out->emplace<Line>(*t_line);
+      m_move(&dc->orig);
+      m_move(&dc->dest);
+    }
+  }
+
+  void visit(const Polyline* t_polyline) override
+  {
+    if (m_take())
+    {
+      m_move(&m_out->emplace<Polyline>(*t_polyline)->points);
+    }
+  }
+
+  void visit(const Polygon* t_polygon) override
+  {
+    if (m_take())
+    {
+      m_move(&m_out->emplace<Polygon>(*t_polygon)->points);
+    }
+  }
+
+  void visit(const Path* t_path) override
+  {
+    if (m_take())
+    {
+      m_move(&m_out->emplace<Path>(*t_path)->points);
+    }
+  }
+
+  void visit(const Raster* t_raster) override
+  {
+    if (m_take())
+    {
+      auto* dc = m_out->emplace<Raster>(*t_raster);
+      dc->rect.x -= m_offset.x;
+      dc->rect.y -= m_offset.y;
+    }
+  }
+
+  // Only the selected elements of runs are looked at. They are copied as single draw
+  // calls, merging them again could mix up clip rectangles.
+  void visit(const CircleRun* t_run) override { m_run(t_run); }
+  void visit(const LineRun* t_run) override { m_run(t_run); }
+  void visit(const RectRun* t_run) override { m_run(t_run); }
+
+ private:
+  std::vector<std::size_t>::const_iterator m_next;
+  std::vector<std::size_t>::const_iterator m_end;
+  std::size_t m_counter = 0;
+  gvertex<double> m_offset;
+  draw_call_list* m_out;
+
+  bool m_take()
+  {
+    const bool take = m_next != m_end && *m_next == m_counter;
+    if (take)
+    {
+      ++m_next;
+    }
+    ++m_counter;
+    return take;
+  }
+
+  template <class T>
+  void m_run(const T* t_run)
+  {
+    const std::size_t end = m_counter + t_run->size();
+    while (m_next != m_end && *m_next < end)
+    {
+      const auto element = t_run->at(*m_next - m_counter);
+      m_counter = *m_next;
+      visit(&element);
+    }
+    m_counter = end;
+  }
+
+  void m_move(gvertex<double>* t_vertex) const
+  {
+    t_vertex->x -= m_offset.x;
+    t_vertex->y -= m_offset.y;
+  }
+
+  void m_move(std::vector<gvertex<double>>* t_points) const
+  {
+    for (auto& p : *t_points)
+    {
+      m_move(&p);
+    }
+  }
+};
+}  // namespace
+
+page_index::page_index(const Page& t_page)
+{
+  bounds_visitor visitor(t_page, &m_bounds);
+  for (const auto* dc : t_page.dcs)
+  {
+    dc->visit(&visitor);
+  }
+
+  // Cells should hold a few draw calls each, but should not be much smaller than the
+  // average draw call either (or every draw call would be stored in many cells).
+  gvertex<double> mean{0, 0};
+  std::size_t finite = 0;
+  for (const auto& b : m_bounds)
+  {
+    if (is_finite(b))
+    {
+      mean.x += std::min(b.width, t_page.size.x);
+      mean.y += std::min(b.height, t_page.size.y);
+      ++finite;
+    }
+  }
+  const double side = std::ceil(std::sqrt(finite / 4.0));
+  auto count = [&](double t_page_size, double t_mean)
+  {
+    const double cell = std::max(t_page_size / side, finite ? t_mean / finite : 0.0);
+    const double n = std::ceil(t_page_size / cell);
+    return static_cast<int>(std::min<double>(max_side, n >= 1 ? n : 1));
+  };
+  m_cols = count(t_page.size.x, mean.x);
+  m_rows = count(t_page.size.y, mean.y);
+  m_cell_size = {t_page.size.x / m_cols, t_page.size.y / m_rows};
+  if (!(m_cell_size.x > 0) || !std::isfinite(m_cell_size.x))
+  {
+    m_cell_size.x = 1;
+  }
+  if (!(m_cell_size.y > 0) || !std::isfinite(m_cell_size.y))
+  {
+    m_cell_size.y = 1;
+  }
+
+  // Count, then fill (compressed rows)
+  m_cell_start.assign(static_cast<std::size_t>(m_cols) * m_rows + 1, 0);
+  int x0, y0, x1, y1;
+  for (std::size_t i = 0; i != m_bounds.size(); ++i)
+  {
+    if (!m_cells(m_bounds[i], &x0, &y0, &x1, &y1))
+    {
+      continue;
+    }
+    if ((x1 - x0 + 1) * (y1 - y0 + 1) > large_cells)
+    {
+      m_large.push_back(static_cast<uint32_t>(i));
+      continue;
+    }
+    for (int y = y0; y <= y1; ++y)
+    {
+      for (int x = x0; x <= x1; ++x)
+      {
+        m_cell_start[y * m_cols + x + 1]++;
+      }
+    }
+  }
+  for (std::size_t c = 1; c != m_cell_start.size(); ++c)
+  {
+    m_cell_start[c] += m_cell_start[c - 1];
+  }
+  m_entries.resize(m_cell_start.back());
+  std::vector<uint32_t> fill(m_cell_start.begin(), m_cell_start.end() - 1);
+  std::size_t large = 0;
+  for (std::size_t i = 0; i != m_bounds.size(); ++i)
+  {
+    if (!m_cells(m_bounds[i], &x0, &y0, &x1, &y1))
+    {
+      continue;
+    }
+    if (large != m_large.size() && m_large[large] == i)
+    {
+      ++large;
+      continue;
+    }
+    for (int y = y0; y <= y1; ++y)
+    {
+      for (int x = x0; x <= x1; ++x)
+      {
+        m_entries[fill[y * m_cols + x]++] = static_cast<uint32_t>(i);
+      }
+    }
+  }
+}
+
+bool page_index::m_cells(const grect<double>& t_rect, int* t_x0, int* t_y0, int* t_x1,
+                         int* t_y1) const
+{
+  if (!is_finite(t_rect))
+  {
+    return false;
+  }
+  auto cell = [](double t_pos, double t_size, int t_count)
+  {
+    return static_cast<int>(
+        std::min<double>(t_count - 1, std::max(0.0, std::floor(t_pos / t_size))));
+  };
+  *t_x0 = cell(t_rect.x, m_cell_size.x, m_cols);
+  *t_y0 = cell(t_rect.y, m_cell_size.y, m_rows);
+  *t_x1 = cell(t_rect.x + t_rect.width, m_cell_size.x, m_cols);
+  *t_y1 = cell(t_rect.y + t_rect.height, m_cell_size.y, m_rows);
+  return true;
+}
+
+std::vector<std::size_t> page_index::query(const grect<double>& t_rect) const
+{
+  std::vector<std::size_t> result;
+  int x0, y0, x1, y1;
+  if (!m_cells(t_rect, &x0, &y0, &x1, &y1))
+  {
+    return result;
+  }
+  for (int y = y0; y <= y1; ++y)
+  {
+    for (int x = x0; x <= x1; ++x)
+    {
+      const auto c = static_cast<std::size_t>(y * m_cols + x);
+      for (auto e = m_cell_start[c]; e != m_cell_start[c + 1]; ++e)
+      {
+        if (rect_intersects(m_bounds[m_entries[e]], t_rect))
+        {
+          result.push_back(m_entries[e]);
+        }
+      }
+    }
+  }
+  // Draw calls spanning several cells are found more than once
+  std::sort(result.begin(), result.end());
+  result.erase(std::unique(result.begin(), result.end()), result.end());
+
+  const auto middle = result.size();
+  for (const auto i : m_large)
+  {
+    if (rect_intersects(m_bounds[i], t_rect))
+    {
+      result.push_back(i);
+    }
+  }
+  std::inplace_merge(result.begin(), result.begin() + middle, result.end());
+  return result;
+}
+
+std::size_t page_index::mem_size() const
+{
+  return m_bounds.capacity() * sizeof(grect<double>) +
+         (m_cell_start.capacity() + m_entries.capacity() + m_large.capacity()) *
+             sizeof(uint32_t);
+}
+
+std::shared_ptr<const page_index> Page::index() const
+{
+  // Two readers may race to build the index, both results are the same.
+  auto index = std::atomic_load(&m_index);
+  if (!index)
+  {
+    index = std::make_shared<const page_index>(*this);
+    std::atomic_store(&m_index, index);
+  }
+  return index;
+}
+
+void copy_region(const Page& t_page, const grect<double>& t_region, Page* t_out)
+{
+  t_out->clear();
+  t_out->id = t_page.id;
+  t_out->size = {t_region.width, t_region.height};
+  t_out->fill = t_page.fill;
+  t_out->styles = t_page.styles;
+  t_out->cps = t_page.cps;
+  for (auto& cp : t_out->cps)
+  {
+    cp.rect.x -= t_region.x;
+    cp.rect.y -= t_region.y;
+  }
+
+  const auto selected = t_page.index()->query(t_region);
+  region_visitor visitor(selected, {t_region.x, t_region.y}, &t_out->dcs);
+  for (const auto* dc : t_page.dcs)
+  {
+    dc->visit(&visitor);
+  }
+}
+
+region_target::region_target(std::unique_ptr<render_target> t_target,
+                             grect<double> t_region)
+    : m_target(std::move(t_target)), m_region(t_region)
+{
+}
+
+void region_target::render(const Page& t_page, double t_scale)
+{
+  Page page(t_page.id, {m_region.width, m_region.height});
+  copy_region(t_page, m_region, &page);
+  m_target->render(page, t_scale);
+}
+
+void region_target::get_data(const uint8_t** t_buf, size_t* t_size) const
+{
+  m_target->get_data(t_buf, t_size);
+}
+
+void region_target::raster_threads(unsigned t_threads)
+{
+  m_target->raster_threads(t_threads);
+}
+
+}  // namespace renderers
+}  // namespace unigd
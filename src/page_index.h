@@ -0,0 +1,75 @@
+#ifndef __UNIGD_PAGE_INDEX_H__
+#define __UNIGD_PAGE_INDEX_H__
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "renderers.h"
+
+namespace unigd
+{
+namespace renderers
+{
+// Spatial index over the draw calls of a page.
+//
+// Draw calls are numbered in drawing order, counting every element of primitive runs
+// (the same way Page::draw_call_count() does). The bounding box of every draw call,
+// clipped to its clip rectangle, is sorted into a uniform grid over the page. Boxes
+// that span many cells are kept in a separate list that is checked on every query.
+//
+// The index is immutable once built, see Page::index().
+class page_index
+{
+ public:
+  explicit page_index(const Page& t_page);
+
+  // Numbers of the draw calls whose bounding box intersects t_rect (in page
+  // coordinates), in drawing order.
+  std::vector<std::size_t> query(const grect<double>& t_rect) const;
+
+  std::size_t size() const { return m_bounds.size(); }
+  const grect<double>& bounds(std::size_t t_index) const { return m_bounds[t_index]; }
+  // Approximate memory held by the index (in bytes)
+  std::size_t mem_size() const;
+
+ private:
+  std::vector<grect<double>> m_bounds;
+  gvertex<double> m_cell_size;
+  int m_cols = 1;
+  int m_rows = 1;
+  // Draw calls of cell c are m_entries[m_cell_start[c]] to m_entries[m_cell_start[c+1]]
+  std::vector<uint32_t> m_cell_start;
+  std::vector<uint32_t> m_entries;
+  std::vector<uint32_t> m_large;
+
+  // Range of cells covered by t_rect, returns false for rects that are not finite.
+  bool m_cells(const grect<double>& t_rect, int* t_x0, int* t_y0, int* t_x1,
+               int* t_y1) const;
+};
+
+// Copies the draw calls that intersect t_region into t_out, moved so that the top left
+// corner of the region becomes the origin. t_out gets the size of the region.
+void copy_region(const Page& t_page, const grect<double>& t_region, Page* t_out);
+
+// Render target that renders only a sub-rectangle (given in page coordinates) of the
+// page, using the spatial index of the page to find the draw calls inside.
+class region_target : public render_target
+{
+ public:
+  region_target(std::unique_ptr<render_target> t_target, grect<double> t_region);
+
+  void render(const Page& t_page, double t_scale) override;
+  void get_data(const uint8_t** t_buf, size_t* t_size) const override;
+  void raster_threads(unsigned t_threads) override;
+
+ private:
+  std::unique_ptr<render_target> m_target;
+  grect<double> m_region;
+};
+
+}  // namespace renderers
+}  // namespace unigd
+
+#endif /* __UNIGD_PAGE_INDEX_H__ */
@@ -0,0 +1,381 @@
+#include "page_lod.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <unordered_set>
+#include <utility>
+
+namespace unigd
+{
+namespace renderers
+{
+namespace lod
+{
+namespace
+{
+enum class shape
+{
+  monotonic_x,
+  other,
+  not_finite
+};
+
+shape classify(const gvertex<double>* t_points, std::size_t t_size)
+{
+  bool inc = true;
+  bool dec = true;
+  for (std::size_t i = 0; i != t_size; ++i)
+  {
+    if (!std::isfinite(t_points[i].x) || !std::isfinite(t_points[i].y))
+    {
+      return shape::not_finite;
+    }
+    if (i != 0)
+    {
+      inc = inc && t_points[i].x >= t_points[i - 1].x;
+      dec = dec && t_points[i].x <= t_points[i - 1].x;
+    }
+  }
+  return (inc || dec) ? shape::monotonic_x : shape::other;
+}
+
+inline double dist2(gvertex<double> t_a, gvertex<double> t_b)
+{
+  const double dx = t_a.x - t_b.x;
+  const double dy = t_a.y - t_b.y;
+  return dx * dx + dy * dy;
+}
+
+// Squared distance of t_p to the segment from t_a to t_b.
+inline double segment_dist2(gvertex<double> t_p, gvertex<double> t_a,
+                            gvertex<double> t_b)
+{
+  const double dx = t_b.x - t_a.x;
+  const double dy = t_b.y - t_a.y;
+  const double len2 = dx * dx + dy * dy;
+  if (len2 == 0)
+  {
+    return dist2(t_p, t_a);
+  }
+  const double t =
+      std::min(1.0, std::max(0.0, ((t_p.x - t_a.x) * dx + (t_p.y - t_a.y) * dy) / len2));
+  return dist2(t_p, {t_a.x + t * dx, t_a.y + t * dy});
+}
+
+// Keeps the first, lowest, highest and last vertex of every column.
+void simplify_columns(const gvertex<double>* t_points, std::size_t t_size,
+                      double t_width, std::vector<gvertex<double>>* t_out)
+{
+  const double x0 = t_points[0].x;
+  std::size_t idx[4] = {0, 0, 0, 0};  // first, min, max, last
+  auto column = [&](std::size_t i)
+  { return std::floor(std::fabs(t_points[i].x - x0) / t_width); };
+  auto flush = [&]()
+  {
+    std::sort(idx, idx + 4);
+    for (std::size_t k = 0; k != 4; ++k)
+    {
+      if (k == 0 || idx[k] != idx[k - 1])
+      {
+        t_out->push_back(t_points[idx[k]]);
+      }
+    }
+  };
+
+  double col = column(0);
+  for (std::size_t i = 1; i != t_size; ++i)
+  {
+    const double c = column(i);
+    if (c != col)
+    {
+      flush();
+      col = c;
+      idx[0] = idx[1] = idx[2] = i;
+    }
+    if (t_points[i].y < t_points[idx[1]].y)
+    {
+      idx[1] = i;
+    }
+    if (t_points[i].y > t_points[idx[2]].y)
+    {
+      idx[2] = i;
+    }
+    idx[3] = i;
+  }
+  flush();
+}
+
+// Drops vertices closer than the tolerance to the last kept vertex, then runs
+// Douglas-Peucker on the remaining ones.
+void simplify_dp(const gvertex<double>* t_points, std::size_t t_size, double t_tolerance,
+                 std::vector<gvertex<double>>* t_out)
+{
+  const double tol2 = t_tolerance * t_tolerance;
+
+  std::vector<std::size_t> idx;
+  idx.push_back(0);
+  for (std::size_t i = 1; i + 1 < t_size; ++i)
+  {
+    if (dist2(t_points[i], t_points[idx.back()]) > tol2)
+    {
+      idx.push_back(i);
+    }
+  }
+  idx.push_back(t_size - 1);
+
+  std::vector<bool> keep(idx.size(), false);
+  keep.front() = true;
+  keep.back() = true;
+  std::vector<std::pair<std::size_t, std::size_t>> stack;
+  stack.emplace_back(0, idx.size() - 1);
+  while (!stack.empty())
+  {
+    const auto range = stack.back();
+    stack.pop_back();
+    double max_d2 = tol2;
+    std::size_t max_k = range.first;
+    for (std::size_t k = range.first + 1; k < range.second; ++k)
+    {
+      const double d2 = segment_dist2(t_points[idx[k]], t_points[idx[range.first]],
+                                      t_points[idx[range.second]]);
+      if (d2 > max_d2)
+      {
+        max_d2 = d2;
+        max_k = k;
+      }
+    }
+    if (max_k != range.first)
+    {
+      keep[max_k] = true;
+      stack.emplace_back(range.first, max_k);
+      stack.emplace_back(max_k, range.second);
+    }
+  }
+
+  for (std::size_t k = 0; k != idx.size(); ++k)
+  {
+    if (keep[k])
+    {
+      t_out->push_back(t_points[idx[k]]);
+    }
+  }
+}
+
+struct circle_key
+{
+  int64_t x, y, r;
+  uint64_t style;
+  clip_id_t clip;
+
+  bool operator==(const circle_key& t_other) const
+  {
+    return x == t_other.x && y == t_other.y && r == t_other.r &&
+           style == t_other.style && clip == t_other.clip;
+  }
+};
+
+struct circle_key_hash
+{
+  std::size_t operator()(const circle_key& t_key) const
+  {
+    std::size_t h = std::hash<int64_t>()(t_key.x);
+    for (const std::size_t v :
+         {std::hash<int64_t>()(t_key.y), std::hash<int64_t>()(t_key.r),
+          std::hash<uint64_t>()(t_key.style), std::hash<clip_id_t>()(t_key.clip)})
+    {
+      h ^= v + 0x9e3779b9 + (h << 6) + (h >> 2);
+    }
+    return h;
+  }
+};
+
+class lod_visitor : public draw_call_visitor
+{
+ public:
+  lod_visitor(double t_tolerance, draw_call_list* t_out)
+      : m_tolerance(t_tolerance), m_out(t_out)
+  {
+  }
+
+  void visit(const Rect* t_rect) override { m_copy(t_rect); }
+  void visit(const Text* t_text) override { m_copy(t_text); }
+  void visit(const Line* t_line) override { m_copy(t_line); }
+  void visit(const Raster* t_raster) override { m_copy(t_raster); }
+  void visit(const LineRun* t_run) override { m_copy(t_run); }
+  void visit(const RectRun* t_run) override { m_copy(t_run); }
+
+  void visit(const Circle* t_circle) override
+  {
+    if (m_seen(t_circle->pos, t_circle->radius, t_circle->line, t_circle->fill,
+               t_circle->clip_id))
+    {
+      return;
+    }
+    m_out->emplace<Circle>(*t_circle);
+  }
+
+  void visit(const CircleRun* t_run) override
+  {
+    auto* run = m_out->emplace<CircleRun>();
+    run->clip_id = t_run->clip_id;
+    run->styles = t_run->styles;
+    for (std::size_t i = 0; i != t_run->size(); ++i)
+    {
+      const auto& s = t_run->styles[t_run->style[i]];
+      if (!m_seen(t_run->pos[i], t_run->radius[i], s.line, s.fill, t_run->clip_id))
+      {
+        run->style.push_back(t_run->style[i]);
+        run->pos.push_back(t_run->pos[i]);
+        run->radius.push_back(t_run->radius[i]);
+      }
+    }
+    if (run->size() == 0)
+    {
+      m_out->pop_back();
+    }
+  }
+
+  void visit(const Polyline* t_polyline) override
+  {
+    std::vector<gvertex<double>> points;
+    m_simplify(t_polyline->points.data(), t_polyline->points.size(), false, &points);
+    auto* dc = m_out->emplace<Polyline>(t_polyline->line, std::move(points));
+    dc->clip_id = t_polyline->clip_id;
+  }
+
+  void visit(const Polygon* t_polygon) override
+  {
+    std::vector<gvertex<double>> points;
+    m_simplify(t_polygon->points.data(), t_polygon->points.size(), true, &points);
+    auto* dc =
+        m_out->emplace<Polygon>(t_polygon->line, t_polygon->fill, std::move(points));
+    dc->clip_id = t_polygon->clip_id;
+  }
+
+  void visit(const Path* t_path) override
+  {
+    std::vector<gvertex<double>> points;
+    std::vector<int> nper;
+    std::size_t offset = 0;
+    for (const int n : t_path->nper)
+    {
+      const auto size = points.size();
+      m_simplify(t_path->points.data() + offset, n, true, &points);
+      nper.push_back(static_cast<int>(points.size() - size));
+      offset += n;
+    }
+    auto* dc = m_out->emplace<Path>(t_path->line, t_path->fill, std::move(points),
+                                    std::move(nper), t_path->winding);
+    dc->clip_id = t_path->clip_id;
+  }
+
+ private:
+  double m_tolerance;
+  draw_call_list* m_out;
+  // Circles drawn since the last draw call of a different type
+  std::unordered_set<circle_key, circle_key_hash> m_circles;
+
+  template <class T>
+  void m_copy(const T* t_dc)
+  {
+    m_circles.clear();
+    m_out->emplace<T>(*t_dc);
+  }
+
+  void m_simplify(const gvertex<double>* t_points, std::size_t t_size, bool t_ring,
+                  std::vector<gvertex<double>>* t_out)
+  {
+    m_circles.clear();
+    simplify(t_points, t_size, m_tolerance, t_ring, t_out);
+  }
+
+  bool m_seen(gvertex<double> t_pos, double t_radius, style_id_t t_line, color_t t_fill,
+              clip_id_t t_clip)
+  {
+    const double cell = 2 * m_tolerance;
+    if (!(cell > 0) || !std::isfinite(t_pos.x) || !std::isfinite(t_pos.y) ||
+        !std::isfinite(t_radius))
+    {
+      return false;
+    }
+    const circle_key key{std::llround(t_pos.x / cell), std::llround(t_pos.y / cell),
+                         std::llround(t_radius / cell),
+                         (static_cast<uint64_t>(t_line) << 32) |
+                             static_cast<uint32_t>(t_fill),
+                         t_clip};
+    return !m_circles.insert(key).second;
+  }
+};
+}  // namespace
+
+void simplify(const gvertex<double>* t_points, std::size_t t_size, double t_tolerance,
+              bool t_ring, std::vector<gvertex<double>>* t_out)
+{
+  const auto size = t_out->size();
+  const auto kind = classify(t_points, t_size);
+  if (t_size <= 2 || !(t_tolerance > 0) || kind == shape::not_finite)
+  {
+    t_out->insert(t_out->end(), t_points, t_points + t_size);
+    return;
+  }
+  // Columns would turn rings (e.g. narrow bars) into triangles.
+  if (kind == shape::monotonic_x && !t_ring)
+  {
+    simplify_columns(t_points, t_size, 2 * t_tolerance, t_out);
+  }
+  else
+  {
+    simplify_dp(t_points, t_size, t_tolerance, t_out);
+  }
+  // Do not collapse rings into lines.
+  if (t_ring && t_out->size() - size < 3)
+  {
+    t_out->resize(size);
+    t_out->insert(t_out->end(), t_points, t_points + t_size);
+  }
+}
+
+void simplify_page(const Page& t_page, double t_tolerance, Page* t_out)
+{
+  t_out->clear();
+  t_out->id = t_page.id;
+  t_out->size = t_page.size;
+  t_out->fill = t_page.fill;
+  t_out->cps = t_page.cps;
+  t_out->styles = t_page.styles;
+  t_out->culled = t_page.culled;
+
+  lod_visitor visitor(t_tolerance, &t_out->dcs);
+  for (const auto* dc : t_page.dcs)
+  {
+    dc->visit(&visitor);
+  }
+}
+}  // namespace lod
+
+lod_target::lod_target(std::unique_ptr<render_target> t_target, double t_tolerance_px)
+    : m_target(std::move(t_target)), m_tolerance_px(t_tolerance_px)
+{
+}
+
+void lod_target::render(const Page& t_page, double t_scale)
+{
+  Page page(t_page.id, t_page.size);
+  lod::simplify_page(t_page, t_scale > 0 ? m_tolerance_px / t_scale : 0, &page);
+  m_target->render(page, t_scale);
+}
+
+void lod_target::get_data(const uint8_t** t_buf, size_t* t_size) const
+{
+  m_target->get_data(t_buf, t_size);
+}
+
+void lod_target::raster_threads(unsigned t_threads)
+{
+  m_target->raster_threads(t_threads);
+}
+
+}  // namespace renderers
+}  // namespace unigd
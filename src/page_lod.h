@@ -0,0 +1,60 @@
+#ifndef __UNIGD_PAGE_LOD_H__
+#define __UNIGD_PAGE_LOD_H__
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+#include "renderers.h"
+
+namespace unigd
+{
+namespace renderers
+{
+// Level of detail
+//
+// Plots of huge data sets often contain far more detail than the output can show: a
+// polyline through a million samples covers a few hundred pixel columns. The functions
+// below simplify a page to a given tolerance (in page units) before it is rendered:
+//
+// - Polyline, polygon and path vertices are reduced. Polylines that are monotonic in x
+//   (time series) keep the first, lowest, highest and last vertex of every column of
+//   width 2 * tolerance, everything else (including all polygons and subpaths, which
+//   would lose their shape) is simplified with Douglas-Peucker.
+// - Consecutive circles that snap to the same cell of size 2 * tolerance with the same
+//   radius and style are drawn only once.
+//
+// All other draw calls are copied unchanged.
+namespace lod
+{
+// Appends the simplified vertices to t_out. Rings (polygons and subpaths) keep at least
+// 3 vertices.
+void simplify(const gvertex<double>* t_points, std::size_t t_size, double t_tolerance,
+              bool t_ring, std::vector<gvertex<double>>* t_out);
+
+// Replaces the content of t_out with the simplified copy of t_page.
+void simplify_page(const Page& t_page, double t_tolerance, Page* t_out);
+}  // namespace lod
+
+// Render target that simplifies pages to the output resolution before passing them on.
+//
+// The tolerance is given in output pixels and converted to page units with the scale
+// of each render call.
+class lod_target : public render_target
+{
+ public:
+  lod_target(std::unique_ptr<render_target> t_target, double t_tolerance_px);
+
+  void render(const Page& t_page, double t_scale) override;
+  void get_data(const uint8_t** t_buf, size_t* t_size) const override;
+  void raster_threads(unsigned t_threads) override;
+
+ private:
+  std::unique_ptr<render_target> m_target;
+  double m_tolerance_px;
+};
+
+}  // namespace renderers
+}  // namespace unigd
+
+#endif /* __UNIGD_PAGE_LOD_H__ */
@@ -1,15 +1,46 @@
 
 #include "page_store.h"
 
+#include <algorithm>
 #include <cmath>
+#include <cstdio>
+#include <fstream>
 #include <iostream>
+#include <utility>
 
+#include "mapped_file.h"
+#include "page_codec.h"
+#include "page_index.h"
 #include "unigd_commons.h"
+#include "uuid.h"
 
 // Do not include any R headers here!
 
 namespace unigd
 {
+page_store::page_slot::page_slot(renderers::Page&& t_page) : page(std::move(t_page)) {}
+
+page_store::page_slot::~page_slot()
+{
+  if (!spill_file.empty())
+  {
+    std::remove(spill_file.c_str());
+  }
+}
+
+page_store::page_store(std::size_t t_memory_budget, std::string t_spill_dir)
+    : m_memory_budget(t_memory_budget)
+    , m_spill_dir(std::move(t_spill_dir))
+    , m_spill_prefix(m_spill_dir.empty() ? ""
+                                         : m_spill_dir + "/unigd-" + uuid::uuid() + "-")
+{
+}
+
+page_store::page_handle::page_handle(std::shared_ptr<page_slot> t_slot)
+    : m_slot(std::move(t_slot)), m_lock(m_slot->mutex)
+{
+}
+
 inline bool page_store::m_valid_index(ex::plot_relative_t t_index)
 {
   const auto psize = static_cast<ex::plot_relative_t>(m_pages.size());
@@ -21,79 +52,224 @@ inline std::size_t page_store::m_index_to_pos(ex::plot_relative_t t_index)
   return (t_index < 0 ? (m_pages.size() + t_index) : t_index);
 }
 
-std::experimental::optional<ex::plot_relative_t> page_store::normalize_index(
-    ex::plot_relative_t t_index)
+std::shared_ptr<page_store::page_slot> page_store::m_slot(ex::plot_relative_t t_index)
 {
   const std::shared_lock<std::shared_timed_mutex> r_lock(m_store_mutex);
   if (!m_valid_index(t_index))
   {
-    return std::experimental::nullopt;
+    return nullptr;
   }
-  return m_index_to_pos(t_index);
+  return m_pages[m_index_to_pos(t_index)];
 }
 
-ex::plot_index_t page_store::append(gvertex<double> t_size)
+page_store::page_handle page_store::pin(ex::plot_relative_t t_index)
 {
-  const std::unique_lock<std::shared_timed_mutex> w_lock(m_store_mutex);
-  m_pages.emplace_back(unigd::renderers::Page{m_id_counter, t_size});
+  auto slot = m_slot(t_index);
+  if (!slot)
+  {
+    return {};
+  }
+  return page_handle(std::move(slot));
+}
 
-  m_id_counter = incwrap(m_id_counter);
+page_store::page_handle page_store::m_use(ex::plot_relative_t t_index)
+{
+  auto slot = m_slot(t_index);
+  if (!slot)
+  {
+    return {};
+  }
+  slot->last_used = ++m_use_counter;
 
-  return static_cast<ex::plot_index_t>(m_pages.size() - 1);
+  page_handle handle(slot);
+  // Spilled pages are loaded back transparently
+  while (handle.spilled())
+  {
+    handle = page_handle();
+    {
+      const std::unique_lock<std::shared_timed_mutex> p_lock(slot->mutex);
+      m_load(*slot);
+    }
+    m_evict(slot.get());
+    handle = page_handle(slot);
+  }
+  return handle;
 }
 
-void page_store::add_dc(ex::plot_relative_t t_index,
-                        std::unique_ptr<renderers::DrawCall>&& t_dc, bool t_silent)
+template <class F>
+void page_store::m_modify(page_slot& t_slot, F&& t_fn)
 {
-  const std::unique_lock<std::shared_timed_mutex> w_lock(m_store_mutex);
-  if (!m_valid_index(t_index))
+  const std::unique_lock<std::shared_timed_mutex> p_lock(t_slot.mutex);
+  const auto before = t_slot.page.mem_size;
+  t_fn(t_slot.page);
+  const auto after = t_slot.page.mem_size;
+  t_slot.version = m_next_version();
+  t_slot.last_used = ++m_use_counter;
+  if (!t_slot.spill_file.empty())
+  {
+    // outdated now
+    std::remove(t_slot.spill_file.c_str());
+    t_slot.spill_file.clear();
+  }
+
+  if (after >= before)
+  {
+    m_mem_size += after - before;
+  }
+  else
+  {
+    m_mem_size -= before - after;
+  }
+}
+
+void page_store::m_release(page_slot& t_slot)
+{
+  const std::unique_lock<std::shared_timed_mutex> p_lock(t_slot.mutex);
+  m_mem_size -= t_slot.page.mem_size;
+  t_slot.page.mem_size = 0;
+}
+
+void page_store::m_evict(const page_slot* t_keep)
+{
+  const auto mem_size = m_mem_size.load();
+  if (m_memory_budget == 0 || mem_size <= m_memory_budget ||
+      mem_size <= m_evict_floor + m_memory_budget / 4)
   {
     return;
   }
-  auto index = m_index_to_pos(t_index);
-  m_pages[index].put(std::move(t_dc));
-  if (!t_silent)
+
+  // Least recently used pages first. The newest page (which R is drawing to) and the
+  // page that has just been written are never evicted.
+  std::vector<std::pair<uint64_t, std::shared_ptr<page_slot>>> candidates;
   {
-    m_inc_upid();
+    const std::shared_lock<std::shared_timed_mutex> r_lock(m_store_mutex);
+    candidates.reserve(m_pages.size());
+    m_pages.for_each(
+        [&](const std::shared_ptr<page_slot>& t_slot)
+        {
+          if (t_slot.get() != t_keep)
+          {
+            candidates.emplace_back(t_slot->last_used.load(), t_slot);
+          }
+        });
+    if (!candidates.empty() && m_pages[m_pages.size() - 1].get() != t_keep)
+    {
+      candidates.pop_back();
+    }
+  }
+  std::sort(candidates.begin(), candidates.end(),
+            [](const auto& a, const auto& b) { return a.first < b.first; });
+
+  // Evict a bit more than needed, so this does not run again with every draw call.
+  const auto target = m_memory_budget - m_memory_budget / 4;
+  for (const auto& candidate : candidates)
+  {
+    if (m_mem_size <= target)
+    {
+      break;
+    }
+    auto& slot = *candidate.second;
+    // Skip pages that are being rendered right now
+    std::unique_lock<std::shared_timed_mutex> p_lock(slot.mutex, std::try_to_lock);
+    if (!p_lock.owns_lock() || slot.evicted || slot.spilled || slot.page.mem_size == 0)
+    {
+      continue;
+    }
+    m_mem_size -= slot.page.mem_size;
+    slot.spilled = m_spill(slot);
+    slot.evicted = !slot.spilled;
+    slot.page.clear();
+    if (slot.evicted)
+    {
+      // The draw calls are gone, renders cached from them must not be served anymore.
+      // (Spilled pages are loaded back unchanged and keep their version.)
+      slot.version = m_next_version();
+    }
+    m_evictions++;
   }
+  // Remember what could not be freed, to not scan all pages again too soon
+  m_evict_floor = m_mem_size.load();
 }
 
-void page_store::add_dc(ex::plot_relative_t t_index,
-                        std::vector<std::unique_ptr<renderers::DrawCall>>&& t_dcs,
-                        bool t_silent)
+std::experimental::optional<ex::plot_relative_t> page_store::normalize_index(
+    ex::plot_relative_t t_index)
 {
-  const std::unique_lock<std::shared_timed_mutex> w_lock(m_store_mutex);
+  const std::shared_lock<std::shared_timed_mutex> r_lock(m_store_mutex);
   if (!m_valid_index(t_index))
   {
-    return;
+    return std::experimental::nullopt;
   }
-  auto index = m_index_to_pos(t_index);
+  return m_index_to_pos(t_index);
+}
+
+ex::plot_index_t page_store::append(gvertex<double> t_size)
+{
+  const std::unique_lock<std::shared_timed_mutex> w_lock(m_store_mutex);
+  // After a wraparound of the id counter, skip ids of pages that still exist
+  while (m_pages.contains(m_id_counter))
+  {
+    m_id_counter = incwrap(m_id_counter);
+  }
+  auto slot = std::make_shared<page_slot>(unigd::renderers::Page{m_id_counter, t_size});
+  slot->version = m_next_version();
+  slot->last_used = ++m_use_counter;
+  m_pages.push_back(m_id_counter, std::move(slot));
+  // The previously newest page may be evicted from now on
+  m_evict_floor = 0;
+
+  m_id_counter = incwrap(m_id_counter);
 
-  m_pages[index].put(std::move(t_dcs));
+  return static_cast<ex::plot_index_t>(m_pages.size() - 1);
+}
+
+void page_store::add_dc(ex::plot_relative_t t_index, renderers::draw_call_list&& t_dcs,
+                        const renderers::style_table& t_styles, bool t_silent)
+{
+  auto slot = m_slot(t_index);
+  if (!slot)
+  {
+    return;
+  }
+  m_modify(*slot,
+           [&](renderers::Page& t_page)
+           {
+             const auto size = t_page.dcs.size();
+             t_page.put(std::move(t_dcs), t_styles);
+             slot->seq_next += t_page.dcs.size() - size;
+           });
   if (!t_silent)
   {
+    const std::unique_lock<std::shared_timed_mutex> w_lock(m_store_mutex);
     m_inc_upid();
   }
+  m_evict(slot.get());
 }
 
 void page_store::clear(ex::plot_relative_t t_index, bool t_silent)
 {
-  const std::unique_lock<std::shared_timed_mutex> w_lock(m_store_mutex);
-  if (!m_valid_index(t_index))
+  auto slot = m_slot(t_index);
+  if (!slot)
   {
     return;
   }
-  auto index = m_index_to_pos(t_index);
-  m_pages[index].clear();
+  m_modify(*slot,
+           [&](renderers::Page& t_page)
+           {
+             t_page.clear();
+             slot->seq_base = ++slot->seq_next;
+             slot->evicted = false;
+             slot->spilled = false;
+           });
   if (!t_silent)
   {
+    const std::unique_lock<std::shared_timed_mutex> w_lock(m_store_mutex);
     m_inc_upid();
   }
 }
 
 bool page_store::remove(ex::plot_relative_t t_index, bool t_silent)
 {
-  const std::unique_lock<std::shared_timed_mutex> w_lock(m_store_mutex);
+  std::unique_lock<std::shared_timed_mutex> w_lock(m_store_mutex);
 
   if (!m_valid_index(t_index))
   {
@@ -101,134 +277,199 @@ bool page_store::remove(ex::plot_relative_t t_index, bool t_silent)
   }
   auto index = m_index_to_pos(t_index);
 
-  m_pages.erase(m_pages.begin() + index);
+  auto slot = m_pages[index];
+  m_pages.erase(index);
   if (!t_silent)  // if it was the last page
   {
     m_inc_upid();
   }
+  w_lock.unlock();
+
+  m_release(*slot);
   return true;
 }
 
 bool page_store::remove_all()
 {
-  const std::unique_lock<std::shared_timed_mutex> w_lock(m_store_mutex);
+  std::unique_lock<std::shared_timed_mutex> w_lock(m_store_mutex);
 
   if (m_pages.empty())
   {
     return false;
   }
-  /*for (auto &p : m_pages)
-  {
-    p.clear();
-  }*/
+  std::vector<std::shared_ptr<page_slot>> slots;
+  slots.reserve(m_pages.size());
+  m_pages.for_each([&](const std::shared_ptr<page_slot>& t_slot)
+                   { slots.push_back(t_slot); });
   m_pages.clear();
   m_inc_upid();
+  w_lock.unlock();
+
+  for (const auto& slot : slots)
+  {
+    m_release(*slot);
+  }
   return true;
 }
 
 void page_store::fill(ex::plot_relative_t t_index, color_t t_fill)
 {
-  const std::unique_lock<std::shared_timed_mutex> w_lock(m_store_mutex);
-  if (!m_valid_index(t_index))
+  auto slot = m_slot(t_index);
+  if (!slot)
   {
     return;
   }
-  auto index = m_index_to_pos(t_index);
-  m_pages[index].fill = t_fill;
+  m_modify(*slot, [&](renderers::Page& t_page) { t_page.fill = t_fill; });
 }
 
 void page_store::resize(ex::plot_relative_t t_index, gvertex<double> t_size)
 {
-  const std::unique_lock<std::shared_timed_mutex> w_lock(m_store_mutex);
-  if (!m_valid_index(t_index))
+  auto slot = m_slot(t_index);
+  if (!slot)
   {
     return;
   }
-  auto index = m_index_to_pos(t_index);
-  m_pages[index].size = t_size;
-  m_pages[index].clear();
+  m_modify(*slot,
+           [&](renderers::Page& t_page)
+           {
+             t_page.size = t_size;
+             t_page.clear();
+             slot->seq_base = ++slot->seq_next;
+             slot->evicted = false;
+             slot->spilled = false;
+           });
 }
 
 unigd::gvertex<double> page_store::size(ex::plot_relative_t t_index)
 {
-  const std::shared_lock<std::shared_timed_mutex> r_lock(m_store_mutex);
-  if (!m_valid_index(t_index))
+  const auto page = pin(t_index);
+  if (!page)
   {
     return {10, 10};
   }
-  auto index = m_index_to_pos(t_index);
-  return m_pages[index].size;
+  return page->size;
 }
 
 void page_store::clip(ex::plot_relative_t t_index, grect<double> t_rect)
 {
-  const std::unique_lock<std::shared_timed_mutex> w_lock(m_store_mutex);
-  if (!m_valid_index(t_index))
+  auto slot = m_slot(t_index);
+  if (!slot)
   {
     return;
   }
-  auto index = m_index_to_pos(t_index);
-  m_pages[index].clip(t_rect);
+  m_modify(*slot, [&](renderers::Page& t_page) { t_page.clip(t_rect); });
 }
 
 bool page_store::render(ex::plot_relative_t t_index, renderers::render_target* t_renderer,
-                        double t_scale)
+                        double t_scale, page_version_t* t_version)
 {
-  const std::unique_lock<std::shared_timed_mutex> w_lock(m_store_mutex);
-  if (!m_valid_index(t_index))
+  // Renderers only read the page, so any number of them may run concurrently. The
+  // store lock is not held while rendering.
+  const auto page = m_use(t_index);
+  // Evicted pages have to be rebuilt by a replay first
+  if (!page || page.evicted())
   {
     return false;
   }
-  auto index = m_index_to_pos(t_index);
-  t_renderer->render(m_pages[index], std::fabs(t_scale));
+  t_renderer->render(*page, std::fabs(t_scale));
+  if (t_version)
+  {
+    *t_version = page.version();
+  }
   return true;
 }
 
+// Replaces unset target dimensions with the page size and checks whether the page
+// has to be replayed to match the target size.
+static bool size_matches(const renderers::Page& t_page, gvertex<double>* t_target_size)
+{
+  // get current state
+  gvertex<double> old_size = t_page.size;
+
+  if (t_target_size->x < 0.1)
+  {
+    t_target_size->x = old_size.x;
+  }
+  if (t_target_size->y < 0.1)
+  {
+    t_target_size->y = old_size.y;
+  }
+
+  // Check if replay needed
+  return std::fabs(t_target_size->x - old_size.x) <= 0.1 &&
+         std::fabs(t_target_size->y - old_size.y) <= 0.1;
+}
+
 bool page_store::render_if_size(ex::plot_relative_t t_index,
                                 renderers::render_target* t_renderer, double t_scale,
-                                gvertex<double> t_target_size)
+                                gvertex<double> t_target_size, page_version_t* t_version)
 {
-  const std::shared_lock<std::shared_timed_mutex> r_lock(m_store_mutex);
-  if (!m_valid_index(t_index))
+  const auto page = m_use(t_index);
+  // Evicted pages have to be rebuilt by a replay first
+  if (!page || page.evicted() || !size_matches(*page, &t_target_size))
   {
     return false;
   }
-  auto index = m_index_to_pos(t_index);
-
-  // get current state
-  gvertex<double> old_size = m_pages[index].size;
 
-  if (t_target_size.x < 0.1)
+  t_renderer->render(*page, std::fabs(t_scale));
+  if (t_version)
   {
-    t_target_size.x = old_size.x;
+    *t_version = page.version();
   }
-  if (t_target_size.y < 0.1)
+  return true;
+}
+
+bool page_store::version_if_size(ex::plot_relative_t t_index,
+                                 gvertex<double>* t_target_size, page_version_t* t_version)
+{
+  const auto page = pin(t_index);
+  if (!page || !size_matches(*page, t_target_size))
   {
-    t_target_size.y = old_size.y;
+    return false;
   }
+  *t_version = page.version();
+  return true;
+}
 
-  // Check if replay needed
-  if (std::fabs(t_target_size.x - old_size.x) > 0.1 ||
-      std::fabs(t_target_size.y - old_size.y) > 0.1)
+bool page_store::hit_test(ex::plot_relative_t t_index, grect<double> t_rect,
+                          std::vector<std::size_t>* t_out)
+{
+  const auto page = m_use(t_index);
+  if (!page || page.evicted())
   {
     return false;
   }
+  *t_out = page->index()->query(t_rect);
+  return true;
+}
 
-  t_renderer->render(m_pages[index], std::fabs(t_scale));
+bool page_store::delta(ex::plot_relative_t t_index, uint64_t t_cursor,
+                       ex::delta_results* t_out)
+{
+  const auto page = m_use(t_index);
+  if (!page || page.evicted())
+  {
+    return false;
+  }
+  const uint64_t base = page.seq_base();
+  const uint64_t end = base + page->dcs.size();
+  t_out->id = page->id;
+  t_out->sequence = end;
+  t_out->reset = t_cursor < base || t_cursor > end;
+  t_out->data.clear();
+  renderers::codec::encode_delta(*page, t_out->reset ? 0 : t_cursor - base, &t_out->data);
   return true;
 }
 
 std::experimental::optional<ex::plot_index_t> page_store::find_index(ex::plot_id_t t_id)
 {
   const std::shared_lock<std::shared_timed_mutex> r_lock(m_store_mutex);
-  for (std::size_t i = 0; i != m_pages.size(); i++)
+  const auto index = m_pages.find(t_id);
+  if (!index)
   {
-    if (m_pages[i].id == t_id)
-    {
-      return static_cast<ex::plot_index_t>(i);
-    }
+    return std::experimental::nullopt;
   }
-  return std::experimental::nullopt;
+  return static_cast<ex::plot_index_t>(*index);
 }
 
 void page_store::m_inc_upid()
@@ -236,6 +477,73 @@ void page_store::m_inc_upid()
   m_upid = incwrap(m_upid);
 }
 
+bool page_store::m_spill(page_slot& t_slot)
+{
+  if (m_spill_dir.empty())
+  {
+    return false;
+  }
+  // Pages that have been loaded back and not modified since are still on disk
+  if (t_slot.spill_file.empty() || t_slot.spill_version != t_slot.version)
+  {
+    std::vector<uint8_t> buf;
+    buf.reserve(t_slot.page.mem_size);
+    renderers::codec::encode_page(t_slot.page, &buf);
+
+    if (t_slot.spill_file.empty())
+    {
+      t_slot.spill_file = m_spill_prefix + std::to_string(++m_spill_counter) + ".bin";
+    }
+    std::ofstream out(t_slot.spill_file, std::ios::binary | std::ios::trunc);
+    out.write(reinterpret_cast<const char*>(buf.data()),
+              static_cast<std::streamsize>(buf.size()));
+    out.close();
+    if (!out)
+    {
+      std::remove(t_slot.spill_file.c_str());
+      t_slot.spill_file.clear();
+      return false;
+    }
+    t_slot.spill_version = t_slot.version;
+    m_spill_bytes += buf.size();
+  }
+  m_spills++;
+  return true;
+}
+
+void page_store::m_load(page_slot& t_slot)
+{
+  if (!t_slot.spilled)
+  {
+    return;
+  }
+  t_slot.spilled = false;
+
+  mapped_file file;
+  if (!file.open(t_slot.spill_file) ||
+      !renderers::codec::decode_page(file.data(), file.size(), &t_slot.page))
+  {
+    // Fall back to rebuilding the page by a replay
+    t_slot.evicted = true;
+    return;
+  }
+  m_mem_size += t_slot.page.mem_size;
+  m_reloads++;
+  m_reload_bytes += file.size();
+}
+
+page_version_t page_store::m_next_version()
+{
+  return ++m_version_counter;
+}
+
+page_store_memory page_store::memory()
+{
+  return {m_mem_size.load(), m_memory_budget,     m_evictions.load(),
+          m_spills.load(),   m_reloads.load(),    m_spill_bytes.load(),
+          m_reload_bytes.load()};
+}
+
 unigd_device_state page_store::state()
 {
   const std::shared_lock<std::shared_timed_mutex> r_lock(m_store_mutex);
@@ -266,7 +574,7 @@ ex::find_results page_store::query(ex::plot_relative_t t_offset, ex::plot_id_t t
   std::vector<ex::plot_id_t> res(end - index);
   for (std::size_t i = index; i != end; i++)
   {
-    res[i - index] = m_pages[i].id;
+    res[i - index] = m_pages.key(i);
   }
   return {{m_upid, static_cast<ex::plot_index_t>(m_pages.size()), m_device_active}, res};
 }
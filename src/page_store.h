@@ -4,6 +4,7 @@
 #include <atomic>
 #include <compat/optional.hpp>
 #include <functional>
+#include <memory>
 #include <mutex>
 #include <shared_mutex>
 #include <stdint.h>
@@ -11,15 +12,83 @@
 #include <vector>
 
 #include "geom.h"
+#include "render_cache.h"
 #include "renderers.h"
+#include "slot_list.h"
 #include "unigd_external.h"
 
 namespace unigd
 {
+struct page_store_memory
+{
+  std::size_t mem_size;  // bytes held by draw calls
+  std::size_t budget;    // 0 = unlimited
+  uint64_t evictions;
+  uint64_t spills;
+  uint64_t reloads;
+  uint64_t spill_bytes;   // total bytes written to spill files
+  uint64_t reload_bytes;  // total bytes read back from spill files
+};
+
 class page_store
 {
  public:
-  page_store() = default;
+  // A page together with the lock guarding it. Slots are reference counted, so a page
+  // that is still being rendered survives its removal from the store.
+  struct page_slot
+  {
+    explicit page_slot(renderers::Page&& t_page);
+    ~page_slot();
+
+    page_slot(const page_slot&) = delete;
+    page_slot& operator=(const page_slot&) = delete;
+
+    std::shared_timed_mutex mutex;
+    renderers::Page page;
+    // Changes with every modification of the page, unique across the whole store.
+    page_version_t version = 0;
+    // Draw calls have been dropped to stay within the memory budget, the page needs
+    // to be rebuilt by a replay before it can be rendered again.
+    bool evicted = false;
+    // Draw calls have been written to the spill file and are loaded back on access.
+    bool spilled = false;
+    std::string spill_file{};
+    page_version_t spill_version = 0;
+    std::atomic<uint64_t> last_used{0};
+    // Sequence number of the first draw call of the page and of the next one to be
+    // added. Sequence numbers are never reused: clearing the page starts past every
+    // number given out before, so outdated delta cursors are recognized.
+    uint64_t seq_base = 1;
+    uint64_t seq_next = 1;
+  };
+
+  // Pinned read access to a single page. While a handle is held the page can not be
+  // modified or destroyed, but all other pages (and the store itself) stay writable.
+  class page_handle
+  {
+   public:
+    page_handle() = default;
+    explicit page_handle(std::shared_ptr<page_slot> t_slot);
+
+    explicit operator bool() const { return m_slot != nullptr; }
+    const renderers::Page& operator*() const { return m_slot->page; }
+    const renderers::Page* operator->() const { return &m_slot->page; }
+    page_version_t version() const { return m_slot->version; }
+    bool evicted() const { return m_slot->evicted; }
+    bool spilled() const { return m_slot->spilled; }
+    uint64_t seq_base() const { return m_slot->seq_base; }
+
+   private:
+    // Declaration order matters: the lock has to be released before the slot goes.
+    std::shared_ptr<page_slot> m_slot;
+    std::shared_lock<std::shared_timed_mutex> m_lock;
+  };
+
+  // Draw calls of least recently used pages are evicted once they hold more than
+  // the memory budget (in bytes, 0 = unlimited). If a spill directory is given,
+  // evicted pages are written there and loaded back on demand instead of being
+  // rebuilt by a replay.
+  explicit page_store(std::size_t t_memory_budget = 0, std::string t_spill_dir = {});
 
   page_store(const page_store&) = delete;
   page_store& operator=(page_store&) = delete;
@@ -32,10 +101,27 @@ class page_store
   std::experimental::optional<ex::plot_relative_t> normalize_index(
       ex::plot_relative_t t_index);
 
+  page_handle pin(ex::plot_relative_t t_index);
+
+  // The optional version output receives the version of the page that was rendered.
   bool render(ex::plot_relative_t t_index, renderers::render_target* t_renderer,
-              double t_scale);
+              double t_scale, page_version_t* t_version = nullptr);
   bool render_if_size(ex::plot_relative_t t_index, renderers::render_target* t_renderer,
-                      double t_scale, gvertex<double> t_target_size);
+                      double t_scale, gvertex<double> t_target_size,
+                      page_version_t* t_version = nullptr);
+  // Numbers of the draw calls whose bounds intersect t_rect (in page coordinates), see
+  // renderers::page_index. Fails for pages that have been evicted.
+  bool hit_test(ex::plot_relative_t t_index, grect<double> t_rect,
+                std::vector<std::size_t>* t_out);
+  // Draw calls added to a page since t_cursor (the sequence of an earlier delta, 0 for
+  // none), encoded with renderers::codec::encode_delta(). If the draw calls before the
+  // cursor are gone (the page has been cleared or replayed since), the delta is a reset
+  // that holds the whole page. Fails for pages that have been evicted.
+  bool delta(ex::plot_relative_t t_index, uint64_t t_cursor, ex::delta_results* t_out);
+  // Current page version, if the page can be rendered at the target size without a
+  // replay. Unset (negative) target dimensions are replaced by the page size.
+  bool version_if_size(ex::plot_relative_t t_index, gvertex<double>* t_target_size,
+                       page_version_t* t_version);
 
   ex::plot_index_t append(gvertex<double> t_size);
   void clear(ex::plot_relative_t t_index, bool t_silent);
@@ -45,13 +131,12 @@ class page_store
   gvertex<double> size(ex::plot_relative_t t_index);
 
   void fill(ex::plot_relative_t t_index, color_t t_fill);
-  void add_dc(ex::plot_relative_t t_index, std::unique_ptr<renderers::DrawCall>&& t_dc,
-              bool t_silent);
-  void add_dc(ex::plot_relative_t t_index,
-              std::vector<std::unique_ptr<renderers::DrawCall>>&& t_dcs, bool t_silent);
+  void add_dc(ex::plot_relative_t t_index, renderers::draw_call_list&& t_dcs,
+              const renderers::style_table& t_styles, bool t_silent);
   void clip(ex::plot_relative_t t_index, grect<double> t_rect);
 
   ex::device_state state();
+  page_store_memory memory();
   void set_device_active(bool t_active);
 
   ex::find_results query(ex::plot_relative_t t_offset, ex::plot_index_t t_limit);
@@ -59,16 +144,47 @@ class page_store
   void extra_css(std::experimental::optional<std::string> t_extra_css);
 
  private:
+  // Guards the page list and store wide state only, the pages themselves are guarded
+  // by their slot mutex. Never acquire the store lock while holding a page lock.
   std::shared_timed_mutex m_store_mutex;
 
   ex::plot_id_t m_id_counter = 0;
-  std::vector<renderers::Page> m_pages{};
+  std::atomic<page_version_t> m_version_counter{0};
+
+  const std::size_t m_memory_budget;
+  std::atomic<std::size_t> m_mem_size{0};
+  std::atomic<std::size_t> m_evict_floor{0};
+  std::atomic<uint64_t> m_use_counter{0};
+  std::atomic<uint64_t> m_evictions{0};
+
+  const std::string m_spill_dir;
+  const std::string m_spill_prefix;
+  std::atomic<uint64_t> m_spill_counter{0};
+  std::atomic<uint64_t> m_spills{0};
+  std::atomic<uint64_t> m_reloads{0};
+  std::atomic<uint64_t> m_spill_bytes{0};
+  std::atomic<uint64_t> m_reload_bytes{0};
+
+  slot_list<ex::plot_id_t, std::shared_ptr<page_slot>> m_pages{};
   int m_upid = 0;
   bool m_device_active = true;
 
   std::experimental::optional<std::string> m_extra_css{};
 
   void m_inc_upid();
+  std::shared_ptr<page_slot> m_slot(ex::plot_relative_t t_index);
+  // Pins the page and marks it as recently used
+  page_handle m_use(ex::plot_relative_t t_index);
+  // Modifies a page and keeps version and memory accounting up to date
+  template <class F>
+  void m_modify(page_slot& t_slot, F&& t_fn);
+  // Drops memory accounting of a page removed from the store
+  void m_release(page_slot& t_slot);
+  void m_evict(const page_slot* t_keep);
+  // Both expect the page lock to be held exclusively
+  bool m_spill(page_slot& t_slot);
+  void m_load(page_slot& t_slot);
+  page_version_t m_next_version();
 
   inline bool m_valid_index(ex::plot_relative_t t_index);
   inline size_t m_index_to_pos(ex::plot_relative_t t_index);
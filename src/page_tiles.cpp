@@ -0,0 +1,76 @@
+#include "page_tiles.h"
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+#include "async_utils.h"
+#include "page_index.h"
+
+namespace unigd
+{
+namespace renderers
+{
+double tile_scale(int32_t t_zoom)
+{
+  return std::ldexp(1.0, t_zoom);
+}
+
+grect<double> tile_region(const tile_id& t_tile, uint32_t t_tile_size)
+{
+  const double size = t_tile_size / tile_scale(t_tile.zoom);
+  return {t_tile.x * size, t_tile.y * size, size, size};
+}
+
+tile_target::tile_target(renderer_gen t_generator, std::vector<tile_id> t_tiles,
+                         uint32_t t_tile_size, unsigned t_threads)
+    : m_generator(std::move(t_generator)),
+      m_tiles(std::move(t_tiles)),
+      m_tile_size(t_tile_size),
+      m_threads(std::max(t_threads, 1U))
+{
+}
+
+void tile_target::render(const Page& t_page, double t_scale)
+{
+  m_page_size = t_page.size;
+  m_rendered.clear();
+  m_rendered.resize(m_tiles.size());
+  // Build the index up front instead of letting the first tiles race for it
+  t_page.index();
+
+  async::parallel_for(m_tiles.size(), m_threads,
+                      [&](std::size_t i)
+                      {
+                        try
+                        {
+                          const auto& tile = m_tiles[i];
+                          auto renderer = std::make_unique<region_target>(
+                              m_generator(), tile_region(tile, m_tile_size));
+                          renderer->render(t_page, tile_scale(tile.zoom));
+                          m_rendered[i] = std::move(renderer);
+                        }
+                        catch (...)
+                        {
+                          // Leaves this tile empty
+                        }
+                      });
+}
+
+void tile_target::get_data(const uint8_t** t_buf, size_t* t_size) const
+{
+  *t_buf = nullptr;
+  *t_size = 0;
+}
+
+std::unique_ptr<render_target> tile_target::take(std::size_t t_index)
+{
+  if (t_index >= m_rendered.size())
+  {
+    return nullptr;
+  }
+  return std::move(m_rendered[t_index]);
+}
+
+}  // namespace renderers
+}  // namespace unigd
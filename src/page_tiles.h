@@ -0,0 +1,65 @@
+#ifndef __UNIGD_PAGE_TILES_H__
+#define __UNIGD_PAGE_TILES_H__
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "renderers.h"
+
+namespace unigd
+{
+namespace renderers
+{
+// Tile pyramid
+//
+// At zoom level z a page is rendered at scale 2^z and cut into square tiles of a fixed
+// size (in output pixels). Tile (x, y) covers the output pixels x * size to
+// (x + 1) * size and y * size to (y + 1) * size, tiles at the right and bottom border
+// reach beyond the page. Powers of two keep tile borders exact in page units.
+struct tile_id
+{
+  int32_t zoom;
+  uint32_t x;
+  uint32_t y;
+};
+
+double tile_scale(int32_t t_zoom);
+// Area of the page covered by a tile (in page coordinates)
+grect<double> tile_region(const tile_id& t_tile, uint32_t t_tile_size);
+
+// Render target that renders a set of tiles of the same page in parallel (on the shared
+// pool, see async::parallel_for). Every tile gets its own renderer (see region_target),
+// the page is only read.
+//
+// The scale passed to render() is ignored, tiles always use the scale of their zoom
+// level. The rendered tiles are taken out with take() afterwards.
+class tile_target : public render_target
+{
+ public:
+  tile_target(renderer_gen t_generator, std::vector<tile_id> t_tiles,
+              uint32_t t_tile_size, unsigned t_threads);
+
+  void render(const Page& t_page, double t_scale) override;
+  // Tiles are not concatenated, this returns no data.
+  void get_data(const uint8_t** t_buf, size_t* t_size) const override;
+
+  // Size of the page the tiles were rendered from
+  gvertex<double> page_size() const { return m_page_size; }
+  // Rendered tile, nullptr if rendering failed.
+  std::unique_ptr<render_target> take(std::size_t t_index);
+
+ private:
+  renderer_gen m_generator;
+  std::vector<tile_id> m_tiles;
+  uint32_t m_tile_size;
+  unsigned m_threads;
+  gvertex<double> m_page_size{0, 0};
+  std::vector<std::unique_ptr<render_target>> m_rendered;
+};
+
+}  // namespace renderers
+}  // namespace unigd
+
+#endif /* __UNIGD_PAGE_TILES_H__ */
@@ -15,6 +15,8 @@ void ipc_open();
 void ipc_close();
 
 void r_thread_impl(function_wrapper&& f);
+// Runs the tasks queued for the R thread so far (call on the R thread).
+void r_thread_run_pending();
 
 template <typename FunctionType>
 #if defined(__cplusplus) && __cplusplus >= 201703L
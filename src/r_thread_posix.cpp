@@ -81,6 +81,11 @@ void r_thread_impl(function_wrapper&& task)
   work_queue.push(std::move(task));
   notify_work();
 }
+
+void r_thread_run_pending()
+{
+  process_tasks();
+}
 }  // namespace async
 }  // namespace unigd
 
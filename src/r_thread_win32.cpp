@@ -136,6 +136,11 @@ void r_thread_impl(function_wrapper&& task)
   notify();
 }
 
+void r_thread_run_pending()
+{
+  process_tasks();
+}
+
 }  // namespace async
 }  // namespace unigd
 
@@ -0,0 +1,130 @@
+#include "render_cache.h"
+
+#include <limits>
+#include <tuple>
+
+namespace unigd
+{
+namespace
+{
+// Handle given out for cached renders, the buffer is shared with the cache entry.
+class cached_render_data : public ex::render_data
+{
+ public:
+  explicit cached_render_data(std::shared_ptr<const ex::render_data> t_data)
+      : m_data(std::move(t_data))
+  {
+  }
+
+  void get_data(const uint8_t** t_buf, size_t* t_size) const override
+  {
+    m_data->get_data(t_buf, t_size);
+  }
+
+ private:
+  std::shared_ptr<const ex::render_data> m_data;
+};
+
+// Rough bookkeeping cost of an entry besides the rendered bytes.
+constexpr std::size_t entry_overhead = 128;
+}  // namespace
+
+bool render_cache_key::operator<(const render_cache_key& t_other) const
+{
+  return std::tie(id, renderer, size.x, size.y, scale, region.x, region.y, region.width,
+                  region.height, lod) <
+         std::tie(t_other.id, t_other.renderer, t_other.size.x, t_other.size.y,
+                  t_other.scale, t_other.region.x, t_other.region.y, t_other.region.width,
+                  t_other.region.height, t_other.lod);
+}
+
+render_cache::render_cache(std::size_t t_budget) : m_budget(t_budget) {}
+
+std::unique_ptr<ex::render_data> render_cache::find(const render_cache_key& t_key,
+                                                    page_version_t t_version)
+{
+  const std::lock_guard<std::mutex> lock(m_mutex);
+  auto it = m_entries.find(t_key);
+  if (it == m_entries.end())
+  {
+    return nullptr;
+  }
+  if (it->second.version != t_version)
+  {
+    // The page has changed since, this entry will never be valid again.
+    m_erase(it);
+    return nullptr;
+  }
+  m_lru.splice(m_lru.begin(), m_lru, it->second.lru);
+  m_hits++;
+  return std::make_unique<cached_render_data>(it->second.data);
+}
+
+std::unique_ptr<ex::render_data> render_cache::insert(
+    const render_cache_key& t_key, page_version_t t_version,
+    std::unique_ptr<ex::render_data>&& t_data)
+{
+  const uint8_t* buf;
+  std::size_t buf_size;
+  t_data->get_data(&buf, &buf_size);
+  const std::size_t bytes = buf_size + t_key.renderer.size() + entry_overhead;
+
+  const std::lock_guard<std::mutex> lock(m_mutex);
+  m_misses++;
+  if (bytes > m_budget)
+  {
+    return std::move(t_data);
+  }
+
+  auto it = m_entries.find(t_key);
+  if (it != m_entries.end())
+  {
+    m_erase(it);
+  }
+  while (m_bytes + bytes > m_budget && !m_lru.empty())
+  {
+    m_erase(m_entries.find(m_lru.back()));
+  }
+
+  std::shared_ptr<const ex::render_data> data(std::move(t_data));
+  m_lru.push_front(t_key);
+  m_entries.emplace(t_key, entry{t_version, data, bytes, m_lru.begin()});
+  m_bytes += bytes;
+
+  return std::make_unique<cached_render_data>(std::move(data));
+}
+
+void render_cache::erase(ex::plot_id_t t_id)
+{
+  const std::lock_guard<std::mutex> lock(m_mutex);
+  constexpr auto lowest = std::numeric_limits<double>::lowest();
+  auto it = m_entries.lower_bound(
+      render_cache_key{t_id, {}, {lowest, lowest}, lowest, {lowest, lowest, lowest, lowest}});
+  while (it != m_entries.end() && it->first.id == t_id)
+  {
+    it = m_erase(it);
+  }
+}
+
+void render_cache::clear()
+{
+  const std::lock_guard<std::mutex> lock(m_mutex);
+  m_entries.clear();
+  m_lru.clear();
+  m_bytes = 0;
+}
+
+render_cache_stats render_cache::stats()
+{
+  const std::lock_guard<std::mutex> lock(m_mutex);
+  return {m_hits, m_misses, m_entries.size(), m_bytes};
+}
+
+render_cache::entry_map::iterator render_cache::m_erase(entry_map::iterator t_it)
+{
+  m_bytes -= t_it->second.bytes;
+  m_lru.erase(t_it->second.lru);
+  return m_entries.erase(t_it);
+}
+
+}  // namespace unigd
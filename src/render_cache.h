@@ -0,0 +1,88 @@
+#ifndef __UNIGD_RENDER_CACHE_H__
+#define __UNIGD_RENDER_CACHE_H__
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include "geom.h"
+#include "unigd_external.h"
+
+namespace unigd
+{
+using page_version_t = uint64_t;
+
+struct render_cache_key
+{
+  ex::plot_id_t id;
+  std::string renderer;
+  gvertex<double> size;
+  double scale;
+  // Part of the page that was rendered (tiles), empty for the whole page
+  grect<double> region{0, 0, 0, 0};
+  // Level of detail tolerance (in output pixels), 0 for all details
+  double lod = 0;
+
+  bool operator<(const render_cache_key& t_other) const;
+};
+
+struct render_cache_stats
+{
+  uint64_t hits;
+  uint64_t misses;
+  std::size_t entries;
+  std::size_t bytes;
+};
+
+// Memory bounded LRU cache of finished renders. Every entry remembers the page version
+// it was rendered from, so entries of pages that changed in the meantime are never
+// served. A budget of 0 disables caching.
+class render_cache
+{
+ public:
+  explicit render_cache(std::size_t t_budget);
+
+  render_cache(const render_cache&) = delete;
+  render_cache& operator=(const render_cache&) = delete;
+
+  // Returns a handle to the cached render or nullptr.
+  std::unique_ptr<ex::render_data> find(const render_cache_key& t_key,
+                                        page_version_t t_version);
+  // Stores a fresh render and returns a handle to it (counts as a miss).
+  std::unique_ptr<ex::render_data> insert(const render_cache_key& t_key,
+                                          page_version_t t_version,
+                                          std::unique_ptr<ex::render_data>&& t_data);
+  void erase(ex::plot_id_t t_id);
+  void clear();
+
+  render_cache_stats stats();
+
+ private:
+  struct entry
+  {
+    page_version_t version;
+    std::shared_ptr<const ex::render_data> data;
+    std::size_t bytes;
+    std::list<render_cache_key>::iterator lru;
+  };
+  using entry_map = std::map<render_cache_key, entry>;
+
+  std::mutex m_mutex;
+  std::size_t m_budget;
+  std::size_t m_bytes = 0;
+  uint64_t m_hits = 0;
+  uint64_t m_misses = 0;
+
+  entry_map m_entries{};
+  std::list<render_cache_key> m_lru{};  // most recently used first
+
+  entry_map::iterator m_erase(entry_map::iterator t_it);
+};
+
+}  // namespace unigd
+
+#endif /* __UNIGD_RENDER_CACHE_H__ */
@@ -4,12 +4,16 @@
 
 #include <cairo-pdf.h>
 #include <cairo-ps.h>
-#include <sstream>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <vector>
 
+#include "async_utils.h"
 #include "base_64.h"  // for RendererCairoPngBase64
 
 #ifndef UNIGD_NO_TIFF
-#include <tiffio.hxx>
+#include <tiffio.h>
 #endif
 
 // Implementation based on grDevices::cairo
@@ -94,6 +98,7 @@ inline void set_linetype(cairo_t* cr, const LineInfo& line)
 
 void RendererCairo::render_page(const Page* t_page)
 {
+  m_styles = &t_page->styles;
   if (!color::transparent(t_page->fill))
   {
     cairo_new_path(cr);
@@ -110,6 +115,10 @@ void RendererCairo::render_page(const Page* t_page)
   auto last_clip_id = first_clip.id;
   for (const auto& dc : t_page->dcs)
   {
+    if (m_outside_band(*dc))
+    {
+      continue;
+    }
     if (dc->clip_id != last_clip_id)
     {
       const auto& next_clip =
@@ -129,8 +138,61 @@ void RendererCairo::render_page(const Page* t_page)
   }
 }
 
+void RendererCairo::render_image(const Page* t_page, double t_scale,
+                                 cairo_surface_t* t_surface)
+{
+  // Bands thinner than this are not worth a thread
+  constexpr int min_band_rows = 64;
+
+  const int width = cairo_image_surface_get_width(t_surface);
+  const int height = cairo_image_surface_get_height(t_surface);
+  const int bands = static_cast<int>(
+      std::min<unsigned>(std::max(m_threads, 1U), std::max(height / min_band_rows, 1)));
+  if (bands == 1)
+  {
+    surface = t_surface;
+    cr = cairo_create(surface);
+    cairo_scale(cr, t_scale, t_scale);
+    render_page(t_page);
+    cairo_destroy(cr);
+    return;
+  }
+
+  cairo_surface_flush(t_surface);
+  unsigned char* data = cairo_image_surface_get_data(t_surface);
+  const auto format = cairo_image_surface_get_format(t_surface);
+  const int stride = cairo_image_surface_get_stride(t_surface);
+  // Shapes may reach a little beyond their bounds (minimum circle radius, antialiasing)
+  const double margin = 1 + 1 / t_scale;
+
+  auto draw_band = [&](int t_band)
+  {
+    const int y0 = height * t_band / bands;
+    const int y1 = height * (t_band + 1) / bands;
+    RendererCairo band;
+    band.m_banded = true;
+    band.m_band = {-margin, y0 / t_scale - margin, t_page->size.x + 2 * margin,
+                   (y1 - y0) / t_scale + 2 * margin};
+    // The band surface shares the rows of the image, no compositing needed
+    band.surface = cairo_image_surface_create_for_data(
+        data + static_cast<std::ptrdiff_t>(y0) * stride, format, width, y1 - y0, stride);
+    band.cr = cairo_create(band.surface);
+    // Integer offsets keep device coordinates (and pixels) identical to a single pass
+    cairo_translate(band.cr, 0, -y0);
+    cairo_scale(band.cr, t_scale, t_scale);
+    band.render_page(t_page);
+    cairo_destroy(band.cr);
+    cairo_surface_destroy(band.surface);
+  };
+
+  async::parallel_for(bands, bands,
+                      [&](std::size_t t_band) { draw_band(static_cast<int>(t_band)); });
+  cairo_surface_mark_dirty(t_surface);
+}
+
 void RendererCairo::visit(const Rect* t_rect)
 {
+  const auto& line = m_styles->line(t_rect->line);
   cairo_new_path(cr);
 
   cairo_rectangle(cr, t_rect->rect.x, t_rect->rect.y, t_rect->rect.width,
@@ -144,10 +206,10 @@ void RendererCairo::visit(const Rect* t_rect)
     cairo_fill_preserve(cr);
     // cairo_set_antialias(cr, aa);
   }
-  if (!color::transparent(t_rect->line.col) && t_rect->line.lty != LineInfo::LTY::BLANK)
+  if (!color::transparent(line.col) && line.lty != LineInfo::LTY::BLANK)
   {
-    set_linetype(cr, t_rect->line);
-    set_color(cr, t_rect->line.col);
+    set_linetype(cr, line);
+    set_color(cr, line.col);
     cairo_stroke(cr);
   }
 }
@@ -160,11 +222,12 @@ void RendererCairo::visit(const Text* t_text)
   }
   cairo_save(cr);
 
+  const auto& text = m_styles->text(t_text->text);
   cairo_select_font_face(
-      cr, t_text->text.font_family.c_str(),
-      t_text->text.italic ? CAIRO_FONT_SLANT_ITALIC : CAIRO_FONT_SLANT_NORMAL,
-      (t_text->text.weight >= 700) ? CAIRO_FONT_WEIGHT_BOLD : CAIRO_FONT_WEIGHT_NORMAL);
-  cairo_set_font_size(cr, t_text->text.fontsize);
+      cr, text.font_family.c_str(),
+      text.italic ? CAIRO_FONT_SLANT_ITALIC : CAIRO_FONT_SLANT_NORMAL,
+      (text.weight >= 700) ? CAIRO_FONT_WEIGHT_BOLD : CAIRO_FONT_WEIGHT_NORMAL);
+  cairo_set_font_size(cr, text.fontsize);
 
   cairo_move_to(cr, t_text->pos.x, t_text->pos.y);
   if (t_text->hadj != 0.0 || t_text->rot != 0.0)
@@ -188,6 +251,7 @@ void RendererCairo::visit(const Text* t_text)
 
 void RendererCairo::visit(const Circle* t_circle)
 {
+  const auto& line = m_styles->line(t_circle->line);
   cairo_new_path(cr);
   cairo_arc(cr, t_circle->pos.x, t_circle->pos.y,
             (t_circle->radius > 0.5 ? t_circle->radius : 0.5), 0.0, 2 * MATH_PI);
@@ -197,25 +261,25 @@ void RendererCairo::visit(const Circle* t_circle)
     set_color(cr, t_circle->fill);
     cairo_fill_preserve(cr);
   }
-  if (!color::transparent(t_circle->line.col) &&
-      t_circle->line.lty != LineInfo::LTY::BLANK)
+  if (!color::transparent(line.col) && line.lty != LineInfo::LTY::BLANK)
   {
-    set_linetype(cr, t_circle->line);
-    set_color(cr, t_circle->line.col);
+    set_linetype(cr, line);
+    set_color(cr, line.col);
     cairo_stroke(cr);
   }
 }
 
 void RendererCairo::visit(const Line* t_line)
 {
-  if (color::transparent(t_line->line.col))
+  const auto& line = m_styles->line(t_line->line);
+  if (color::transparent(line.col))
   {
     return;
   }
   cairo_new_path(cr);
 
-  set_color(cr, t_line->line.col);
-  set_linetype(cr, t_line->line);
+  set_color(cr, line.col);
+  set_linetype(cr, line);
   cairo_move_to(cr, t_line->orig.x, t_line->orig.y);
   cairo_line_to(cr, t_line->dest.x, t_line->dest.y);
   cairo_stroke(cr);
@@ -223,14 +287,15 @@ void RendererCairo::visit(const Line* t_line)
 
 void RendererCairo::visit(const Polyline* t_polyline)
 {
-  if (color::transparent(t_polyline->line.col))
+  const auto& line = m_styles->line(t_polyline->line);
+  if (color::transparent(line.col))
   {
     return;
   }
   cairo_new_path(cr);
 
-  set_color(cr, t_polyline->line.col);
-  set_linetype(cr, t_polyline->line);
+  set_color(cr, line.col);
+  set_linetype(cr, line);
 
   for (auto it = t_polyline->points.begin(); it != t_polyline->points.end(); ++it)
   {
@@ -248,6 +313,7 @@ void RendererCairo::visit(const Polyline* t_polyline)
 
 void RendererCairo::visit(const Polygon* t_polygon)
 {
+  const auto& line = m_styles->line(t_polygon->line);
   cairo_new_path(cr);
   for (auto it = t_polygon->points.begin(); it != t_polygon->points.end(); ++it)
   {
@@ -267,17 +333,17 @@ void RendererCairo::visit(const Polygon* t_polygon)
     set_color(cr, t_polygon->fill);
     cairo_fill_preserve(cr);
   }
-  if (!color::transparent(t_polygon->line.col) &&
-      t_polygon->line.lty != LineInfo::LTY::BLANK)
+  if (!color::transparent(line.col) && line.lty != LineInfo::LTY::BLANK)
   {
-    set_linetype(cr, t_polygon->line);
-    set_color(cr, t_polygon->line.col);
+    set_linetype(cr, line);
+    set_color(cr, line.col);
     cairo_stroke(cr);
   }
 }
 
 void RendererCairo::visit(const Path* t_path)
 {
+  const auto& line = m_styles->line(t_path->line);
   cairo_new_path(cr);
 
   auto it_poly = t_path->nper.begin();
@@ -306,10 +372,10 @@ void RendererCairo::visit(const Path* t_path)
     set_color(cr, t_path->fill);
     cairo_fill_preserve(cr);
   }
-  if (!color::transparent(t_path->line.col) && t_path->line.lty != LineInfo::LTY::BLANK)
+  if (!color::transparent(line.col) && line.lty != LineInfo::LTY::BLANK)
   {
-    set_linetype(cr, t_path->line);
-    set_color(cr, t_path->line.col);
+    set_linetype(cr, line);
+    set_color(cr, line.col);
     cairo_stroke(cr);
   }
 }
@@ -371,82 +437,197 @@ void RendererCairo::visit(const Raster* t_raster)
   cairo_surface_destroy(image);
 }
 
+// Runs only set the line type when the line style changes from one element to the next.
+
+void RendererCairo::visit(const CircleRun* t_run)
+{
+  auto line_style = static_cast<style_id_t>(m_styles->lines().size());
+  for (std::size_t i = 0; i != t_run->size(); ++i)
+  {
+    if (m_banded && m_outside_band(t_run->at(i)))
+    {
+      continue;
+    }
+    const auto& style = t_run->styles[t_run->style[i]];
+    cairo_new_path(cr);
+    cairo_arc(cr, t_run->pos[i].x, t_run->pos[i].y,
+              (t_run->radius[i] > 0.5 ? t_run->radius[i] : 0.5), 0.0, 2 * MATH_PI);
+
+    if (!color::transparent(style.fill))
+    {
+      set_color(cr, style.fill);
+      cairo_fill_preserve(cr);
+    }
+    const auto& line = m_styles->line(style.line);
+    if (!color::transparent(line.col) && line.lty != LineInfo::LTY::BLANK)
+    {
+      if (style.line != line_style)
+      {
+        set_linetype(cr, line);
+        line_style = style.line;
+      }
+      set_color(cr, line.col);
+      cairo_stroke(cr);
+    }
+  }
+}
+
+void RendererCairo::visit(const LineRun* t_run)
+{
+  auto line_style = static_cast<style_id_t>(m_styles->lines().size());
+  for (std::size_t i = 0; i != t_run->size(); ++i)
+  {
+    if (m_banded && m_outside_band(t_run->at(i)))
+    {
+      continue;
+    }
+    const auto style = t_run->styles[t_run->style[i]];
+    const auto& line = m_styles->line(style);
+    if (color::transparent(line.col))
+    {
+      continue;
+    }
+    cairo_new_path(cr);
+
+    if (style != line_style)
+    {
+      set_color(cr, line.col);
+      set_linetype(cr, line);
+      line_style = style;
+    }
+    cairo_move_to(cr, t_run->orig[i].x, t_run->orig[i].y);
+    cairo_line_to(cr, t_run->dest[i].x, t_run->dest[i].y);
+    cairo_stroke(cr);
+  }
+}
+
+void RendererCairo::visit(const RectRun* t_run)
+{
+  auto line_style = static_cast<style_id_t>(m_styles->lines().size());
+  for (std::size_t i = 0; i != t_run->size(); ++i)
+  {
+    if (m_banded && m_outside_band(t_run->at(i)))
+    {
+      continue;
+    }
+    const auto& style = t_run->styles[t_run->style[i]];
+    const auto& rect = t_run->rect[i];
+    cairo_new_path(cr);
+    cairo_rectangle(cr, rect.x, rect.y, rect.width, rect.height);
+
+    if (!color::transparent(style.fill))
+    {
+      set_color(cr, style.fill);
+      cairo_fill_preserve(cr);
+    }
+    const auto& line = m_styles->line(style.line);
+    if (!color::transparent(line.col) && line.lty != LineInfo::LTY::BLANK)
+    {
+      if (style.line != line_style)
+      {
+        set_linetype(cr, line);
+        line_style = style.line;
+      }
+      set_color(cr, line.col);
+      cairo_stroke(cr);
+    }
+  }
+}
+
 // TARGETS
 
-static cairo_status_t cairowrite_fmt(void* closure, const unsigned char* data,
-                                     unsigned int length)
+static cairo_status_t cairowrite_sink(void* closure, const unsigned char* data,
+                                      unsigned int length)
 {
-  auto* os = static_cast<fmt::memory_buffer*>(closure);
-  // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
-  std::string s(reinterpret_cast<const char*>(data), length);
-  fmt::format_to(std::back_inserter(*os), "{}", s);
-  return CAIRO_STATUS_SUCCESS;
+  auto* sink = static_cast<byte_sink*>(closure);
+  sink->append(data, length);
+  return sink->stopped() ? CAIRO_STATUS_WRITE_ERROR : CAIRO_STATUS_SUCCESS;
 }
 
-static cairo_status_t cairowrite_ucvec(void* closure, const unsigned char* data,
-                                       unsigned int length)
+// Renders with the output sink forwarding to t_chunk. Cairo hands its output to the
+// write callback while it is encoded, so at most one chunk is buffered.
+template <class T>
+static bool stream_render(T* t_target, byte_sink* t_sink, const Page& t_page,
+                          double t_scale, const chunk_fn& t_chunk)
 {
-  auto* render_data = static_cast<std::vector<unsigned char>*>(closure);
-  // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-pointer-arithmetic)
-  render_data->insert(render_data->end(), data, data + length);
-  return CAIRO_STATUS_SUCCESS;
+  t_sink->forward(t_chunk, stream_chunk_size);
+  t_target->render(t_page, t_scale);
+  const bool complete = t_sink->flush();
+  t_sink->forward(nullptr, 0);
+  return complete;
 }
 
-void RendererCairoPng::render(const Page& t_page, double t_scale)
+// Initial output buffer of the raster renderers. Plots are mostly empty space and
+// compress well, larger outputs grow the buffer geometrically.
+static std::size_t raster_reserve(int t_width, int t_height)
 {
-  surface = cairo_image_surface_create(CAIRO_FORMAT_ARGB32,
-                                       static_cast<int>(t_page.size.x * t_scale),
-                                       static_cast<int>(t_page.size.y * t_scale));
+  return static_cast<std::size_t>(t_width) * t_height / 4 + 4096;
+}
 
-  cr = cairo_create(surface);
+// Initial output buffer of the vector renderers
+constexpr std::size_t vector_reserve = 65536;
 
-  cairo_scale(cr, t_scale, t_scale);
+void RendererCairoPng::render(const Page& t_page, double t_scale)
+{
+  const int width = static_cast<int>(t_page.size.x * t_scale);
+  const int height = static_cast<int>(t_page.size.y * t_scale);
+  surface = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, width, height);
 
-  render_page(&t_page);
+  render_image(&t_page, t_scale, surface);
 
-  cairo_surface_write_to_png_stream(surface, cairowrite_ucvec, &m_render_data);
+  m_render_data.clear();
+  m_render_data.reserve(raster_reserve(width, height));
+  cairo_surface_write_to_png_stream(surface, cairowrite_sink, &m_render_data);
 
-  cairo_destroy(cr);
   cairo_surface_destroy(surface);
 }
 
 void RendererCairoPng::get_data(const uint8_t** t_buf, size_t* t_size) const
 {
-  *t_buf = &m_render_data[0];
+  *t_buf = m_render_data.data();
   *t_size = m_render_data.size();
 }
 
+bool RendererCairoPng::stream(const Page& t_page, double t_scale, const chunk_fn& t_chunk)
+{
+  return stream_render(this, &m_render_data, t_page, t_scale, t_chunk);
+}
+
 void RendererCairoPngBase64::render(const Page& t_page, double t_scale)
 {
-  surface = cairo_image_surface_create(CAIRO_FORMAT_ARGB32,
-                                       static_cast<int>(t_page.size.x * t_scale),
-                                       static_cast<int>(t_page.size.y * t_scale));
+  static const char prefix[] = "data:image/png;base64,";
 
-  cr = cairo_create(surface);
+  const int width = static_cast<int>(t_page.size.x * t_scale);
+  const int height = static_cast<int>(t_page.size.y * t_scale);
+  surface = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, width, height);
 
-  cairo_scale(cr, t_scale, t_scale);
+  render_image(&t_page, t_scale, surface);
 
-  render_page(&t_page);
+  byte_sink png_buf;
+  png_buf.reserve(raster_reserve(width, height));
+  cairo_surface_write_to_png_stream(surface, cairowrite_sink, &png_buf);
 
-  std::vector<unsigned char> png_buf;
-  cairo_surface_write_to_png_stream(surface, cairowrite_ucvec, &png_buf);
-  m_buf = base64_encode(png_buf.data(), png_buf.size());
-  m_buf.insert(0, "data:image/png;base64,");  // potentially very expensive
+  // The encoded size is known, the prefix is written first instead of inserted.
+  m_render_data.clear();
+  m_render_data.reserve(sizeof(prefix) - 1 + base64_size(png_buf.size()));
+  m_render_data.append(prefix, sizeof(prefix) - 1);
+  base64_encode(png_buf.data(), png_buf.size(), &m_render_data);
 
-  cairo_destroy(cr);
   cairo_surface_destroy(surface);
 }
 
 void RendererCairoPngBase64::get_data(const uint8_t** t_buf, size_t* t_size) const
 {
-  *t_buf = reinterpret_cast<const unsigned char*>(m_buf.data());
-  *t_size = m_buf.size();
+  *t_buf = m_render_data.data();
+  *t_size = m_render_data.size();
 }
 
 void RendererCairoPdf::render(const Page& t_page, double t_scale)
 {
+  m_render_data.clear();
+  m_render_data.reserve(vector_reserve);
   surface = cairo_pdf_surface_create_for_stream(
-      cairowrite_ucvec, &m_render_data, t_page.size.x * t_scale, t_page.size.y * t_scale);
+      cairowrite_sink, &m_render_data, t_page.size.x * t_scale, t_page.size.y * t_scale);
 
   cr = cairo_create(surface);
 
@@ -460,14 +641,21 @@ void RendererCairoPdf::render(const Page& t_page, double t_scale)
 
 void RendererCairoPdf::get_data(const uint8_t** t_buf, size_t* t_size) const
 {
-  *t_buf = &m_render_data[0];
+  *t_buf = m_render_data.data();
   *t_size = m_render_data.size();
 }
 
+bool RendererCairoPdf::stream(const Page& t_page, double t_scale, const chunk_fn& t_chunk)
+{
+  return stream_render(this, &m_render_data, t_page, t_scale, t_chunk);
+}
+
 void RendererCairoPs::render(const Page& t_page, double t_scale)
 {
+  m_render_data.clear();
+  m_render_data.reserve(vector_reserve);
   surface = cairo_ps_surface_create_for_stream(
-      cairowrite_fmt, &m_os, t_page.size.x * t_scale, t_page.size.y * t_scale);
+      cairowrite_sink, &m_render_data, t_page.size.x * t_scale, t_page.size.y * t_scale);
 
   cr = cairo_create(surface);
 
@@ -481,14 +669,21 @@ void RendererCairoPs::render(const Page& t_page, double t_scale)
 
 void RendererCairoPs::get_data(const uint8_t** t_buf, size_t* t_size) const
 {
-  *t_buf = reinterpret_cast<const uint8_t*>(m_os.begin());
-  *t_size = m_os.size();
+  *t_buf = m_render_data.data();
+  *t_size = m_render_data.size();
+}
+
+bool RendererCairoPs::stream(const Page& t_page, double t_scale, const chunk_fn& t_chunk)
+{
+  return stream_render(this, &m_render_data, t_page, t_scale, t_chunk);
 }
 
 void RendererCairoEps::render(const Page& t_page, double t_scale)
 {
+  m_render_data.clear();
+  m_render_data.reserve(vector_reserve);
   surface = cairo_ps_surface_create_for_stream(
-      cairowrite_fmt, &m_os, t_page.size.x * t_scale, t_page.size.y * t_scale);
+      cairowrite_sink, &m_render_data, t_page.size.x * t_scale, t_page.size.y * t_scale);
   cairo_ps_surface_set_eps(surface, true);
 
   cr = cairo_create(surface);
@@ -503,12 +698,101 @@ void RendererCairoEps::render(const Page& t_page, double t_scale)
 
 void RendererCairoEps::get_data(const uint8_t** t_buf, size_t* t_size) const
 {
-  *t_buf = reinterpret_cast<const uint8_t*>(m_os.begin());
-  *t_size = m_os.size();
+  *t_buf = m_render_data.data();
+  *t_size = m_render_data.size();
+}
+
+bool RendererCairoEps::stream(const Page& t_page, double t_scale, const chunk_fn& t_chunk)
+{
+  return stream_render(this, &m_render_data, t_page, t_scale, t_chunk);
 }
 
 #ifndef UNIGD_NO_TIFF
 
+// libtiff client procs that write the file straight into a byte_sink. libtiff seeks back
+// to patch the header, so the sink is written like a file with a position (and TIFF
+// output can only be streamed once it is finished).
+namespace
+{
+struct tiff_sink
+{
+  byte_sink* sink;
+  toff_t pos;
+};
+
+tmsize_t tiff_read(thandle_t t_handle, void* t_buf, tmsize_t t_size)
+{
+  auto* ts = static_cast<tiff_sink*>(t_handle);
+  const toff_t size = ts->sink->size();
+  if (ts->pos >= size || t_size <= 0)
+  {
+    return 0;
+  }
+  const auto n = std::min<toff_t>(t_size, size - ts->pos);
+  std::memcpy(t_buf, ts->sink->data() + ts->pos, n);
+  ts->pos += n;
+  return static_cast<tmsize_t>(n);
+}
+
+tmsize_t tiff_write(thandle_t t_handle, void* t_buf, tmsize_t t_size)
+{
+  auto* ts = static_cast<tiff_sink*>(t_handle);
+  if (t_size <= 0)
+  {
+    return 0;
+  }
+  const toff_t end = ts->pos + t_size;
+  const toff_t size = ts->sink->size();
+  if (end > size)
+  {
+    uint8_t* tail = ts->sink->extend(end - size);
+    if (ts->pos > size)
+    {
+      // Seeked beyond the end, the gap reads as zeros
+      std::memset(tail, 0, ts->pos - size);
+    }
+  }
+  std::memcpy(ts->sink->data() + ts->pos, t_buf, t_size);
+  ts->pos = end;
+  return t_size;
+}
+
+toff_t tiff_seek(thandle_t t_handle, toff_t t_offset, int t_whence)
+{
+  auto* ts = static_cast<tiff_sink*>(t_handle);
+  switch (t_whence)
+  {
+    case SEEK_CUR:
+      ts->pos += t_offset;
+      break;
+    case SEEK_END:
+      ts->pos = ts->sink->size() + t_offset;
+      break;
+    default:
+      ts->pos = t_offset;
+      break;
+  }
+  return ts->pos;
+}
+
+int tiff_close(thandle_t)
+{
+  return 0;
+}
+
+toff_t tiff_size(thandle_t t_handle)
+{
+  return static_cast<tiff_sink*>(t_handle)->sink->size();
+}
+
+int tiff_map(thandle_t, void**, toff_t*)
+{
+  return 0;
+}
+
+void tiff_unmap(thandle_t, void*, toff_t) {}
+}  // namespace
+
 // see: https://research.cs.wisc.edu/graphics/Courses/638-f1999/libtiff_tutorial.htm
 void RendererCairoTiff::render(const Page& t_page, double t_scale)
 {
@@ -521,12 +805,18 @@ void RendererCairoTiff::render(const Page& t_page, double t_scale)
   surface = cairo_image_surface_create_for_data(raw_buffer.data(), CAIRO_FORMAT_ARGB32,
                                                 width, height, stride);
 
-  cr = cairo_create(surface);
-  cairo_scale(cr, t_scale, t_scale);
-  render_page(&t_page);
+  render_image(&t_page, t_scale, surface);
 
-  std::ostringstream tiff_ostream;
-  TIFF* tiff = TIFFStreamOpen("memory", &tiff_ostream);  // filename is ignored
+  m_render_data.clear();
+  m_render_data.reserve(raster_reserve(width, height));
+  tiff_sink sink{&m_render_data, 0};
+  TIFF* tiff = TIFFClientOpen("memory", "w", &sink, tiff_read, tiff_write, tiff_seek,
+                              tiff_close, tiff_size, tiff_map, tiff_unmap);
+  if (!tiff)
+  {
+    cairo_surface_destroy(surface);
+    return;
+  }
 
   TIFFSetField(tiff, TIFFTAG_IMAGEWIDTH, width);
   TIFFSetField(tiff, TIFFTAG_IMAGELENGTH, height);
@@ -563,16 +853,12 @@ void RendererCairoTiff::render(const Page& t_page, double t_scale)
 
   TIFFClose(tiff);
 
-  cairo_destroy(cr);
   cairo_surface_destroy(surface);
-
-  const auto out = tiff_ostream.str();
-  m_render_data.assign(out.begin(), out.end());
 }
 
 void RendererCairoTiff::get_data(const uint8_t** t_buf, size_t* t_size) const
 {
-  *t_buf = &m_render_data[0];
+  *t_buf = m_render_data.data();
   *t_size = m_render_data.size();
 }
 
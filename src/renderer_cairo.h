@@ -6,8 +6,7 @@
 #include <cairo.h>
 #include <vector>
 
-#include <fmt/format.h>
-
+#include "byte_sink.h"
 #include "draw_data.h"
 #include "renderers.h"
 
@@ -26,12 +25,32 @@ class RendererCairo : public draw_call_visitor
   void visit(const Polygon* t_polygon) override;
   void visit(const Path* t_path) override;
   void visit(const Raster* t_raster) override;
+  void visit(const CircleRun* t_run) override;
+  void visit(const LineRun* t_run) override;
+  void visit(const RectRun* t_run) override;
 
   void render_page(const Page* t_page);
+  // Renders the page into an image surface. With more than one raster thread the image
+  // is split into horizontal bands that are drawn concurrently, straight into the rows
+  // of the surface.
+  void render_image(const Page* t_page, double t_scale, cairo_surface_t* t_surface);
 
  protected:
   cairo_surface_t* surface = nullptr;
   cairo_t* cr = nullptr;
+  const style_table* m_styles = nullptr;
+  unsigned m_threads = 1;
+
+ private:
+  // When drawing a band, draw calls outside of it (in page coordinates) are skipped.
+  bool m_banded = false;
+  grect<double> m_band{};
+
+  template <class T>
+  bool m_outside_band(const T& t_dc) const
+  {
+    return m_banded && !rect_intersects(t_dc.bounds(*m_styles), m_band);
+  }
 };
 
 class RendererCairoPng : public render_target, public RendererCairo
@@ -39,9 +58,11 @@ class RendererCairoPng : public render_target, public RendererCairo
  public:
   void render(const Page& t_page, double t_scale) override;
   void get_data(const uint8_t** t_buf, size_t* t_size) const override;
+  bool stream(const Page& t_page, double t_scale, const chunk_fn& t_chunk) override;
+  void raster_threads(unsigned t_threads) override { m_threads = t_threads; }
 
  private:
-  std::vector<unsigned char> m_render_data{};
+  byte_sink m_render_data;
 };
 
 class RendererCairoPngBase64 : public render_target, public RendererCairo
@@ -49,9 +70,10 @@ class RendererCairoPngBase64 : public render_target, public RendererCairo
  public:
   void render(const Page& t_page, double t_scale) override;
   void get_data(const uint8_t** t_buf, size_t* t_size) const override;
+  void raster_threads(unsigned t_threads) override { m_threads = t_threads; }
 
  private:
-  std::string m_buf;
+  byte_sink m_render_data;
 };
 
 class RendererCairoPdf : public render_target, public RendererCairo
@@ -59,9 +81,10 @@ class RendererCairoPdf : public render_target, public RendererCairo
  public:
   void render(const Page& t_page, double t_scale) override;
   void get_data(const uint8_t** t_buf, size_t* t_size) const override;
+  bool stream(const Page& t_page, double t_scale, const chunk_fn& t_chunk) override;
 
  private:
-  std::vector<unsigned char> m_render_data{};
+  byte_sink m_render_data;
 };
 
 class RendererCairoPs : public render_target, public RendererCairo
@@ -69,9 +92,10 @@ class RendererCairoPs : public render_target, public RendererCairo
  public:
   void render(const Page& t_page, double t_scale) override;
   void get_data(const uint8_t** t_buf, size_t* t_size) const override;
+  bool stream(const Page& t_page, double t_scale, const chunk_fn& t_chunk) override;
 
  private:
-  fmt::memory_buffer m_os;
+  byte_sink m_render_data;
 };
 
 class RendererCairoEps : public render_target, public RendererCairo
@@ -79,9 +103,10 @@ class RendererCairoEps : public render_target, public RendererCairo
  public:
   void render(const Page& t_page, double t_scale) override;
   void get_data(const uint8_t** t_buf, size_t* t_size) const override;
+  bool stream(const Page& t_page, double t_scale, const chunk_fn& t_chunk) override;
 
  private:
-  fmt::memory_buffer m_os;
+  byte_sink m_render_data;
 };
 
 #ifndef UNIGD_NO_TIFF
@@ -91,9 +116,10 @@ class RendererCairoTiff : public render_target, public RendererCairo
  public:
   void render(const Page& t_page, double t_scale) override;
   void get_data(const uint8_t** t_buf, size_t* t_size) const override;
+  void raster_threads(unsigned t_threads) override { m_threads = t_threads; }
 
  private:
-  std::vector<unsigned char> m_render_data{};
+  byte_sink m_render_data;
 };
 
 #endif /* UNIGD_NO_TIFF */
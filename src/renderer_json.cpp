@@ -1,6 +1,7 @@
 #include "renderer_json.h"
 
 #include "base_64.h"
+#include "text_writer.h"
 
 namespace unigd
 {
@@ -13,6 +14,14 @@ static inline std::string hexcol(color_t t_color)
                      color::blue(t_color));
 }
 
+// Writes "#RRGGBB" in quotes.
+static inline void json_color(fmt::memory_buffer& os, color_t t_color)
+{
+  write_literal(os, "\"#");
+  write_hex_color(os, t_color);
+  write_literal(os, "\"");
+}
+
 static inline std::string json_lineinfo(const LineInfo& t_line)
 {
   return fmt::format(
@@ -24,16 +33,16 @@ static inline std::string json_lineinfo(const LineInfo& t_line)
 static inline void json_verts(fmt::memory_buffer& os,
                               const std::vector<unigd::gvertex<double>>& t_verts)
 {
-  fmt::format_to(std::back_inserter(os), "[");
+  write_literal(os, "[");
   for (auto it = t_verts.begin(); it != t_verts.end(); ++it)
   {
     if (it != t_verts.begin())
     {
-      fmt::format_to(std::back_inserter(os), ", ");
+      write_literal(os, ", ");
     }
-    fmt::format_to(std::back_inserter(os), "[ {:.2f}, {:.2f} ]", it->x, it->y);
+    write_all(os, "[ ", it->x, ", ", it->y, " ]");
   }
-  fmt::format_to(std::back_inserter(os), "]");
+  write_literal(os, "]");
 }
 
 void RendererJSON::render(const Page& t_page, double t_scale)
@@ -50,111 +59,114 @@ void RendererJSON::get_data(const uint8_t** t_buf, size_t* t_size) const
 
 void RendererJSON::page(const Page& t_page)
 {
+  m_styles = &t_page.styles;
+  m_lines.clear();
+  for (const auto& line : t_page.styles.lines())
+  {
+    m_lines.push_back(json_lineinfo(line));
+  }
   fmt::format_to(
       std::back_inserter(os),
       "{{\n "
       R""("id": "{}", "w": {:.2f}, "h": {:.2f}, "scale": {:.2f}, "fill": "{}",)""
       "\n",
       t_page.id, t_page.size.x, t_page.size.y, m_scale, hexcol(t_page.fill));
-  fmt::format_to(std::back_inserter(os), " \"clips\": [\n  ");
+  write_literal(os, " \"clips\": [\n  ");
   for (auto it = t_page.cps.begin(); it != t_page.cps.end(); ++it)
   {
     if (it != t_page.cps.begin())
     {
-      fmt::format_to(std::back_inserter(os), ",\n  ");
+      write_literal(os, ",\n  ");
     }
-    fmt::format_to(
-        std::back_inserter(os),
-        R""({{ "id": {}, "x": {:.2f}, "y": {:.2f}, "w": {:.2f}, "h": {:.2f} }})"", it->id,
-        it->rect.x, it->rect.y, it->rect.width, it->rect.height);
+    write_all(os, R""({ "id": )"", it->id, R""(, "x": )"", it->rect.x, R""(, "y": )"",
+              it->rect.y, R""(, "w": )"", it->rect.width, R""(, "h": )"", it->rect.height,
+              " }");
   }
 
-  fmt::format_to(std::back_inserter(os), "\n ],\n \"draw_calls\": [\n  ");
+  write_literal(os, "\n ],\n \"draw_calls\": [\n  ");
   for (auto it = t_page.dcs.begin(); it != t_page.dcs.end(); ++it)
   {
     if (it != t_page.dcs.begin())
     {
-      fmt::format_to(std::back_inserter(os), ",\n  ");
+      write_literal(os, ",\n  ");
     }
-    fmt::format_to(std::back_inserter(os), "{{ ");
+    write_literal(os, "{ ");
     (*it)->visit(this);
-    fmt::format_to(std::back_inserter(os), " }}");
+    write_literal(os, " }");
   }
-  fmt::format_to(std::back_inserter(os), "\n ]\n}}");
+  write_literal(os, "\n ]\n}");
 }
 
 void RendererJSON::visit(const Rect* t_rect)
 {
-  fmt::format_to(
-      std::back_inserter(os),
-      R""("type": "rect", "clip_id": {}, "x": {:.2f}, "y": {:.2f}, "w": {:.2f}, "h": {:.2f}, "line": {})"",
-      t_rect->clip_id, t_rect->rect.x, t_rect->rect.y, t_rect->rect.width,
-      t_rect->rect.height, json_lineinfo(t_rect->line));
+  write_all(os, R""("type": "rect", "clip_id": )"", t_rect->clip_id, R""(, "x": )"",
+            t_rect->rect.x, R""(, "y": )"", t_rect->rect.y, R""(, "w": )"",
+            t_rect->rect.width, R""(, "h": )"", t_rect->rect.height, R""(, "line": )"",
+            m_lines[t_rect->line]);
 }
 
 void RendererJSON::visit(const Text* t_text)
 {
-  fmt::format_to(
-      std::back_inserter(os),
-      R""("type": "text", "clip_id": {}, "x": {:.2f}, "y": {:.2f}, "rot": {:.2f}, "hadj": {:.2f}, "col": "{}", "str": "{}", )""
-      R""("weight": {}, "features": "{}", "font_family": "{}", "fontsize": {:.2f}, "italic": {}, "txtwidth_px": {:.2f})"",
-      t_text->clip_id, t_text->pos.x, t_text->pos.y, t_text->rot, t_text->hadj,
-      hexcol(t_text->col), t_text->str, t_text->text.weight, t_text->text.features,
-      t_text->text.font_family, t_text->text.fontsize, t_text->text.italic,
-      t_text->text.txtwidth_px);
+  const auto& text = m_styles->text(t_text->text);
+  write_all(os, R""("type": "text", "clip_id": )"", t_text->clip_id, R""(, "x": )"",
+            t_text->pos.x, R""(, "y": )"", t_text->pos.y, R""(, "rot": )"", t_text->rot,
+            R""(, "hadj": )"", t_text->hadj, R""(, "col": )"");
+  json_color(os, t_text->col);
+  write_all(os, R""(, "str": ")"", t_text->str, R""(", "weight": )"", text.weight,
+            R""(, "features": ")"", text.features, R""(", "font_family": ")"",
+            text.font_family, R""(", "fontsize": )"", text.fontsize, R""(, "italic": )"",
+            text.italic, R""(, "txtwidth_px": )"", t_text->txtwidth_px);
 }
 
 void RendererJSON::visit(const Circle* t_circle)
 {
-  fmt::format_to(
-      std::back_inserter(os),
-      R""("type": "circle", "clip_id": {}, "x": {:.2f}, "y": {:.2f}, "r": {:.2f}, "fill": "{}", "line": {})"",
-      t_circle->clip_id, t_circle->pos.x, t_circle->pos.y, t_circle->radius,
-      hexcol(t_circle->fill), json_lineinfo(t_circle->line));
+  write_all(os, R""("type": "circle", "clip_id": )"", t_circle->clip_id, R""(, "x": )"",
+            t_circle->pos.x, R""(, "y": )"", t_circle->pos.y, R""(, "r": )"",
+            t_circle->radius, R""(, "fill": )"");
+  json_color(os, t_circle->fill);
+  write_all(os, R""(, "line": )"", m_lines[t_circle->line]);
 }
 
 void RendererJSON::visit(const Line* t_line)
 {
-  fmt::format_to(
-      std::back_inserter(os),
-      R""("type": "line", "clip_id": {}, "x0": {:.2f}, "y0": {:.2f}, "x1": {:.2f}, "y1": {:.2f}, "line": {})"",
-      t_line->clip_id, t_line->orig.x, t_line->orig.y, t_line->dest.x, t_line->dest.y,
-      json_lineinfo(t_line->line));
+  write_all(os, R""("type": "line", "clip_id": )"", t_line->clip_id, R""(, "x0": )"",
+            t_line->orig.x, R""(, "y0": )"", t_line->orig.y, R""(, "x1": )"",
+            t_line->dest.x, R""(, "y1": )"", t_line->dest.y, R""(, "line": )"",
+            m_lines[t_line->line]);
 }
 
 void RendererJSON::visit(const Polyline* t_polyline)
 {
-  fmt::format_to(std::back_inserter(os),
-                 R""("type": "polyline", "clip_id": {}, "line": {}, "points": )"",
-                 t_polyline->clip_id, json_lineinfo(t_polyline->line));
+  write_all(os, R""("type": "polyline", "clip_id": )"", t_polyline->clip_id,
+            R""(, "line": )"", m_lines[t_polyline->line], R""(, "points": )"");
   json_verts(os, t_polyline->points);
 }
 
 void RendererJSON::visit(const Polygon* t_polygon)
 {
-  fmt::format_to(
-      std::back_inserter(os),
-      R""("type": "polygon", "clip_id": {}, "fill": "{}", "line": {}, "points": )"",
-      t_polygon->clip_id, hexcol(t_polygon->fill), json_lineinfo(t_polygon->line));
+  write_all(os, R""("type": "polygon", "clip_id": )"", t_polygon->clip_id,
+            R""(, "fill": )"");
+  json_color(os, t_polygon->fill);
+  write_all(os, R""(, "line": )"", m_lines[t_polygon->line], R""(, "points": )"");
   json_verts(os, t_polygon->points);
 }
 
 void RendererJSON::visit(const Path* t_path)
 {
-  fmt::format_to(std::back_inserter(os),
-                 R""("type": "path", "clip_id": {}, "fill": "{}", "line": {}, "nper": )"",
-                 t_path->clip_id, hexcol(t_path->fill), json_lineinfo(t_path->line));
+  write_all(os, R""("type": "path", "clip_id": )"", t_path->clip_id, R""(, "fill": )"");
+  json_color(os, t_path->fill);
+  write_all(os, R""(, "line": )"", m_lines[t_path->line], R""(, "nper": )"");
 
-  fmt::format_to(std::back_inserter(os), "[");
+  write_literal(os, "[");
   for (auto it = t_path->nper.begin(); it != t_path->nper.end(); ++it)
   {
     if (it != t_path->nper.begin())
     {
-      fmt::format_to(std::back_inserter(os), ", ");
+      write_literal(os, ", ");
     }
-    fmt::format_to(std::back_inserter(os), "{}", *it);
+    write_int(os, *it);
   }
-  fmt::format_to(std::back_inserter(os), R""(], "points": )"");
+  write_literal(os, R""(], "points": )"");
   json_verts(os, t_path->points);
 }
 
@@ -168,5 +180,10 @@ void RendererJSON::visit(const Raster* t_raster)
       raster_base64(*t_raster));
 }
 
+void RendererJSON::run_separator()
+{
+  write_literal(os, " },\n  { ");
+}
+
 }  // namespace renderers
 }  // namespace unigd
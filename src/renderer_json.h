@@ -1,6 +1,9 @@
 #ifndef __UNIGD_RENDERER_JSON_H__
 #define __UNIGD_RENDERER_JSON_H__
 
+#include <string>
+#include <vector>
+
 #include <fmt/format.h>
 
 #include "renderers.h"
@@ -26,10 +29,14 @@ class RendererJSON : public render_target, public draw_call_visitor
   void visit(const Polygon* t_polygon) override;
   void visit(const Path* t_path) override;
   void visit(const Raster* t_raster) override;
+  void run_separator() override;
 
  private:
   fmt::memory_buffer os;
   double m_scale;
+  const style_table* m_styles = nullptr;
+  // Formatted line styles of the page
+  std::vector<std::string> m_lines;
 };
 
 }  // namespace renderers
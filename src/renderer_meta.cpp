@@ -21,10 +21,14 @@ void RendererMeta::page(const Page& t_page)
   fmt::format_to(
       std::back_inserter(os),
       "{{\n "
-      R""("id": "{}", "w": {:.2f}, "h": {:.2f}, "scale": {:.2f}, clips: {}, draw_calls: {})""
+      R""("id": "{}", "w": {:.2f}, "h": {:.2f}, "scale": {:.2f}, )""
+      R""(clips: {}, draw_calls: {}, culled: {}, blocks: {}, allocations: {}, )""
+      R""(styles: {})""
       "\n}}",
       t_page.id, t_page.size.x, t_page.size.y, m_scale, t_page.cps.size(),
-      t_page.dcs.size());
+      t_page.draw_call_count(), t_page.culled, t_page.dcs.blocks(),
+      t_page.dcs.allocations(),
+      t_page.styles.lines().size() + t_page.styles.texts().size());
 }
 
 }  // namespace renderers
@@ -7,6 +7,7 @@
 
 #include "base_64.h"
 #include "compress.h"
+#include "text_writer.h"
 #include "uuid.h"
 
 namespace unigd
@@ -14,47 +15,21 @@ namespace unigd
 namespace renderers
 {
 
-static inline void write_xml_escaped(fmt::memory_buffer& os, const std::string& text)
-{
-  for (const char& c : text)
-  {
-    switch (c)
-    {
-      case '&':
-        fmt::format_to(std::back_inserter(os), "&amp;");
-        break;
-      case '<':
-        fmt::format_to(std::back_inserter(os), "&lt;");
-        break;
-      case '>':
-        fmt::format_to(std::back_inserter(os), "&gt;");
-        break;
-      case '"':
-        fmt::format_to(std::back_inserter(os), "&quot;");
-        break;
-      case '\'':
-        fmt::format_to(std::back_inserter(os), "&apos;");
-        break;
-      default:
-        fmt::format_to(std::back_inserter(os), "{}", c);
-    }
-  }
-}
-
 static inline void css_fill_or_none(fmt::memory_buffer& os, color_t col)
 {
   int alpha = color::alpha(col);
   if (alpha == 0)
   {
-    fmt::format_to(std::back_inserter(os), "fill: none;");
+    write_literal(os, "fill: none;");
   }
   else
   {
-    fmt::format_to(std::back_inserter(os), "fill: #{:02X}{:02X}{:02X};", color::red(col),
-                   color::green(col), color::blue(col));
+    write_literal(os, "fill: #");
+    write_hex_color(os, col);
+    write_literal(os, ";");
     if (alpha != 255)
     {
-      fmt::format_to(std::back_inserter(os), "fill-opacity: {:.2f};", alpha / 255.0);
+      write_all(os, "fill-opacity: ", alpha / 255.0, ";");
     }
   }
 }
@@ -64,11 +39,12 @@ static inline void css_fill_or_omit(fmt::memory_buffer& os, color_t col)
   int alpha = color::alpha(col);
   if (alpha != 0)
   {
-    fmt::format_to(std::back_inserter(os), "fill: #{:02X}{:02X}{:02X};", color::red(col),
-                   color::green(col), color::blue(col));
+    write_literal(os, "fill: #");
+    write_hex_color(os, col);
+    write_literal(os, ";");
     if (alpha != 255)
     {
-      fmt::format_to(std::back_inserter(os), "fill-opacity: {:.2f};", alpha / 255.0);
+      write_all(os, "fill-opacity: ", alpha / 255.0, ";");
     }
   }
 }
@@ -83,7 +59,7 @@ static inline double scale_lty(int lty, double lwd)
 static inline void css_lineinfo(fmt::memory_buffer& os, const LineInfo& line)
 {
   // 1 lwd = 1/96", but units in rest of document are 1/72"
-  fmt::format_to(std::back_inserter(os), "stroke-width: {:.2f};", line.lwd / 96.0 * 72);
+  write_all(os, "stroke-width: ", line.lwd / 96.0 * 72, ";");
 
   // Default is "stroke: #000000;" as declared in <style>
   if (line.col != color::rgba(0, 0, 0, 255))
@@ -91,16 +67,16 @@ static inline void css_lineinfo(fmt::memory_buffer& os, const LineInfo& line)
     int alpha = color::alpha(line.col);
     if (alpha == 0)
     {
-      fmt::format_to(std::back_inserter(os), "stroke: none;");
+      write_literal(os, "stroke: none;");
     }
     else
     {
-      fmt::format_to(std::back_inserter(os), "stroke: #{:02X}{:02X}{:02X};",
-                     color::red(line.col), color::green(line.col), color::blue(line.col));
+      write_literal(os, "stroke: #");
+      write_hex_color(os, line.col);
+      write_literal(os, ";");
       if (alpha != color::byte_mask)
       {
-        fmt::format_to(std::back_inserter(os), "stroke-opacity: {:.2f};",
-                       color::byte_frac(alpha));
+        write_all(os, "stroke-opacity: ", color::byte_frac(alpha), ";");
       }
     }
   }
@@ -115,17 +91,17 @@ static inline void css_lineinfo(fmt::memory_buffer& os, const LineInfo& line)
     default:
       // For details
       // https://github.com/wch/r-source/blob/trunk/src/include/R_ext/GraphicsEngine.h#L337
-      fmt::format_to(std::back_inserter(os), " stroke-dasharray: ");
+      write_literal(os, " stroke-dasharray: ");
       // First number
-      fmt::format_to(std::back_inserter(os), "{:.2f}", scale_lty(lty, line.lwd));
+      write_all(os, scale_lty(lty, line.lwd));
       lty = lty >> 4;
       // Remaining numbers
       for (int i = 1; i < 8 && lty & 15; i++)
       {
-        fmt::format_to(std::back_inserter(os), ", {:.2f}", scale_lty(lty, line.lwd));
+        write_all(os, ", ", scale_lty(lty, line.lwd));
         lty = lty >> 4;
       }
-      fmt::format_to(std::back_inserter(os), ";");
+      write_literal(os, ";");
       break;
   }
 
@@ -135,10 +111,10 @@ static inline void css_lineinfo(fmt::memory_buffer& os, const LineInfo& line)
     case LineInfo::GC_ROUND_CAP:  // declared to be default in <style>
       break;
     case LineInfo::GC_BUTT_CAP:
-      fmt::format_to(std::back_inserter(os), "stroke-linecap: butt;");
+      write_literal(os, "stroke-linecap: butt;");
       break;
     case LineInfo::GC_SQUARE_CAP:
-      fmt::format_to(std::back_inserter(os), "stroke-linecap: square;");
+      write_literal(os, "stroke-linecap: square;");
       break;
     default:
       break;
@@ -150,13 +126,13 @@ static inline void css_lineinfo(fmt::memory_buffer& os, const LineInfo& line)
     case LineInfo::GC_ROUND_JOIN:  // declared to be default in <style>
       break;
     case LineInfo::GC_BEVEL_JOIN:
-      fmt::format_to(std::back_inserter(os), "stroke-linejoin: bevel;");
+      write_literal(os, "stroke-linejoin: bevel;");
       break;
     case LineInfo::GC_MITRE_JOIN:
-      fmt::format_to(std::back_inserter(os), "stroke-linejoin: miter;");
+      write_literal(os, "stroke-linejoin: miter;");
       if (std::fabs(line.lmitre - 10.0) > 1e-3)
       {  // 10 is declared to be the default in <style>
-        fmt::format_to(std::back_inserter(os), "stroke-miterlimit: {:.2f};", line.lmitre);
+        write_all(os, "stroke-miterlimit: ", line.lmitre, ";");
       }
       break;
     default:
@@ -164,13 +140,134 @@ static inline void css_lineinfo(fmt::memory_buffer& os, const LineInfo& line)
   }
 }
 
-RendererSVG::RendererSVG(std::experimental::optional<std::string> t_extra_css)
-    : os(), m_extra_css(t_extra_css)
+// Formats a style table, so every style is formatted only once per page (or run).
+template <class S, class F>
+static std::vector<std::string> format_styles(const std::vector<S>& t_styles, F t_format)
+{
+  std::vector<std::string> formatted;
+  formatted.reserve(t_styles.size());
+  fmt::memory_buffer buf;
+  for (const auto& style : t_styles)
+  {
+    buf.clear();
+    t_format(buf, style);
+    formatted.emplace_back(buf.data(), buf.size());
+  }
+  return formatted;
+}
+
+static inline void append(fmt::memory_buffer& os, const std::string& t_str)
+{
+  os.append(t_str.data(), t_str.data() + t_str.size());
+}
+
+static inline void css_font(fmt::memory_buffer& os, const TextInfo& t_text)
+{
+  fmt::format_to(std::back_inserter(os), "font-family: {};font-size: {:.2f}px;",
+                 t_text.font_family, t_text.fontsize);
+
+  if (t_text.weight != 400)
+  {
+    if (t_text.weight == 700)
+    {
+      write_literal(os, "font-weight: bold;");
+    }
+    else
+    {
+      fmt::format_to(std::back_inserter(os), "font-weight: {};", t_text.weight);
+    }
+  }
+  if (t_text.italic)
+  {
+    write_literal(os, "font-style: italic;");
+  }
+}
+
+static inline void css_font_features(fmt::memory_buffer& os, const TextInfo& t_text)
+{
+  if (t_text.features.length() > 0)
+  {
+    fmt::format_to(std::back_inserter(os), "font-feature-settings: {};",
+                   t_text.features);
+  }
+}
+
+namespace
+{
+constexpr color_t no_fill = color::rgba(0, 0, 0, 0);
+
+// Calls f(line style, fill) for the stroke and fill of every shape of a page. Shapes that
+// are never filled report a transparent fill.
+template <class F>
+class shape_style_visitor : public draw_call_visitor
+{
+ public:
+  explicit shape_style_visitor(F t_fn) : m_fn(t_fn) {}
+
+  void visit(const Rect* t_rect) override { m_fn(t_rect->line, t_rect->fill); }
+  void visit(const Text* t_text) override {}
+  void visit(const Circle* t_circle) override { m_fn(t_circle->line, t_circle->fill); }
+  void visit(const Line* t_line) override { m_fn(t_line->line, no_fill); }
+  void visit(const Polyline* t_polyline) override
+  {
+    m_fn(t_polyline->line, no_fill);
+  }
+  void visit(const Polygon* t_polygon) override
+  {
+    m_fn(t_polygon->line, t_polygon->fill);
+  }
+  void visit(const Path* t_path) override { m_fn(t_path->line, t_path->fill); }
+  void visit(const Raster* t_raster) override {}
+  void visit(const CircleRun* t_run) override { m_styles(t_run->styles); }
+  void visit(const LineRun* t_run) override
+  {
+    for (const auto line : t_run->styles)
+    {
+      m_fn(line, no_fill);
+    }
+  }
+  void visit(const RectRun* t_run) override { m_styles(t_run->styles); }
+
+ private:
+  F m_fn;
+
+  void m_styles(const std::vector<ShapeStyle>& t_styles)
+  {
+    for (const auto& style : t_styles)
+    {
+      m_fn(style.line, style.fill);
+    }
+  }
+};
+
+// Fully transparent fills are all written the same way (omitted).
+inline uint64_t shape_class_key(style_id_t t_line, color_t t_fill)
+{
+  const color_t fill = color::alpha(t_fill) == 0 ? no_fill : t_fill;
+  return (static_cast<uint64_t>(t_line) << 32) | fill;
+}
+}  // namespace
+
+bool svg_stream::m_flush(fmt::memory_buffer& t_os)
+{
+  m_stopped = !stream_buffer(reinterpret_cast<const uint8_t*>(t_os.data()),
+                             t_os.size(), *m_chunk);
+  t_os.clear();
+  return !m_stopped;
+}
+
+RendererSVG::RendererSVG(std::experimental::optional<std::string> t_extra_css,
+                         bool t_css_classes)
+    : os(), m_extra_css(t_extra_css), m_css_classes(t_css_classes)
 {
 }
 
 void RendererSVG::render(const Page& t_page, double t_scale)
 {
+  if (m_css_classes)
+  {
+    m_unique_id = unigd::uuid::uuid();
+  }
   m_scale = t_scale;
   this->page(t_page);
 }
@@ -181,16 +278,50 @@ void RendererSVG::get_data(const uint8_t** t_buf, size_t* t_size) const
   *t_size = os.size();
 }
 
+bool RendererSVG::stream(const Page& t_page, double t_scale, const chunk_fn& t_chunk)
+{
+  return m_stream.run(os, t_chunk, [&]() { render(t_page, t_scale); });
+}
+
 void RendererSVG::page(const Page& t_page)
 {
-  os.reserve((t_page.dcs.size() + t_page.cps.size()) * 128 + 512);
+  m_styles = &t_page.styles;
+  m_lines = format_styles(t_page.styles.lines(), css_lineinfo);
+  m_classes.clear();
+  std::vector<std::pair<style_id_t, color_t>> classes;
+  if (m_css_classes)
+  {
+    // Pre-pass: number the distinct shape styles in order of appearance.
+    auto add_class = [&](style_id_t t_line, color_t t_fill)
+    {
+      if (m_classes.emplace(shape_class_key(t_line, t_fill), classes.size()).second)
+      {
+        classes.emplace_back(t_line, t_fill);
+      }
+    };
+    shape_style_visitor<decltype(add_class)> collect(add_class);
+    for (const auto& dc : t_page.dcs)
+    {
+      dc->visit(&collect);
+    }
+  }
+  // Streamed documents never hold much more than a chunk.
+  os.reserve(m_stream.active() ? stream_chunk_size
+                     : (t_page.draw_call_count() + t_page.cps.size()) *
+                               (m_css_classes ? 80 : 128) +
+                           classes.size() * 128 + 512);
   fmt::format_to(
       std::back_inserter(os),
       R""(<svg xmlns="http://www.w3.org/2000/svg" xmlns:xlink="http://www.w3.org/1999/xlink" class="httpgd" )"");
-  fmt::format_to(std::back_inserter(os),
-                 R""(width="{:.2f}" height="{:.2f}" viewBox="0 0 {:.2f} {:.2f}")"",
-                 t_page.size.x * m_scale, t_page.size.y * m_scale, t_page.size.x,
-                 t_page.size.y);
+  if (m_css_classes)
+  {
+    // The class rules only apply to this document, even when several are inlined in
+    // the same HTML page.
+    fmt::format_to(std::back_inserter(os), R""(id="ugd-{}" )"", m_unique_id);
+  }
+  write_all(os, "width=\"", t_page.size.x * m_scale, "\" height=\"",
+            t_page.size.y * m_scale, "\" viewBox=\"0 0 ", t_page.size.x, " ",
+            t_page.size.y, "\"");
   fmt::format_to(std::back_inserter(os),
                  ">\n<defs>\n"
                  "  <style type='text/css'><![CDATA[\n"
@@ -202,11 +333,29 @@ void RendererSVG::page(const Page& t_page)
                  "      stroke-linejoin: round;\n"
                  "      stroke-miterlimit: 10.00;\n"
                  "    }}\n");
+  // Id selectors take precedence over the element defaults above.
+  for (std::size_t i = 0; i != classes.size(); ++i)
+  {
+    fmt::format_to(std::back_inserter(os), "    #ugd-{} .s{} {{ ", m_unique_id, i);
+    append(os, m_lines[classes[i].first]);
+    css_fill_or_omit(os, classes[i].second);
+    fmt::format_to(std::back_inserter(os), " }}\n");
+  }
+  if (m_css_classes)
+  {
+    for (std::size_t i = 0; i != t_page.styles.texts().size(); ++i)
+    {
+      fmt::format_to(std::back_inserter(os), "    #ugd-{} .t{} {{ ", m_unique_id, i);
+      css_font(os, t_page.styles.text(static_cast<style_id_t>(i)));
+      css_font_features(os, t_page.styles.text(static_cast<style_id_t>(i)));
+      fmt::format_to(std::back_inserter(os), " }}\n");
+    }
+  }
   if (m_extra_css)
   {
     fmt::format_to(std::back_inserter(os), "{}\n", *m_extra_css);
   }
-  fmt::format_to(std::back_inserter(os), "  ]]></style>\n");
+  write_literal(os, "  ]]></style>\n");
 
   for (const auto& cp : t_page.cps)
   {
@@ -241,9 +390,13 @@ void RendererSVG::page(const Page& t_page)
       last_id = dc->clip_id;
     }
     dc->visit(this);
-    fmt::format_to(std::back_inserter(os), "\n");
+    write_literal(os, "\n");
+    if (!m_stream.flush_chunk(os))
+    {
+      return;
+    }
   }
-  fmt::format_to(std::back_inserter(os), "</g>\n</svg>");
+  write_literal(os, "</g>\n</svg>");
 }
 
 void RendererSVG::visit(const Text* t_text)
@@ -251,146 +404,127 @@ void RendererSVG::visit(const Text* t_text)
   // If we specify the clip path inside <image>, the "transform" also
   // affects the clip path, so we need to specify clip path at an outer level
   // (according to svglite)
-  fmt::format_to(std::back_inserter(os), "<g><text ");
+  write_literal(os, "<g><text ");
 
   if (t_text->rot == 0.0)
   {
-    fmt::format_to(std::back_inserter(os), R""(x="{:.2f}" y="{:.2f}" )"", t_text->pos.x,
-                   t_text->pos.y);
+    write_all(os, "x=\"", t_text->pos.x, "\" y=\"", t_text->pos.y, "\" ");
   }
   else
   {
-    fmt::format_to(std::back_inserter(os),
-                   R""(transform="translate({:.2f},{:.2f}) rotate({:.2f})" )"",
-                   t_text->pos.x, t_text->pos.y, t_text->rot * -1.0);
+    write_all(os, "transform=\"translate(", t_text->pos.x, ",", t_text->pos.y,
+              ") rotate(", t_text->rot * -1.0, ")\" ");
   }
 
   if (t_text->hadj == 0.5)
   {
-    fmt::format_to(std::back_inserter(os), R""(text-anchor="middle" )"");
+    write_literal(os, R""(text-anchor="middle" )"");
   }
   else if (t_text->hadj == 1)
   {
-    fmt::format_to(std::back_inserter(os), R""(text-anchor="end" )"");
+    write_literal(os, R""(text-anchor="end" )"");
   }
 
-  fmt::format_to(std::back_inserter(os), "style=\"");
-  fmt::format_to(std::back_inserter(os), "font-family: {};font-size: {:.2f}px;",
-                 t_text->text.font_family, t_text->text.fontsize);
-
-  if (t_text->text.weight != 400)
+  if (m_css_classes)
   {
-    if (t_text->text.weight == 700)
-    {
-      fmt::format_to(std::back_inserter(os), "font-weight: bold;");
-    }
-    else
+    write_all(os, "class=\"t", t_text->text, "\"");
+    if (t_text->col != (int)color::rgb(0, 0, 0))
     {
-      fmt::format_to(std::back_inserter(os), "font-weight: {};", t_text->text.weight);
+      write_literal(os, " style=\"");
+      css_fill_or_none(os, t_text->col);
+      write_literal(os, "\"");
     }
   }
-  if (t_text->text.italic)
-  {
-    fmt::format_to(std::back_inserter(os), "font-style: italic;");
-  }
-  if (t_text->col != (int)color::rgb(0, 0, 0))
-  {
-    css_fill_or_none(os, t_text->col);
-  }
-  if (t_text->text.features.length() > 0)
+  else
   {
-    fmt::format_to(std::back_inserter(os), "font-feature-settings: {};",
-                   t_text->text.features);
+    const auto& text = m_styles->text(t_text->text);
+    write_literal(os, "style=\"");
+    css_font(os, text);
+    if (t_text->col != (int)color::rgb(0, 0, 0))
+    {
+      css_fill_or_none(os, t_text->col);
+    }
+    css_font_features(os, text);
+    write_literal(os, "\"");
   }
-  fmt::format_to(std::back_inserter(os), "\"");
-  if (t_text->text.txtwidth_px > 0)
+  if (t_text->txtwidth_px > 0)
   {
-    fmt::format_to(std::back_inserter(os),
-                   R""( textLength="{:.2f}px" lengthAdjust="spacingAndGlyphs")"",
-                   t_text->text.txtwidth_px);
+    write_all(os, " textLength=\"", t_text->txtwidth_px,
+              "px\" lengthAdjust=\"spacingAndGlyphs\"");
   }
-  fmt::format_to(std::back_inserter(os), ">");
+  write_literal(os, ">");
   write_xml_escaped(os, t_text->str);
-  fmt::format_to(std::back_inserter(os), "</text></g>");
+  write_literal(os, "</text></g>");
 }
 
 void RendererSVG::visit(const Circle* t_circle)
 {
-  fmt::format_to(std::back_inserter(os), "<circle ");
-  fmt::format_to(std::back_inserter(os), R""(cx="{:.2f}" cy="{:.2f}" r="{:.2f}" )"",
-                 t_circle->pos.x, t_circle->pos.y, t_circle->radius);
+  write_literal(os, "<circle ");
+  write_all(os, "cx=\"", t_circle->pos.x, "\" cy=\"", t_circle->pos.y, "\" r=\"",
+            t_circle->radius, "\" ");
 
-  fmt::format_to(std::back_inserter(os), "style=\"");
-  css_lineinfo(os, t_circle->line);
-  css_fill_or_omit(os, t_circle->fill);
-  fmt::format_to(std::back_inserter(os), "\"/>");
+  m_shape_style(os, t_circle->line, t_circle->fill);
+  write_literal(os, "/>");
 }
 
 void RendererSVG::visit(const Line* t_line)
 {
-  fmt::format_to(std::back_inserter(os), "<line ");
-  fmt::format_to(std::back_inserter(os),
-                 R""(x1="{:.2f}" y1="{:.2f}" x2="{:.2f}" y2="{:.2f}" )"", t_line->orig.x,
-                 t_line->orig.y, t_line->dest.x, t_line->dest.y);
+  write_literal(os, "<line ");
+  write_all(os, "x1=\"", t_line->orig.x, "\" y1=\"", t_line->orig.y, "\" x2=\"",
+            t_line->dest.x, "\" y2=\"", t_line->dest.y, "\" ");
 
-  fmt::format_to(std::back_inserter(os), "style=\"");
-  css_lineinfo(os, t_line->line);
-  fmt::format_to(std::back_inserter(os), "\"/>");
+  m_shape_style(os, t_line->line, no_fill);
+  write_literal(os, "/>");
 }
 
 void RendererSVG::visit(const Rect* t_rect)
 {
-  fmt::format_to(std::back_inserter(os), "<rect ");
-  fmt::format_to(std::back_inserter(os),
-                 R""(x="{:.2f}" y="{:.2f}" width="{:.2f}" height="{:.2f}" )"",
-                 t_rect->rect.x, t_rect->rect.y, t_rect->rect.width, t_rect->rect.height);
+  write_literal(os, "<rect ");
+  write_all(os, "x=\"", t_rect->rect.x, "\" y=\"", t_rect->rect.y, "\" width=\"",
+            t_rect->rect.width, "\" height=\"", t_rect->rect.height, "\" ");
 
-  fmt::format_to(std::back_inserter(os), "style=\"");
-  css_lineinfo(os, t_rect->line);
-  css_fill_or_omit(os, t_rect->fill);
-  fmt::format_to(std::back_inserter(os), "\"/>");
+  m_shape_style(os, t_rect->line, t_rect->fill);
+  write_literal(os, "/>");
 }
 
 void RendererSVG::visit(const Polyline* t_polyline)
 {
-  fmt::format_to(std::back_inserter(os), "<polyline points=\"");
+  write_literal(os, "<polyline points=\"");
   for (auto it = t_polyline->points.begin(); it != t_polyline->points.end(); ++it)
   {
     if (it != t_polyline->points.begin())
     {
-      fmt::format_to(std::back_inserter(os), " ");
+      write_literal(os, " ");
     }
-    fmt::format_to(std::back_inserter(os), "{:.2f},{:.2f}", it->x, it->y);
+    write_all(os, it->x, ",", it->y);
   }
-  fmt::format_to(std::back_inserter(os), "\" style=\"");
-  css_lineinfo(os, t_polyline->line);
-  fmt::format_to(std::back_inserter(os), "\"/>");
+  write_literal(os, "\" ");
+  m_shape_style(os, t_polyline->line, no_fill);
+  write_literal(os, "/>");
 }
 
 void RendererSVG::visit(const Polygon* t_polygon)
 {
-  fmt::format_to(std::back_inserter(os), "<polygon points=\"");
+  write_literal(os, "<polygon points=\"");
   for (auto it = t_polygon->points.begin(); it != t_polygon->points.end(); ++it)
   {
     if (it != t_polygon->points.begin())
     {
-      fmt::format_to(std::back_inserter(os), " ");
+      write_literal(os, " ");
     }
-    fmt::format_to(std::back_inserter(os), "{:.2f},{:.2f}", it->x, it->y);
+    write_all(os, it->x, ",", it->y);
   }
-  fmt::format_to(std::back_inserter(os), "\" ");
+  write_literal(os, "\" ");
 
-  fmt::format_to(std::back_inserter(os), "style=\"");
-  css_lineinfo(os, t_polygon->line);
-  css_fill_or_omit(os, t_polygon->fill);
-  fmt::format_to(std::back_inserter(os), "\" ");
+  m_shape_style(os, t_polygon->line, t_polygon->fill);
+  write_literal(os, " ");
 
-  fmt::format_to(std::back_inserter(os), "/>");
+  write_literal(os, "/>");
 }
 
 void RendererSVG::visit(const Path* t_path)
 {
-  fmt::format_to(std::back_inserter(os), "<path d=\"");
+  write_literal(os, "<path d=\"");
 
   auto it_poly = t_path->nper.begin();
   std::size_t left = 0;
@@ -400,27 +534,33 @@ void RendererSVG::visit(const Path* t_path)
     {
       left = (*it_poly) - 1;
       ++it_poly;
-      fmt::format_to(std::back_inserter(os), "M{:.2f} {:.2f}", it->x, it->y);
+      write_all(os, "M", it->x, " ", it->y);
     }
     else
     {
       --left;
-      fmt::format_to(std::back_inserter(os), "L{:.2f} {:.2f}", it->x, it->y);
+      write_all(os, "L", it->x, " ", it->y);
 
       if (left == 0)
       {
-        fmt::format_to(std::back_inserter(os), "Z");
+        write_literal(os, "Z");
       }
     }
   }
 
   // Finish path data
-  fmt::format_to(std::back_inserter(os), "\" style=\"");
-  css_lineinfo(os, t_path->line);
+  const auto* fill_rule = t_path->winding ? "nonzero" : "evenodd";
+  if (m_css_classes)
+  {
+    write_literal(os, "\" ");
+    m_shape_style(os, t_path->line, t_path->fill);
+    fmt::format_to(std::back_inserter(os), R""( style="fill-rule: {};"/>)"", fill_rule);
+    return;
+  }
+  write_literal(os, "\" style=\"");
+  append(os, m_lines[t_path->line]);
   css_fill_or_omit(os, t_path->fill);
-  fmt::format_to(std::back_inserter(os), "fill-rule: ");
-  fmt::format_to(std::back_inserter(os), "{}", t_path->winding ? "nonzero" : "evenodd");
-  fmt::format_to(std::back_inserter(os), ";\"/>");
+  fmt::format_to(std::back_inserter(os), "fill-rule: {};\"/>", fill_rule);
 }
 
 void RendererSVG::visit(const Raster* t_raster)
@@ -428,25 +568,86 @@ void RendererSVG::visit(const Raster* t_raster)
   // If we specify the clip path inside <image>, the "transform" also
   // affects the clip path, so we need to specify clip path at an outer level
   // (according to svglite)
-  fmt::format_to(std::back_inserter(os), "<g><image ");
-  fmt::format_to(std::back_inserter(os),
-                 R""( x="{:.2f}" y="{:.2f}" width="{:.2f}" height="{:.2f}" )"",
-                 t_raster->rect.x, t_raster->rect.y, t_raster->rect.width,
-                 t_raster->rect.height);
-  fmt::format_to(std::back_inserter(os), R""(preserveAspectRatio="none" )"");
+  write_literal(os, "<g><image ");
+  write_all(os, " x=\"", t_raster->rect.x, "\" y=\"", t_raster->rect.y, "\" width=\"",
+            t_raster->rect.width, "\" height=\"", t_raster->rect.height, "\" ");
+  write_literal(os, R""(preserveAspectRatio="none" )"");
   if (!t_raster->interpolate)
   {
-    fmt::format_to(std::back_inserter(os), R""(image-rendering="pixelated" )"");
+    write_literal(os, R""(image-rendering="pixelated" )"");
   }
   if (t_raster->rot != 0)
   {
-    fmt::format_to(std::back_inserter(os),
-                   R""(transform="rotate({:.2f},{:.2f},{:.2f})" )"", -1.0 * t_raster->rot,
-                   t_raster->rect.x, t_raster->rect.y);
+    write_all(os, "transform=\"rotate(", -1.0 * t_raster->rot, ",", t_raster->rect.x, ",",
+              t_raster->rect.y, ")\" ");
   }
-  fmt::format_to(std::back_inserter(os), " xlink:href=\"data:image/png;base64,");
+  write_literal(os, " xlink:href=\"data:image/png;base64,");
   fmt::format_to(std::back_inserter(os), "{}", raster_base64(*t_raster));
-  fmt::format_to(std::back_inserter(os), "\"/></g>");
+  write_literal(os, "\"/></g>");
+}
+
+void RendererSVG::m_shape_style(fmt::memory_buffer& t_os, style_id_t t_line,
+                                color_t t_fill) const
+{
+  if (m_css_classes)
+  {
+    write_all(t_os, "class=\"s", m_classes.at(shape_class_key(t_line, t_fill)), "\"");
+    return;
+  }
+  write_literal(t_os, "style=\"");
+  append(t_os, m_lines[t_line]);
+  css_fill_or_omit(t_os, t_fill);
+  write_literal(t_os, "\"");
+}
+
+void RendererSVG::visit(const CircleRun* t_run)
+{
+  const auto styles = format_styles(
+      t_run->styles, [&](fmt::memory_buffer& t_os, const ShapeStyle& t_style)
+      { m_shape_style(t_os, t_style.line, t_style.fill); });
+  for (std::size_t i = 0; i != t_run->size(); ++i)
+  {
+    if (i != 0)
+    {
+      write_literal(os, "\n");
+    }
+    write_all(os, "<circle cx=\"", t_run->pos[i].x, "\" cy=\"", t_run->pos[i].y,
+              "\" r=\"", t_run->radius[i], "\" ", styles[t_run->style[i]], "/>");
+  }
+}
+
+void RendererSVG::visit(const LineRun* t_run)
+{
+  const auto styles =
+      format_styles(t_run->styles, [&](fmt::memory_buffer& t_os, style_id_t t_line)
+                    { m_shape_style(t_os, t_line, no_fill); });
+  for (std::size_t i = 0; i != t_run->size(); ++i)
+  {
+    if (i != 0)
+    {
+      write_literal(os, "\n");
+    }
+    write_all(os, "<line x1=\"", t_run->orig[i].x, "\" y1=\"", t_run->orig[i].y,
+              "\" x2=\"", t_run->dest[i].x, "\" y2=\"", t_run->dest[i].y, "\" ",
+              styles[t_run->style[i]], "/>");
+  }
+}
+
+void RendererSVG::visit(const RectRun* t_run)
+{
+  const auto styles = format_styles(
+      t_run->styles, [&](fmt::memory_buffer& t_os, const ShapeStyle& t_style)
+      { m_shape_style(t_os, t_style.line, t_style.fill); });
+  for (std::size_t i = 0; i != t_run->size(); ++i)
+  {
+    if (i != 0)
+    {
+      write_literal(os, "\n");
+    }
+    const auto& rect = t_run->rect[i];
+    write_all(os, "<rect x=\"", rect.x, "\" y=\"", rect.y, "\" width=\"", rect.width,
+              "\" height=\"", rect.height, "\" ", styles[t_run->style[i]], "/>");
+  }
 }
 
 // Portable SVG renderer
@@ -456,16 +657,16 @@ static inline void att_fill_or_none(fmt::memory_buffer& os, color_t col)
   int alpha = color::alpha(col);
   if (alpha == 0)
   {
-    fmt::format_to(std::back_inserter(os), R""( fill="none")"");
+    write_literal(os, R""( fill="none")"");
   }
   else
   {
-    fmt::format_to(std::back_inserter(os), R""( fill="#{:02X}{:02X}{:02X}")"",
-                   color::red(col), color::green(col), color::blue(col));
+    write_literal(os, R""( fill="#)"");
+    write_hex_color(os, col);
+    write_literal(os, "\"");
     if (alpha != color::byte_mask)
     {
-      fmt::format_to(std::back_inserter(os), R""( fill-opacity="{:.2f}")"",
-                     color::byte_frac(alpha));
+      write_all(os, " fill-opacity=\"", color::byte_frac(alpha), "\"");
     }
   }
 }
@@ -473,19 +674,18 @@ static inline void att_fill_or_none(fmt::memory_buffer& os, color_t col)
 static inline void att_lineinfo(fmt::memory_buffer& os, const LineInfo& line)
 {
   // 1 lwd = 1/96", but units in rest of document are 1/72"
-  fmt::format_to(std::back_inserter(os), R""(stroke-width="{:.2f}")"",
-                 line.lwd / 96.0 * 72);
+  write_all(os, "stroke-width=\"", line.lwd / 96.0 * 72, "\"");
 
   // Default is "stroke: none;"
   color_t alpha = color::alpha(line.col);
   if (alpha != 0)
   {
-    fmt::format_to(std::back_inserter(os), R""( stroke="#{:02X}{:02X}{:02X}")"",
-                   color::red(line.col), color::green(line.col), color::blue(line.col));
+    write_literal(os, R""( stroke="#)"");
+    write_hex_color(os, line.col);
+    write_literal(os, "\"");
     if (alpha != color::byte_mask)
     {
-      fmt::format_to(std::back_inserter(os), R""( stroke-opacity="{:.2f}")"",
-                     color::byte_frac(alpha));
+      write_all(os, " stroke-opacity=\"", color::byte_frac(alpha), "\"");
     }
   }
 
@@ -499,16 +699,15 @@ static inline void att_lineinfo(fmt::memory_buffer& os, const LineInfo& line)
     default:
       // For details
       // https://github.com/wch/r-source/blob/trunk/src/include/R_ext/GraphicsEngine.h#L337
-      fmt::format_to(std::back_inserter(os), R""( stroke-dasharray="{:.2f})"",
-                     scale_lty(lty, line.lwd));
+      write_all(os, " stroke-dasharray=\"", scale_lty(lty, line.lwd));
       lty = lty >> 4;
       // Remaining numbers
       for (int i = 1; i < 8 && lty & 15; i++)
       {
-        fmt::format_to(std::back_inserter(os), ", {:.2f}", scale_lty(lty, line.lwd));
+        write_all(os, ", ", scale_lty(lty, line.lwd));
         lty = lty >> 4;
       }
-      fmt::format_to(std::back_inserter(os), "\"");
+      write_literal(os, "\"");
       break;
   }
 
@@ -516,13 +715,13 @@ static inline void att_lineinfo(fmt::memory_buffer& os, const LineInfo& line)
   switch (line.lend)
   {
     case LineInfo::GC_ROUND_CAP:
-      fmt::format_to(std::back_inserter(os), R""( stroke-linecap="round")"");
+      write_literal(os, R""( stroke-linecap="round")"");
       break;
     case LineInfo::GC_BUTT_CAP:
       // SVG default
       break;
     case LineInfo::GC_SQUARE_CAP:
-      fmt::format_to(std::back_inserter(os), R""( stroke-linecap="square")"");
+      write_literal(os, R""( stroke-linecap="square")"");
       break;
     default:
       break;
@@ -532,17 +731,16 @@ static inline void att_lineinfo(fmt::memory_buffer& os, const LineInfo& line)
   switch (line.ljoin)
   {
     case LineInfo::GC_ROUND_JOIN:
-      fmt::format_to(std::back_inserter(os), R""( stroke-linejoin="round")"");
+      write_literal(os, R""( stroke-linejoin="round")"");
       break;
     case LineInfo::GC_BEVEL_JOIN:
-      fmt::format_to(std::back_inserter(os), R""( stroke-linejoin="bevel")"");
+      write_literal(os, R""( stroke-linejoin="bevel")"");
       break;
     case LineInfo::GC_MITRE_JOIN:
       // default
       if (std::fabs(line.lmitre - 4.0) > 1e-3)
       {  // 4 is the SVG default
-        fmt::format_to(std::back_inserter(os), R""( stroke-miterlimit="{:.2f}")"",
-                       line.lmitre);
+        write_all(os, " stroke-miterlimit=\"", line.lmitre, "\"");
       }
       break;
     default:
@@ -565,17 +763,24 @@ void RendererSVGPortable::get_data(const uint8_t** t_buf, size_t* t_size) const
   *t_size = os.size();
 }
 
+bool RendererSVGPortable::stream(const Page& t_page, double t_scale,
+                                 const chunk_fn& t_chunk)
+{
+  return m_stream.run(os, t_chunk, [&]() { render(t_page, t_scale); });
+}
+
 void RendererSVGPortable::page(const Page& t_page)
 {
-  os.reserve((t_page.dcs.size() + t_page.cps.size()) * 128 + 512);
+  m_styles = &t_page.styles;
+  m_lines = format_styles(t_page.styles.lines(), att_lineinfo);
+  os.reserve(m_stream.active() ? stream_chunk_size
+                     : (t_page.draw_call_count() + t_page.cps.size()) * 128 + 512);
   fmt::format_to(
       std::back_inserter(os),
       R""(<svg xmlns="http://www.w3.org/2000/svg" xmlns:xlink="http://www.w3.org/1999/xlink" class="httpgd" )"");
-  fmt::format_to(std::back_inserter(os),
-                 R""(width="{:.2f}" height="{:.2f}" viewBox="0 0 {:.2f} {:.2f}">)""
-                 "\n<defs>\n",
-                 t_page.size.x * m_scale, t_page.size.y * m_scale, t_page.size.x,
-                 t_page.size.y);
+  write_all(os, "width=\"", t_page.size.x * m_scale, "\" height=\"",
+            t_page.size.y * m_scale, "\" viewBox=\"0 0 ", t_page.size.x, " ",
+            t_page.size.y, "\">\n<defs>\n");
 
   for (const auto& cp : t_page.cps)
   {
@@ -585,7 +790,7 @@ void RendererSVGPortable::page(const Page& t_page)
         "\n",
         cp.id, m_unique_id, cp.rect.x, cp.rect.y, cp.rect.width, cp.rect.height);
   }
-  fmt::format_to(std::back_inserter(os), "</defs>\n");
+  write_literal(os, "</defs>\n");
   fmt::format_to(
       std::back_inserter(os),
       R""(<rect width="100%" height="100%" stroke="none" fill="#{:02X}{:02X}{:02X}"/>)""
@@ -608,21 +813,24 @@ void RendererSVGPortable::page(const Page& t_page)
       last_id = dc->clip_id;
     }
     dc->visit(this);
-    fmt::format_to(std::back_inserter(os), "\n");
+    write_literal(os, "\n");
+    if (!m_stream.flush_chunk(os))
+    {
+      return;
+    }
   }
-  fmt::format_to(std::back_inserter(os), "</g>\n</svg>");
+  write_literal(os, "</g>\n</svg>");
 }
 
 void RendererSVGPortable::visit(const Rect* t_rect)
 {
-  fmt::format_to(std::back_inserter(os), "<rect ");
-  fmt::format_to(std::back_inserter(os),
-                 R""(x="{:.2f}" y="{:.2f}" width="{:.2f}" height="{:.2f}" )"",
-                 t_rect->rect.x, t_rect->rect.y, t_rect->rect.width, t_rect->rect.height);
+  write_literal(os, "<rect ");
+  write_all(os, "x=\"", t_rect->rect.x, "\" y=\"", t_rect->rect.y, "\" width=\"",
+            t_rect->rect.width, "\" height=\"", t_rect->rect.height, "\" ");
 
-  att_lineinfo(os, t_rect->line);
+  append(os, m_lines[t_rect->line]);
   att_fill_or_none(os, t_rect->fill);
-  fmt::format_to(std::back_inserter(os), "/>");
+  write_literal(os, "/>");
 }
 
 void RendererSVGPortable::visit(const Text* t_text)
@@ -630,126 +838,123 @@ void RendererSVGPortable::visit(const Text* t_text)
   // If we specify the clip path inside <image>, the "transform" also
   // affects the clip path, so we need to specify clip path at an outer level
   // (according to svglite)
-  fmt::format_to(std::back_inserter(os), "<g><text ");
+  write_literal(os, "<g><text ");
 
   if (t_text->rot == 0.0)
   {
-    fmt::format_to(std::back_inserter(os), R""(x="{:.2f}" y="{:.2f}" )"", t_text->pos.x,
-                   t_text->pos.y);
+    write_all(os, "x=\"", t_text->pos.x, "\" y=\"", t_text->pos.y, "\" ");
   }
   else
   {
-    fmt::format_to(std::back_inserter(os),
-                   R""(transform="translate({:.2f},{:.2f}) rotate({:.2f})" )"",
-                   t_text->pos.x, t_text->pos.y, t_text->rot * -1.0);
+    write_all(os, "transform=\"translate(", t_text->pos.x, ",", t_text->pos.y,
+              ") rotate(", t_text->rot * -1.0, ")\" ");
   }
 
   if (t_text->hadj == 0.5)
   {
-    fmt::format_to(std::back_inserter(os), R""(text-anchor="middle" )"");
+    write_literal(os, R""(text-anchor="middle" )"");
   }
   else if (t_text->hadj == 1)
   {
-    fmt::format_to(std::back_inserter(os), R""(text-anchor="end" )"");
+    write_literal(os, R""(text-anchor="end" )"");
   }
 
+  const auto& text = m_styles->text(t_text->text);
   fmt::format_to(std::back_inserter(os), R""(font-family="{}" font-size="{:.2f}px")"",
-                 t_text->text.font_family, t_text->text.fontsize);
+                 text.font_family, text.fontsize);
 
-  if (t_text->text.weight != 400)
+  if (text.weight != 400)
   {
-    if (t_text->text.weight == 700)
+    if (text.weight == 700)
     {
-      fmt::format_to(std::back_inserter(os), R""( font-weight="bold")"");
+      write_literal(os, R""( font-weight="bold")"");
     }
     else
     {
       fmt::format_to(std::back_inserter(os), R""( font-weight="{}")"",
-                     t_text->text.weight);
+                     text.weight);
     }
   }
-  if (t_text->text.italic)
+  if (text.italic)
   {
-    fmt::format_to(std::back_inserter(os), R""( font-style="italic")"");
+    write_literal(os, R""( font-style="italic")"");
   }
   if (t_text->col != color::rgb(0, 0, 0))
   {
     att_fill_or_none(os, t_text->col);
   }
-  if (t_text->text.features.length() > 0)
+  if (text.features.length() > 0)
   {
     fmt::format_to(std::back_inserter(os), R""( font-feature-settings="{}")"",
-                   t_text->text.features);
+                   text.features);
   }
-  if (t_text->text.txtwidth_px > 0)
+  if (t_text->txtwidth_px > 0)
   {
-    fmt::format_to(std::back_inserter(os),
-                   R""( textLength="{:.2f}px" lengthAdjust="spacingAndGlyphs")"",
-                   t_text->text.txtwidth_px);
+    write_all(os, " textLength=\"", t_text->txtwidth_px,
+              "px\" lengthAdjust=\"spacingAndGlyphs\"");
   }
-  fmt::format_to(std::back_inserter(os), ">");
+  write_literal(os, ">");
   write_xml_escaped(os, t_text->str);
-  fmt::format_to(std::back_inserter(os), "</text></g>");
+  write_literal(os, "</text></g>");
 }
 
 void RendererSVGPortable::visit(const Circle* t_circle)
 {
-  fmt::format_to(std::back_inserter(os), "<circle ");
-  fmt::format_to(std::back_inserter(os), R""(cx="{:.2f}" cy="{:.2f}" r="{:.2f}" )"",
-                 t_circle->pos.x, t_circle->pos.y, t_circle->radius);
+  write_literal(os, "<circle ");
+  write_all(os, "cx=\"", t_circle->pos.x, "\" cy=\"", t_circle->pos.y, "\" r=\"",
+            t_circle->radius, "\" ");
 
-  att_lineinfo(os, t_circle->line);
+  append(os, m_lines[t_circle->line]);
   att_fill_or_none(os, t_circle->fill);
-  fmt::format_to(std::back_inserter(os), "/>");
+  write_literal(os, "/>");
 }
 
 void RendererSVGPortable::visit(const Line* t_line)
 {
-  fmt::format_to(std::back_inserter(os), "<line ");
-  fmt::format_to(std::back_inserter(os),
-                 R""(x1="{:.2f}" y1="{:.2f}" x2="{:.2f}" y2="{:.2f}" )"", t_line->orig.x,
-                 t_line->orig.y, t_line->dest.x, t_line->dest.y);
+  write_literal(os, "<line ");
+  write_all(os, "x1=\"", t_line->orig.x, "\" y1=\"", t_line->orig.y, "\" x2=\"",
+            t_line->dest.x, "\" y2=\"", t_line->dest.y, "\" ");
 
-  att_lineinfo(os, t_line->line);
-  fmt::format_to(std::back_inserter(os), "/>");
+  append(os, m_lines[t_line->line]);
+  write_literal(os, "/>");
 }
 
 void RendererSVGPortable::visit(const Polyline* t_polyline)
 {
-  fmt::format_to(std::back_inserter(os), "<polyline points=\"");
+  write_literal(os, "<polyline points=\"");
   for (auto it = t_polyline->points.begin(); it != t_polyline->points.end(); ++it)
   {
     if (it != t_polyline->points.begin())
     {
-      fmt::format_to(std::back_inserter(os), " ");
+      write_literal(os, " ");
     }
-    fmt::format_to(std::back_inserter(os), "{:.2f},{:.2f}", it->x, it->y);
+    write_all(os, it->x, ",", it->y);
   }
-  fmt::format_to(std::back_inserter(os), "\" fill=\"none\" ");
-  att_lineinfo(os, t_polyline->line);
-  fmt::format_to(std::back_inserter(os), "/>");
+  write_literal(os, "\" fill=\"none\" ");
+  append(os, m_lines[t_polyline->line]);
+  write_literal(os, "/>");
 }
 
 void RendererSVGPortable::visit(const Polygon* t_polygon)
 {
-  fmt::format_to(std::back_inserter(os), "<polygon points=\"");
+  write_literal(os, "<polygon points=\"");
   for (auto it = t_polygon->points.begin(); it != t_polygon->points.end(); ++it)
   {
     if (it != t_polygon->points.begin())
     {
-      fmt::format_to(std::back_inserter(os), " ");
+      write_literal(os, " ");
     }
-    fmt::format_to(std::back_inserter(os), "{:.2f},{:.2f}", it->x, it->y);
+    write_all(os, it->x, ",", it->y);
   }
-  fmt::format_to(std::back_inserter(os), "\" ");
-  att_lineinfo(os, t_polygon->line);
+  write_literal(os, "\" ");
+  append(os, m_lines[t_polygon->line]);
   att_fill_or_none(os, t_polygon->fill);
-  fmt::format_to(std::back_inserter(os), "/>");
+  write_literal(os, "/>");
 }
 
 void RendererSVGPortable::visit(const Path* t_path)
 {
-  fmt::format_to(std::back_inserter(os), "<path d=\"");
+  write_literal(os, "<path d=\"");
 
   auto it_poly = t_path->nper.begin();
   std::size_t left = 0;
@@ -759,27 +964,34 @@ void RendererSVGPortable::visit(const Path* t_path)
     {
       left = (*it_poly) - 1;
       ++it_poly;
-      fmt::format_to(std::back_inserter(os), "M{:.2f} {:.2f}", it->x, it->y);
+      write_all(os, "M", it->x, " ", it->y);
     }
     else
     {
       --left;
-      fmt::format_to(std::back_inserter(os), "L{:.2f} {:.2f}", it->x, it->y);
+      write_all(os, "L", it->x, " ", it->y);
 
       if (left == 0)
       {
-        fmt::format_to(std::back_inserter(os), "Z");
+        write_literal(os, "Z");
       }
     }
   }
 
   // Finish path data
-  fmt::format_to(std::back_inserter(os), "\" ");
-  att_lineinfo(os, t_path->line);
+  write_literal(os, "\" ");
+  append(os, m_lines[t_path->line]);
   att_fill_or_none(os, t_path->fill);
-  fmt::format_to(std::back_inserter(os), " fill-rule=\"");
-  fmt::format_to(std::back_inserter(os), "{}", t_path->winding ? "nonzero" : "evenodd");
-  fmt::format_to(std::back_inserter(os), "\"/>");
+  write_literal(os, " fill-rule=\"");
+  if (t_path->winding)
+  {
+    write_literal(os, "nonzero");
+  }
+  else
+  {
+    write_literal(os, "evenodd");
+  }
+  write_literal(os, "\"/>");
 }
 
 void RendererSVGPortable::visit(const Raster* t_raster)
@@ -787,25 +999,75 @@ void RendererSVGPortable::visit(const Raster* t_raster)
   // If we specify the clip path inside <image>, the "transform" also
   // affects the clip path, so we need to specify clip path at an outer level
   // (according to svglite)
-  fmt::format_to(std::back_inserter(os), "<g><image ");
-  fmt::format_to(std::back_inserter(os),
-                 R""( x="{:.2f}" y="{:.2f}" width="{:.2f}" height="{:.2f}" )"",
-                 t_raster->rect.x, t_raster->rect.y, t_raster->rect.width,
-                 t_raster->rect.height);
-  fmt::format_to(std::back_inserter(os), R""(preserveAspectRatio="none" )"");
+  write_literal(os, "<g><image ");
+  write_all(os, " x=\"", t_raster->rect.x, "\" y=\"", t_raster->rect.y, "\" width=\"",
+            t_raster->rect.width, "\" height=\"", t_raster->rect.height, "\" ");
+  write_literal(os, R""(preserveAspectRatio="none" )"");
   if (!t_raster->interpolate)
   {
-    fmt::format_to(std::back_inserter(os), R""(image-rendering="pixelated" )"");
+    write_literal(os, R""(image-rendering="pixelated" )"");
   }
   if (t_raster->rot != 0)
   {
-    fmt::format_to(std::back_inserter(os),
-                   R""(transform="rotate({:.2f},{:.2f},{:.2f})" )"", -1.0 * t_raster->rot,
-                   t_raster->rect.x, t_raster->rect.y);
+    write_all(os, "transform=\"rotate(", -1.0 * t_raster->rot, ",", t_raster->rect.x, ",",
+              t_raster->rect.y, ")\" ");
   }
-  fmt::format_to(std::back_inserter(os), " xlink:href=\"data:image/png;base64,");
+  write_literal(os, " xlink:href=\"data:image/png;base64,");
   fmt::format_to(std::back_inserter(os), "{}", raster_base64(*t_raster));
-  fmt::format_to(std::back_inserter(os), "\"/></g>");
+  write_literal(os, "\"/></g>");
+}
+
+void RendererSVGPortable::visit(const CircleRun* t_run)
+{
+  const auto styles = format_styles(
+      t_run->styles, [&](fmt::memory_buffer& t_os, const ShapeStyle& t_style)
+      {
+        append(t_os, m_lines[t_style.line]);
+        att_fill_or_none(t_os, t_style.fill);
+      });
+  for (std::size_t i = 0; i != t_run->size(); ++i)
+  {
+    if (i != 0)
+    {
+      write_literal(os, "\n");
+    }
+    write_all(os, "<circle cx=\"", t_run->pos[i].x, "\" cy=\"", t_run->pos[i].y,
+              "\" r=\"", t_run->radius[i], "\" ", styles[t_run->style[i]], "/>");
+  }
+}
+
+void RendererSVGPortable::visit(const LineRun* t_run)
+{
+  for (std::size_t i = 0; i != t_run->size(); ++i)
+  {
+    if (i != 0)
+    {
+      write_literal(os, "\n");
+    }
+    write_all(os, "<line x1=\"", t_run->orig[i].x, "\" y1=\"", t_run->orig[i].y,
+              "\" x2=\"", t_run->dest[i].x, "\" y2=\"", t_run->dest[i].y, "\" ",
+              m_lines[t_run->styles[t_run->style[i]]], "/>");
+  }
+}
+
+void RendererSVGPortable::visit(const RectRun* t_run)
+{
+  const auto styles = format_styles(
+      t_run->styles, [&](fmt::memory_buffer& t_os, const ShapeStyle& t_style)
+      {
+        append(t_os, m_lines[t_style.line]);
+        att_fill_or_none(t_os, t_style.fill);
+      });
+  for (std::size_t i = 0; i != t_run->size(); ++i)
+  {
+    if (i != 0)
+    {
+      write_literal(os, "\n");
+    }
+    const auto& rect = t_run->rect[i];
+    write_all(os, "<rect x=\"", rect.x, "\" y=\"", rect.y, "\" width=\"", rect.width,
+              "\" height=\"", rect.height, "\" ", styles[t_run->style[i]], "/>");
+  }
 }
 
 RendererSVGZ::RendererSVGZ(std::experimental::optional<std::string> t_extra_css)
@@ -821,7 +1083,8 @@ void RendererSVGZ::render(const Page& t_page, double t_scale)
   size_t buf_size;
   RendererSVG::get_data(&buf, &buf_size);
 
-  m_compressed = compr::compress(buf, buf_size);
+  m_compressed.clear();
+  compr::compress(buf, buf_size, &m_compressed);
 }
 
 void RendererSVGZ::get_data(const uint8_t** t_buf, size_t* t_size) const
@@ -840,7 +1103,8 @@ void RendererSVGZPortable::render(const Page& t_page, double t_scale)
   size_t buf_size;
   RendererSVGPortable::get_data(&buf, &buf_size);
 
-  m_compressed = compr::compress(buf, buf_size);
+  m_compressed.clear();
+  compr::compress(buf, buf_size, &m_compressed);
 }
 
 void RendererSVGZPortable::get_data(const uint8_t** t_buf, size_t* t_size) const
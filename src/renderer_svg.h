@@ -2,22 +2,68 @@
 #define __UNIGD_RENDERER_SVG_H__
 
 #include <compat/optional.hpp>
+#include <cstdint>
 #include <string>
+#include <unordered_map>
+#include <vector>
 
 #include <fmt/format.h>
 
+#include "byte_sink.h"
 #include "renderers.h"
 
 namespace unigd
 {
 namespace renderers
 {
+// Streaming state of the SVG renderers: while a document is streamed, the part written
+// so far is handed out between draw calls whenever it has reached a chunk.
+class svg_stream
+{
+ public:
+  // Calls t_render, which writes the document to t_os. Returns false if t_chunk stopped
+  // the output.
+  template <class F>
+  bool run(fmt::memory_buffer& t_os, const chunk_fn& t_chunk, F t_render)
+  {
+    m_chunk = &t_chunk;
+    m_stopped = false;
+    t_render();
+    if (!m_stopped)
+    {
+      m_flush(t_os);
+    }
+    m_chunk = nullptr;
+    return !m_stopped;
+  }
+
+  bool active() const { return m_chunk != nullptr; }
+  // Hands out t_os when streaming and it holds a complete chunk. Returns false if the
+  // render has to stop.
+  bool flush_chunk(fmt::memory_buffer& t_os)
+  {
+    return !m_chunk || t_os.size() < stream_chunk_size || m_flush(t_os);
+  }
+
+ private:
+  const chunk_fn* m_chunk = nullptr;
+  bool m_stopped = false;
+
+  bool m_flush(fmt::memory_buffer& t_os);
+};
+
 class RendererSVG : public render_target, public draw_call_visitor
 {
  public:
-  explicit RendererSVG(std::experimental::optional<std::string> t_extra_css);
+  // With t_css_classes, every distinct style is written once as a CSS class in the
+  // <style> block and elements only reference their class. The rules are scoped to the
+  // document by a random id of its root element.
+  explicit RendererSVG(std::experimental::optional<std::string> t_extra_css,
+                       bool t_css_classes = false);
   void render(const Page& t_page, double t_scale) override;
   void get_data(const uint8_t** t_buf, size_t* t_size) const override;
+  // Hands out the document whenever a chunk is complete while it is written.
+  bool stream(const Page& t_page, double t_scale, const chunk_fn& t_chunk) override;
 
   // Renderer
   void page(const Page& t_page);
@@ -29,11 +75,26 @@ class RendererSVG : public render_target, public draw_call_visitor
   void visit(const Polygon* t_polygon) override;
   void visit(const Path* t_path) override;
   void visit(const Raster* t_raster) override;
+  void visit(const CircleRun* t_run) override;
+  void visit(const LineRun* t_run) override;
+  void visit(const RectRun* t_run) override;
 
  private:
   fmt::memory_buffer os;
   std::experimental::optional<std::string> m_extra_css;
   double m_scale;
+  bool m_css_classes;
+  // Scopes the class rules of a document (with CSS classes only)
+  std::string m_unique_id;
+  const style_table* m_styles = nullptr;
+  // Formatted line styles of the page
+  std::vector<std::string> m_lines;
+  // Class number of every (line style, fill) pair of the page
+  std::unordered_map<uint64_t, std::size_t> m_classes;
+  svg_stream m_stream;
+
+  // Writes the style attribute (or the class reference) of a shape.
+  void m_shape_style(fmt::memory_buffer& t_os, style_id_t t_line, color_t t_fill) const;
 };
 
 /**
@@ -48,6 +109,8 @@ class RendererSVGPortable : public render_target, public draw_call_visitor
   RendererSVGPortable();
   void render(const Page& t_page, double t_scale) override;
   void get_data(const uint8_t** t_buf, size_t* t_size) const override;
+  // Hands out the document whenever a chunk is complete while it is written.
+  bool stream(const Page& t_page, double t_scale, const chunk_fn& t_chunk) override;
 
   // Renderer
   void page(const Page& t_page);
@@ -59,11 +122,18 @@ class RendererSVGPortable : public render_target, public draw_call_visitor
   void visit(const Polygon* t_polygon) override;
   void visit(const Path* t_path) override;
   void visit(const Raster* t_raster) override;
+  void visit(const CircleRun* t_run) override;
+  void visit(const LineRun* t_run) override;
+  void visit(const RectRun* t_run) override;
 
  private:
   fmt::memory_buffer os;
   double m_scale;
   std::string m_unique_id;
+  const style_table* m_styles = nullptr;
+  // Formatted line styles of the page
+  std::vector<std::string> m_lines;
+  svg_stream m_stream;
 };
 
 class RendererSVGZ : public RendererSVG
@@ -72,9 +142,14 @@ class RendererSVGZ : public RendererSVG
   explicit RendererSVGZ(std::experimental::optional<std::string> t_extra_css);
   void render(const Page& t_page, double t_scale) override;
   void get_data(const uint8_t** t_buf, size_t* t_size) const override;
+  // Compressed output is only streamed once it is finished.
+  bool stream(const Page& t_page, double t_scale, const chunk_fn& t_chunk) override
+  {
+    return render_target::stream(t_page, t_scale, t_chunk);
+  }
 
  private:
-  std::vector<unsigned char> m_compressed;
+  byte_sink m_compressed;
 };
 
 class RendererSVGZPortable : public RendererSVGPortable
@@ -83,9 +158,14 @@ class RendererSVGZPortable : public RendererSVGPortable
   RendererSVGZPortable();
   void render(const Page& t_page, double t_scale) override;
   void get_data(const uint8_t** t_buf, size_t* t_size) const override;
+  // Compressed output is only streamed once it is finished.
+  bool stream(const Page& t_page, double t_scale, const chunk_fn& t_chunk) override
+  {
+    return render_target::stream(t_page, t_scale, t_chunk);
+  }
 
  private:
-  std::vector<unsigned char> m_compressed;
+  byte_sink m_compressed;
 };
 
 }  // namespace renderers
@@ -25,10 +25,12 @@ class RendererTikZ : public render_target, public draw_call_visitor
   void visit(const Polygon* t_polygon) override;
   void visit(const Path* t_path) override;
   void visit(const Raster* t_raster) override;
+  void run_separator() override;
 
  private:
   fmt::memory_buffer os;
   double m_scale;
+  const style_table* m_styles = nullptr;
 };
 
 }  // namespace renderers
@@ -1,6 +1,8 @@
 
 #include "renderers.h"
 
+#include <algorithm>
+
 #include "renderer_cairo.h"
 #include "renderer_json.h"
 #include "renderer_meta.h"
@@ -19,6 +21,15 @@ static std::unordered_map<std::string, renderer_map_entry> renderer_map = {
        true},
       []()
       { return std::make_unique<renderers::RendererSVG>(std::experimental::nullopt); }}},
+    {"svgc",
+     {{"svgc", "image/svg+xml", ".svg", "SVG (CSS classes)", "plot",
+       "Version of the SVG renderer that writes shared styles once as CSS classes.",
+       true},
+      []()
+      {
+        return std::make_unique<renderers::RendererSVG>(std::experimental::nullopt,
+                                                        true);
+      }}},
     {"svgp",
      {{"svgp", "image/svg+xml", ".svg", "Portable SVG", "plot",
        "Version of the SVG renderer that produces portable SVGs.", true},
@@ -85,6 +96,27 @@ static std::unordered_map<std::string, renderer_map_entry> renderer_map = {
 #endif /* UNIGD_NO_CAIRO */
 };
 
+bool render_target::stream(const Page& t_page, double t_scale, const chunk_fn& t_chunk)
+{
+  render(t_page, t_scale);
+  const uint8_t* buf;
+  size_t size;
+  get_data(&buf, &size);
+  return stream_buffer(buf, size, t_chunk);
+}
+
+bool stream_buffer(const uint8_t* t_buf, std::size_t t_size, const chunk_fn& t_chunk)
+{
+  for (std::size_t pos = 0; pos < t_size; pos += stream_chunk_size)
+  {
+    if (!t_chunk(t_buf + pos, std::min(stream_chunk_size, t_size - pos)))
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
 bool find(const std::string& id, renderer_map_entry* renderer)
 {
   const auto it = renderer_map.find(id);
@@ -6,6 +6,7 @@
 #include <string>
 #include <unordered_map>
 
+#include "byte_sink.h"
 #include "draw_data.h"
 #include "unigd_external.h"
 
@@ -20,6 +21,48 @@ class render_target : public ex::render_data
 {
  public:
   virtual void render(const Page& t_page, double t_scale) = 0;
+  // Number of threads a single render may use for rasterizing. Renderers that do not
+  // rasterize ignore it.
+  virtual void raster_threads(unsigned t_threads) {}
+  // Renders the page and hands the output to t_chunk in pieces of at most
+  // stream_chunk_size bytes. Renderers that can write their output progressively
+  // override this to hand it out while it is written (SVG between draw calls), the
+  // others render and split up the finished buffer. Returns false if t_chunk stopped
+  // the output.
+  virtual bool stream(const Page& t_page, double t_scale, const chunk_fn& t_chunk);
+};
+
+constexpr std::size_t stream_chunk_size = 65536;
+
+// Hands t_size bytes to t_chunk in pieces of at most stream_chunk_size bytes.
+bool stream_buffer(const uint8_t* t_buf, std::size_t t_size, const chunk_fn& t_chunk);
+
+// Render target that streams the output of another target (see render_target::stream())
+// instead of keeping it. Has no data of its own.
+class stream_target : public render_target
+{
+ public:
+  stream_target(render_target* t_target, const chunk_fn* t_chunk)
+      : m_target(t_target), m_chunk(t_chunk)
+  {
+  }
+
+  void render(const Page& t_page, double t_scale) override
+  {
+    m_complete = m_target->stream(t_page, t_scale, *m_chunk);
+  }
+  void get_data(const uint8_t** t_buf, size_t* t_size) const override
+  {
+    *t_buf = nullptr;
+    *t_size = 0;
+  }
+  // False if the chunk function stopped the output.
+  bool complete() const { return m_complete; }
+
+ private:
+  render_target* m_target;
+  const chunk_fn* m_chunk;
+  bool m_complete = false;
 };
 
 using renderer_gen = std::function<std::unique_ptr<render_target>()>;
@@ -0,0 +1,182 @@
+#ifndef __UNIGD_SLOT_LIST_H__
+#define __UNIGD_SLOT_LIST_H__
+
+#include <compat/optional.hpp>
+#include <cstddef>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace unigd
+{
+// Ordered sequence of uniquely keyed values with cheap removal.
+//
+// Values never move when other values are removed: removal only leaves an empty slot
+// behind. A Fenwick tree over the occupied slots maps between sequence indices and
+// slots in O(log n), and a hash map finds values by key. Empty slots are compacted
+// away once they outnumber the occupied ones, which keeps removal amortized
+// O(log n).
+template <class K, class T>
+class slot_list
+{
+ public:
+  std::size_t size() const { return m_size; }
+  bool empty() const { return m_size == 0; }
+
+  void push_back(const K& t_key, T t_value)
+  {
+    m_slots.push_back({t_key, std::move(t_value), true});
+    m_key_to_slot[t_key] = m_slots.size() - 1;
+
+    // The new tree node covers the slots (i - lowbit(i), i].
+    const std::size_t i = m_slots.size();
+    m_tree.push_back(1 + m_prefix(i - 1) - m_prefix(i - m_lowbit(i)));
+    m_size++;
+  }
+
+  bool contains(const K& t_key) const
+  {
+    return m_key_to_slot.find(t_key) != m_key_to_slot.end();
+  }
+
+  // Sequence index of the value with the given key.
+  std::experimental::optional<std::size_t> find(const K& t_key) const
+  {
+    const auto it = m_key_to_slot.find(t_key);
+    if (it == m_key_to_slot.end())
+    {
+      return std::experimental::nullopt;
+    }
+    return m_prefix(it->second);
+  }
+
+  T& operator[](std::size_t t_index) { return m_slots[m_select(t_index)].value; }
+  const T& operator[](std::size_t t_index) const
+  {
+    return m_slots[m_select(t_index)].value;
+  }
+
+  const K& key(std::size_t t_index) const { return m_slots[m_select(t_index)].key; }
+
+  // Calls f(value) for all values in sequence order.
+  template <class F>
+  void for_each(F&& f) const
+  {
+    for (const auto& s : m_slots)
+    {
+      if (s.used)
+      {
+        f(s.value);
+      }
+    }
+  }
+
+  void erase(std::size_t t_index)
+  {
+    const std::size_t slot = m_select(t_index);
+    m_key_to_slot.erase(m_slots[slot].key);
+    m_slots[slot].value = T{};
+    m_slots[slot].used = false;
+    for (std::size_t i = slot + 1; i <= m_slots.size(); i += m_lowbit(i))
+    {
+      m_tree[i]--;
+    }
+    m_size--;
+
+    if (m_slots.size() - m_size > m_size && m_slots.size() > compact_threshold)
+    {
+      m_compact();
+    }
+  }
+
+  void clear()
+  {
+    m_slots.clear();
+    m_tree.assign(1, 0);
+    m_key_to_slot.clear();
+    m_size = 0;
+  }
+
+ private:
+  struct slot
+  {
+    K key;
+    T value;
+    bool used;
+  };
+
+  static constexpr std::size_t compact_threshold = 32;
+
+  std::vector<slot> m_slots{};
+  std::vector<std::size_t> m_tree = std::vector<std::size_t>(1, 0);  // 1-based
+  std::unordered_map<K, std::size_t> m_key_to_slot{};
+  std::size_t m_size = 0;
+
+  static std::size_t m_lowbit(std::size_t i) { return i & (~i + 1); }
+
+  // Number of occupied slots in [0, t_slots)
+  std::size_t m_prefix(std::size_t t_slots) const
+  {
+    std::size_t sum = 0;
+    for (std::size_t i = t_slots; i > 0; i -= m_lowbit(i))
+    {
+      sum += m_tree[i];
+    }
+    return sum;
+  }
+
+  // Slot of the value with the given sequence index
+  std::size_t m_select(std::size_t t_index) const
+  {
+    const std::size_t n = m_slots.size();
+    std::size_t step = 1;
+    while (step * 2 <= n)
+    {
+      step *= 2;
+    }
+    std::size_t pos = 0;
+    std::size_t rem = t_index + 1;
+    for (; step > 0; step /= 2)
+    {
+      if (pos + step <= n && m_tree[pos + step] < rem)
+      {
+        pos += step;
+        rem -= m_tree[pos];
+      }
+    }
+    return pos;
+  }
+
+  void m_compact()
+  {
+    std::vector<slot> slots;
+    slots.reserve(m_size);
+    for (auto& s : m_slots)
+    {
+      if (s.used)
+      {
+        slots.push_back(std::move(s));
+      }
+    }
+    m_slots = std::move(slots);
+
+    m_tree.assign(m_slots.size() + 1, 0);
+    for (std::size_t i = 1; i <= m_slots.size(); i++)
+    {
+      m_tree[i] += 1;
+      const std::size_t parent = i + m_lowbit(i);
+      if (parent <= m_slots.size())
+      {
+        m_tree[parent] += m_tree[i];
+      }
+    }
+    for (std::size_t i = 0; i != m_slots.size(); i++)
+    {
+      m_key_to_slot[m_slots[i].key] = i;
+    }
+  }
+};
+
+}  // namespace unigd
+
+#endif /* __UNIGD_SLOT_LIST_H__ */
@@ -0,0 +1,111 @@
+#include "state_notifier.h"
+
+namespace unigd
+{
+state_notifier::state_notifier(std::chrono::milliseconds t_window) : m_window(t_window)
+{
+  if (m_window.count() > 0)
+  {
+    m_thread = std::thread(&state_notifier::m_run, this);
+  }
+}
+
+state_notifier::~state_notifier()
+{
+  if (m_thread.joinable())
+  {
+    {
+      const std::lock_guard<std::mutex> lock(m_mutex);
+      m_stop = true;
+    }
+    m_cv.notify_one();
+    m_thread.join();
+  }
+}
+
+void state_notifier::attach(ex::graphics_client* t_client, void* t_client_data)
+{
+  const std::lock_guard<std::mutex> lock(m_client_mutex);
+  m_client = t_client;
+  m_client_data = t_client_data;
+}
+
+void state_notifier::detach()
+{
+  std::unique_lock<std::mutex> lock(m_mutex);
+  const bool pending = m_pending;
+  m_pending = false;
+  const std::lock_guard<std::mutex> client_lock(m_client_mutex);
+  lock.unlock();
+  if (pending)
+  {
+    m_call_client();
+  }
+  m_client = nullptr;
+  m_client_data = nullptr;
+}
+
+void state_notifier::notify()
+{
+  m_requested++;
+  if (!m_thread.joinable())
+  {
+    m_deliver();
+    return;
+  }
+  {
+    const std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_pending)
+    {
+      m_suppressed++;
+      return;
+    }
+    m_pending = true;
+  }
+  m_cv.notify_one();
+}
+
+state_notifier_stats state_notifier::stats() const
+{
+  return {m_requested.load(), m_delivered.load(), m_suppressed.load()};
+}
+
+void state_notifier::m_run()
+{
+  std::unique_lock<std::mutex> lock(m_mutex);
+  while (true)
+  {
+    m_cv.wait(lock, [&] { return m_pending || m_stop; });
+    if (!m_pending)
+    {
+      return;
+    }
+    m_pending = false;
+    {
+      // Taken before m_mutex is released, so detach() waits for this notification.
+      const std::lock_guard<std::mutex> client_lock(m_client_mutex);
+      lock.unlock();
+      m_call_client();
+    }
+    lock.lock();
+    // State changes until the end of the window are merged into the next notification.
+    m_cv.wait_for(lock, m_window, [&] { return m_stop; });
+  }
+}
+
+void state_notifier::m_deliver()
+{
+  const std::lock_guard<std::mutex> lock(m_client_mutex);
+  m_call_client();
+}
+
+void state_notifier::m_call_client()
+{
+  m_delivered++;
+  if (m_client)
+  {
+    m_client->state_change(m_client_data);
+  }
+}
+
+}  // namespace unigd
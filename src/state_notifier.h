@@ -0,0 +1,75 @@
+#ifndef __UNIGD_STATE_NOTIFIER_H__
+#define __UNIGD_STATE_NOTIFIER_H__
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+
+#include "unigd_external.h"
+
+namespace unigd
+{
+struct state_notifier_stats
+{
+  uint64_t requested;   // state changes of the device
+  uint64_t delivered;   // notifications sent
+  uint64_t suppressed;  // state changes merged into a later notification
+};
+
+// Sends state change notifications to the attached client.
+//
+// With a window of 0, every state change is passed on right away by the calling thread.
+// Otherwise a timer thread sends the notifications: a state change is passed on as soon
+// as the thread wakes up, all further ones within the window are merged into a single
+// notification at its end. The last state change is always delivered, notify() itself
+// never waits for the client.
+class state_notifier
+{
+ public:
+  explicit state_notifier(std::chrono::milliseconds t_window);
+  // Delivers a pending notification before the timer thread stops.
+  ~state_notifier();
+
+  state_notifier(const state_notifier&) = delete;
+  state_notifier& operator=(const state_notifier&) = delete;
+
+  void attach(ex::graphics_client* t_client, void* t_client_data);
+  // Delivers a pending notification first, none is sent to the client once this
+  // returns.
+  void detach();
+
+  void notify();
+  state_notifier_stats stats() const;
+
+ private:
+  const std::chrono::milliseconds m_window;
+
+  // Held while the client is called
+  std::mutex m_client_mutex;
+  ex::graphics_client* m_client = nullptr;
+  void* m_client_data = nullptr;
+
+  std::mutex m_mutex;
+  std::condition_variable m_cv;
+  bool m_pending = false;
+  bool m_stop = false;
+
+  std::atomic<uint64_t> m_requested{0};
+  std::atomic<uint64_t> m_delivered{0};
+  std::atomic<uint64_t> m_suppressed{0};
+
+  // Declared last, it is started once everything else is initialized.
+  std::thread m_thread;
+
+  void m_run();
+  void m_deliver();
+  // m_client_mutex has to be held
+  void m_call_client();
+};
+
+}  // namespace unigd
+
+#endif /* __UNIGD_STATE_NOTIFIER_H__ */
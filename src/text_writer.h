@@ -0,0 +1,230 @@
+#ifndef __UNIGD_TEXT_WRITER_H__
+#define __UNIGD_TEXT_WRITER_H__
+
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <type_traits>
+
+#include <fmt/format.h>
+
+#include "draw_data.h"
+
+namespace unigd
+{
+namespace renderers
+{
+// Low level output for the text renderers (SVG, JSON, TikZ).
+//
+// The functions produce the same characters as the corresponding fmt format strings, but
+// skip parsing format strings and write plain runs of characters in bulk. They are meant
+// for the per element hot paths, anything else should keep using fmt::format_to.
+
+namespace detail
+{
+constexpr std::array<char, 512> make_hex_table()
+{
+  std::array<char, 512> table{};
+  constexpr char digits[] = "0123456789ABCDEF";
+  for (std::size_t i = 0; i != 256; ++i)
+  {
+    table[i * 2] = digits[i >> 4];
+    table[i * 2 + 1] = digits[i & 15];
+  }
+  return table;
+}
+
+// Two upper case hex digits for every byte value.
+constexpr std::array<char, 512> hex_table = make_hex_table();
+}  // namespace detail
+
+template <std::size_t N>
+inline void write_literal(fmt::memory_buffer& t_os, const char (&t_str)[N])
+{
+  t_os.append(t_str, t_str + N - 1);
+}
+
+inline void write_string(fmt::memory_buffer& t_os, const std::string& t_str)
+{
+  t_os.append(t_str.data(), t_str.data() + t_str.size());
+}
+
+template <class T>
+inline void write_int(fmt::memory_buffer& t_os, T t_value)
+{
+  const fmt::format_int str(t_value);
+  t_os.append(str.data(), str.data() + str.size());
+}
+
+// Same as fmt "{:.2f}".
+inline void write_fixed2(fmt::memory_buffer& t_os, double t_value)
+{
+  const double abs = std::fabs(t_value);
+  // Huge values, NaN and infinity are rare enough to take the slow path.
+  if (!(abs < 1e9))
+  {
+    fmt::format_to(std::back_inserter(t_os), "{:.2f}", t_value);
+    return;
+  }
+  const double scaled = abs * 100.0;
+  const double whole = std::floor(scaled);
+  const double frac = scaled - whole;
+  // The multiplication can be off by far less than 1e-4, so only values this close to
+  // a tie might round differently than the exact decimal value fmt rounds.
+  if (std::fabs(frac - 0.5) < 1e-4)
+  {
+    fmt::format_to(std::back_inserter(t_os), "{:.2f}", t_value);
+    return;
+  }
+  auto n = static_cast<uint64_t>(whole) + (frac > 0.5 ? 1 : 0);
+
+  char buf[24];
+  char* const end = buf + sizeof(buf);
+  char* p = end;
+  *--p = static_cast<char>('0' + n % 10);
+  n /= 10;
+  *--p = static_cast<char>('0' + n % 10);
+  n /= 10;
+  *--p = '.';
+  do
+  {
+    *--p = static_cast<char>('0' + n % 10);
+    n /= 10;
+  } while (n != 0);
+  if (std::signbit(t_value))
+  {
+    *--p = '-';
+  }
+  t_os.append(p, end);
+}
+
+// Same as fmt "{:02X}{:02X}{:02X}" of the color channels.
+inline void write_hex_color(fmt::memory_buffer& t_os, color_t t_col)
+{
+  const char* r = &detail::hex_table[color::red(t_col) * 2];
+  const char* g = &detail::hex_table[color::green(t_col) * 2];
+  const char* b = &detail::hex_table[color::blue(t_col) * 2];
+  const char hex[6] = {r[0], r[1], g[0], g[1], b[0], b[1]};
+  t_os.append(hex, hex + 6);
+}
+
+// Appends t_text, replacing every character for which t_escape returns a replacement.
+// Characters in between are copied in runs.
+template <class F>
+inline void write_escaped(fmt::memory_buffer& t_os, const std::string& t_text, F t_escape)
+{
+  const char* run = t_text.data();
+  const char* const end = run + t_text.size();
+  for (const char* p = run; p != end; ++p)
+  {
+    const char* replacement = t_escape(*p);
+    if (replacement)
+    {
+      t_os.append(run, p);
+      t_os.append(replacement, replacement + std::char_traits<char>::length(replacement));
+      run = p + 1;
+    }
+  }
+  t_os.append(run, end);
+}
+
+inline void write_xml_escaped(fmt::memory_buffer& t_os, const std::string& t_text)
+{
+  write_escaped(t_os, t_text,
+                [](char c) -> const char*
+                {
+                  switch (c)
+                  {
+                    case '&':
+                      return "&amp;";
+                    case '<':
+                      return "&lt;";
+                    case '>':
+                      return "&gt;";
+                    case '"':
+                      return "&quot;";
+                    case '\'':
+                      return "&apos;";
+                    default:
+                      return nullptr;
+                  }
+                });
+}
+
+inline void write_tex_escaped(fmt::memory_buffer& t_os, const std::string& t_text)
+{
+  write_escaped(t_os, t_text,
+                [](char c) -> const char*
+                {
+                  switch (c)
+                  {
+                    case '&':
+                      return "\\&";
+                    case '%':
+                      return "\\%";
+                    case '$':
+                      return "\\$";
+                    case '#':
+                      return "\\#";
+                    case '_':
+                      return "\\_";
+                    case '{':
+                      return "\\{";
+                    case '}':
+                      return "\\}";
+                    case '~':
+                      return "\\textasciitilde";
+                    case '^':
+                      return "\\textasciicircum";
+                    case '\\':
+                      return "\\textbackslash";
+                    default:
+                      return nullptr;
+                  }
+                });
+}
+
+// Appends all arguments: string literals and strings as they are, floating point
+// numbers with two decimals ("{:.2f}"), integers in decimal and booleans as
+// true / false.
+inline void write_all(fmt::memory_buffer&) {}
+
+template <class T, class... Args>
+inline void write_all(fmt::memory_buffer& t_os, const T& t_value, const Args&... t_args)
+{
+  if constexpr (std::is_floating_point<T>::value)
+  {
+    write_fixed2(t_os, t_value);
+  }
+  else if constexpr (std::is_same<T, bool>::value)
+  {
+    if (t_value)
+    {
+      write_literal(t_os, "true");
+    }
+    else
+    {
+      write_literal(t_os, "false");
+    }
+  }
+  else if constexpr (std::is_integral<T>::value)
+  {
+    write_int(t_os, t_value);
+  }
+  else if constexpr (std::is_same<T, std::string>::value)
+  {
+    write_string(t_os, t_value);
+  }
+  else
+  {
+    write_literal(t_os, t_value);
+  }
+  write_all(t_os, t_args...);
+}
+
+}  // namespace renderers
+}  // namespace unigd
+
+#endif /* __UNIGD_TEXT_WRITER_H__ */
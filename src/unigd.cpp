@@ -1,6 +1,10 @@
 #include <algorithm>  // std::max
+#include <atomic>
+#include <chrono>
+#include <cmath>
 #include <memory>
 #include <string>
+#include <thread>
 #include <vector>
 
 #include <cpp11/as.hpp>
@@ -10,13 +14,19 @@
 #include <cpp11/list.hpp>
 #include <cpp11/logicals.hpp>
 #include <cpp11/raws.hpp>
+#include <cpp11/doubles.hpp>
 #include <cpp11/strings.hpp>
 
+#include "byte_sink.h"
 #include "debug_print.h"
 #include "generic_dev.h"
+#include "page_codec.h"
+#include "page_index.h"
+#include "page_lod.h"
 #include "r_thread.h"
 #include "renderer_svg.h"
 #include "renderers.h"
+#include "text_writer.h"
 #include "unigd_dev.h"
 #include "unigd_version.h"
 #include "uuid.h"
@@ -36,11 +46,25 @@ inline std::shared_ptr<unigd::unigd_device> validate_unigddev(int devnum)
 }  // namespace
 
 [[cpp11::register]] int unigd_ugd_(std::string bg, double width, double height,
-                                   double pointsize, cpp11::list aliases, bool reset_par)
+                                   double pointsize, cpp11::list aliases, bool reset_par,
+                                   double cache_size, double memory_limit,
+                                   std::string spill_dir, bool primitive_runs,
+                                   int raster_threads, double notify_window)
 {
   int ibg = R_GE_str2col(bg.c_str());
 
-  const unigd::device_params dparams{ibg, width, height, pointsize, aliases, reset_par};
+  // cache size and memory limit are given in megabytes
+  const auto cache_bytes = static_cast<std::size_t>(std::max(0.0, cache_size) * 1048576);
+  const auto memory_bytes =
+      std::isfinite(memory_limit) && memory_limit > 0
+          ? std::max<std::size_t>(static_cast<std::size_t>(memory_limit * 1048576), 1)
+          : 0;
+
+  const unigd::device_params dparams{ibg,       width,     height,      pointsize,
+                                     aliases,   reset_par, cache_bytes, memory_bytes,
+                                     spill_dir, primitive_runs,
+                                     static_cast<unsigned>(std::max(raster_threads, 0)),
+                                     static_cast<unsigned>(std::max(notify_window, 0.0))};
 
   return std::make_shared<unigd::unigd_device>(dparams)->create("unigd");
 }
@@ -50,6 +74,9 @@ inline std::shared_ptr<unigd::unigd_device> validate_unigddev(int devnum)
   auto dev = validate_unigddev(devnum);
 
   const auto state = dev->plt_state();
+  const auto cache = dev->plt_cache_stats();
+  const auto memory = dev->plt_memory();
+  const auto notify = dev->plt_notify_stats();
 
   SEXP client_info;
   unigd::ex::graphics_client* client;
@@ -64,8 +91,27 @@ inline std::shared_ptr<unigd::unigd_device> validate_unigddev(int devnum)
   }
 
   using namespace cpp11::literals;
-  return cpp11::writable::list{"hsize"_nm = state.hsize, "upid"_nm = state.upid,
-                               "active"_nm = state.active, "client"_nm = client_info};
+  return cpp11::writable::list{
+      "hsize"_nm = state.hsize,
+      "upid"_nm = state.upid,
+      "active"_nm = state.active,
+      "client"_nm = client_info,
+      "cache"_nm = cpp11::writable::list{
+          "hits"_nm = static_cast<double>(cache.hits),
+          "misses"_nm = static_cast<double>(cache.misses),
+          "entries"_nm = static_cast<double>(cache.entries),
+          "bytes"_nm = static_cast<double>(cache.bytes)},
+      "memory"_nm = cpp11::writable::list{
+          "bytes"_nm = static_cast<double>(memory.mem_size),
+          "evictions"_nm = static_cast<double>(memory.evictions),
+          "spills"_nm = static_cast<double>(memory.spills),
+          "reloads"_nm = static_cast<double>(memory.reloads),
+          "spill_bytes"_nm = static_cast<double>(memory.spill_bytes),
+          "reload_bytes"_nm = static_cast<double>(memory.reload_bytes)},
+      "notifications"_nm = cpp11::writable::list{
+          "requested"_nm = static_cast<double>(notify.requested),
+          "delivered"_nm = static_cast<double>(notify.delivered),
+          "suppressed"_nm = static_cast<double>(notify.suppressed)}};
 }
 
 [[cpp11::register]] cpp11::list unigd_info_(int devnum)
@@ -125,7 +171,8 @@ inline std::shared_ptr<unigd::unigd_device> validate_unigddev(int devnum)
 }
 
 [[cpp11::register]] SEXP unigd_render_(int devnum, int page, double width, double height,
-                                       double zoom, std::string renderer_id)
+                                       double zoom, std::string renderer_id, double lod,
+                                       cpp11::doubles region)
 {
   auto dev = validate_unigddev(devnum);
 
@@ -140,7 +187,22 @@ inline std::shared_ptr<unigd::unigd_device> validate_unigddev(int devnum)
   {
     cpp11::stop("Not a valid renderer ID.");
   }
-  auto renderer = ren.generator();
+  std::unique_ptr<unigd::renderers::render_target> renderer = ren.generator();
+  if (lod > 0)
+  {
+    renderer = std::make_unique<unigd::renderers::lod_target>(std::move(renderer), lod);
+  }
+  if (region.size() != 0)
+  {
+    if (region.size() != 4)
+    {
+      cpp11::stop("region must be c(x, y, width, height).");
+    }
+    // Region is given in output pixels, like width and height
+    renderer = std::make_unique<unigd::renderers::region_target>(
+        std::move(renderer), unigd::grect<double>{region[0] / zoom, region[1] / zoom,
+                                                  region[2] / zoom, region[3] / zoom});
+  }
   if (!dev->plt_render(page, width / zoom, height / zoom, renderer.get(), zoom))
   {
     cpp11::stop("Plot does not exist.");
@@ -160,6 +222,478 @@ inline std::shared_ptr<unigd::unigd_device> validate_unigddev(int devnum)
   }
 }
 
+// Vector form of unigd_render_, all arguments have the same length.
+[[cpp11::register]] cpp11::list unigd_render_batch_(int devnum, cpp11::integers page,
+                                                    cpp11::doubles width,
+                                                    cpp11::doubles height,
+                                                    cpp11::doubles zoom,
+                                                    cpp11::strings renderer_id)
+{
+  auto dev = validate_unigddev(devnum);
+
+  const auto n = page.size();
+  std::vector<unigd::render_request> requests;
+  std::vector<bool> text;
+  requests.reserve(n);
+  for (R_xlen_t i = 0; i < n; ++i)
+  {
+    const std::string id = renderer_id[i];
+    unigd::renderers::renderer_map_entry ren;
+    if (!unigd::renderers::find(id, &ren))
+    {
+      cpp11::stop("Not a valid renderer ID.");
+    }
+    const auto plot = dev->plt_query(page[i], 1);
+    if (plot.ids.empty())
+    {
+      cpp11::stop("Plot does not exist.");
+    }
+    const double scale = width[i] < 0 || height[i] < 0 ? 1 : zoom[i];
+    requests.push_back({static_cast<int32_t>(plot.ids[0]), id, width[i] / scale,
+                        height[i] / scale, scale});
+    text.push_back(ren.info.text);
+  }
+
+  const auto rendered = dev->plt_render_batch(requests);
+
+  cpp11::writable::list result(n);
+  for (R_xlen_t i = 0; i < n; ++i)
+  {
+    if (!rendered[i])
+    {
+      cpp11::stop("Plot does not exist.");
+    }
+    const uint8_t* buf;
+    size_t buf_size;
+    rendered[i]->get_data(&buf, &buf_size);
+    if (text[i])
+    {
+      result[i] =
+          cpp11::writable::strings({cpp11::r_string(std::string(buf, buf + buf_size))});
+    }
+    else
+    {
+      result[i] = cpp11::writable::raws(buf, buf + buf_size);
+    }
+  }
+  return result;
+}
+
+// Draw calls of a plot added since a sequence (see page_store::delta), through the same
+// code path the C API uses.
+[[cpp11::register]] cpp11::list unigd_delta_(int devnum, int plot_id, double sequence)
+{
+  auto dev = validate_unigddev(devnum);
+  unigd::ex::delta_results delta;
+  if (!dev->api_delta(plot_id, static_cast<uint64_t>(sequence), &delta))
+  {
+    cpp11::stop("Plot does not exist.");
+  }
+  using namespace cpp11::literals;
+  return cpp11::writable::list{
+      "sequence"_nm = static_cast<double>(delta.sequence), "reset"_nm = delta.reset,
+      "data"_nm = cpp11::writable::raws(delta.data.begin(), delta.data.end())};
+}
+
+// Applies a delta to an encoded page the way a client would and returns the encoding
+// of the result.
+[[cpp11::register]] cpp11::writable::raws unigd_delta_apply_(cpp11::raws page,
+                                                          cpp11::raws delta)
+{
+  const std::vector<uint8_t> page_buf(page.begin(), page.end());
+  const std::vector<uint8_t> delta_buf(delta.begin(), delta.end());
+  unigd::renderers::Page p(0, {0, 0});
+  if (!unigd::renderers::codec::decode_page(page_buf.data(), page_buf.size(), &p) ||
+      !unigd::renderers::codec::decode_delta(delta_buf.data(), delta_buf.size(), &p))
+  {
+    cpp11::stop("Malformed page data.");
+  }
+  std::vector<uint8_t> out;
+  unigd::renderers::codec::encode_page(p, &out);
+  return cpp11::writable::raws(out.begin(), out.end());
+}
+
+// Draw calls (0 based, see renderers::page_index) of a plot whose bounds intersect a
+// rectangle, through the same code path the C API uses.
+[[cpp11::register]] cpp11::integers unigd_hit_test_(int devnum, int plot_id, double x,
+                                                    double y, double width, double height)
+{
+  auto dev = validate_unigddev(devnum);
+
+  std::vector<std::size_t> indices;
+  if (!dev->api_hit_test(plot_id, {x, y, width, height}, &indices))
+  {
+    cpp11::stop("Plot does not exist.");
+  }
+  cpp11::writable::integers result(indices.size());
+  for (std::size_t i = 0; i != indices.size(); ++i)
+  {
+    result[i] = static_cast<int>(indices[i]);
+  }
+  return result;
+}
+
+// Renders tiles of a plot through the same code path the C API uses.
+[[cpp11::register]] cpp11::list unigd_render_tiles_(int devnum, int plot_id,
+                                                    std::string renderer_id, int zoom,
+                                                    cpp11::integers x, cpp11::integers y,
+                                                    int tile_size)
+{
+  auto dev = validate_unigddev(devnum);
+
+  unigd::renderers::renderer_map_entry ren;
+  if (!unigd::renderers::find(renderer_id, &ren))
+  {
+    cpp11::stop("Not a valid renderer ID.");
+  }
+  if (x.size() != y.size() || tile_size <= 0)
+  {
+    cpp11::stop("Invalid tiles.");
+  }
+  std::vector<unigd::renderers::tile_id> tiles;
+  for (R_xlen_t i = 0; i < x.size(); ++i)
+  {
+    tiles.push_back({zoom, static_cast<uint32_t>(x[i]), static_cast<uint32_t>(y[i])});
+  }
+  const auto rendered = dev->api_render_tiles(renderer_id.c_str(), plot_id, tiles,
+                                              static_cast<uint32_t>(tile_size));
+  if (rendered.empty() && !tiles.empty())
+  {
+    cpp11::stop("Plot does not exist.");
+  }
+
+  cpp11::writable::list result(static_cast<R_xlen_t>(rendered.size()));
+  for (std::size_t i = 0; i != rendered.size(); ++i)
+  {
+    if (!rendered[i])
+    {
+      continue;
+    }
+    const uint8_t* buf;
+    size_t buf_size;
+    rendered[i]->get_data(&buf, &buf_size);
+    if (ren.info.text)
+    {
+      result[i] =
+          cpp11::writable::strings({cpp11::r_string(std::string(buf, buf + buf_size))});
+    }
+    else
+    {
+      result[i] = cpp11::writable::raws(buf, buf + buf_size);
+    }
+  }
+  return result;
+}
+
+// Renders a plot from several threads at once through the same code path the C API
+// uses. The plot is rendered at its current size so no thread ever has to wait for
+// the R main thread (which is blocked here until all threads have joined).
+[[cpp11::register]] cpp11::list unigd_render_concurrent_(int devnum, int plot_id,
+                                                         std::string renderer_id,
+                                                         int threads, int iterations)
+{
+  auto dev = validate_unigddev(devnum);
+
+  unigd::renderers::renderer_map_entry ren;
+  if (!unigd::renderers::find(renderer_id, &ren))
+  {
+    cpp11::stop("Not a valid renderer ID.");
+  }
+  threads = std::max(threads, 1);
+  iterations = std::max(iterations, 1);
+
+  // Reference output to compare every concurrent render against
+  auto reference = dev->api_render(renderer_id.c_str(), plot_id, -1, -1, 1);
+  if (!reference)
+  {
+    cpp11::stop("Plot does not exist.");
+  }
+  const uint8_t* ref_buf;
+  size_t ref_size;
+  reference->get_data(&ref_buf, &ref_size);
+
+  std::atomic<int> renders{0};
+  std::atomic<int> mismatches{0};
+  std::vector<std::thread> pool;
+  pool.reserve(threads);
+
+  const auto start = std::chrono::steady_clock::now();
+  for (int t = 0; t < threads; ++t)
+  {
+    pool.emplace_back(
+        [&]()
+        {
+          for (int i = 0; i < iterations; ++i)
+          {
+            auto data = dev->api_render(renderer_id.c_str(), plot_id, -1, -1, 1);
+            const uint8_t* buf = nullptr;
+            size_t buf_size = 0;
+            if (data)
+            {
+              data->get_data(&buf, &buf_size);
+            }
+            if (!data || buf_size != ref_size ||
+                !std::equal(buf, buf + buf_size, ref_buf))
+            {
+              ++mismatches;
+            }
+            ++renders;
+          }
+        });
+  }
+  for (auto& th : pool)
+  {
+    th.join();
+  }
+  const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+  using namespace cpp11::literals;
+  return cpp11::writable::list{"threads"_nm = threads, "renders"_nm = renders.load(),
+                               "mismatches"_nm = mismatches.load(),
+                               "seconds"_nm = elapsed.count()};
+}
+
+// Renders a plot from two threads at two different sizes through the same code path the
+// C API uses, so each thread keeps undoing the replay of the other. Tasks for the R
+// thread are run here while the threads are rendering.
+[[cpp11::register]] cpp11::list unigd_render_sizes_(int devnum, int plot_id,
+                                                    std::string renderer_id,
+                                                    cpp11::doubles widths,
+                                                    cpp11::doubles heights, int iterations)
+{
+  auto dev = validate_unigddev(devnum);
+
+  unigd::renderers::renderer_map_entry ren;
+  if (!unigd::renderers::find(renderer_id, &ren))
+  {
+    cpp11::stop("Not a valid renderer ID.");
+  }
+  if (widths.size() != 2 || heights.size() != 2)
+  {
+    cpp11::stop("Exactly two sizes are needed.");
+  }
+  iterations = std::max(iterations, 1);
+  const double width[] = {widths[0], widths[1]};
+  const double height[] = {heights[0], heights[1]};
+
+  std::vector<std::vector<uint8_t>> reference(2);
+  std::atomic<int> renders{0};
+  std::atomic<int> failures{0};
+  std::atomic<int> mismatches{0};
+  std::atomic<int> running{0};
+  std::vector<std::thread> pool;
+
+  const auto render = [&](int t_size, std::vector<uint8_t>* t_out)
+  {
+    auto data = dev->api_render(renderer_id.c_str(), plot_id, width[t_size],
+                                height[t_size], 1);
+    if (!data)
+    {
+      ++failures;
+      return;
+    }
+    const uint8_t* buf;
+    size_t buf_size;
+    data->get_data(&buf, &buf_size);
+    if (t_out)
+    {
+      t_out->assign(buf, buf + buf_size);
+    }
+    else if (!std::equal(buf, buf + buf_size, reference[t_size].begin(),
+                         reference[t_size].end()))
+    {
+      ++mismatches;
+    }
+    ++renders;
+  };
+  // Rendering at another size waits for a replay on the R thread
+  const auto pump = [&]()
+  {
+    while (running > 0)
+    {
+      unigd::async::r_thread_run_pending();
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    for (auto& th : pool)
+    {
+      th.join();
+    }
+    pool.clear();
+  };
+
+  for (int t = 0; t < 2; ++t)
+  {
+    ++running;
+    pool.emplace_back(
+        [&, t]()
+        {
+          render(t, &reference[t]);
+          --running;
+        });
+    pump();
+  }
+  if (failures > 0)
+  {
+    cpp11::stop("Plot does not exist.");
+  }
+  renders = 0;
+
+  for (int t = 0; t < 2; ++t)
+  {
+    ++running;
+    pool.emplace_back(
+        [&, t]()
+        {
+          for (int i = 0; i < iterations; ++i)
+          {
+            render(t, nullptr);
+          }
+          --running;
+        });
+  }
+  pump();
+
+  using namespace cpp11::literals;
+  return cpp11::writable::list{"renders"_nm = renders.load(),
+                               "failures"_nm = failures.load(),
+                               "mismatches"_nm = mismatches.load()};
+}
+
+// Starts renders through the asynchronous C API path and polls them until they finish.
+// Renders at the current plot size never wait for the R thread, so polling here can not
+// dead lock.
+[[cpp11::register]] cpp11::list unigd_render_async_(int devnum, int plot_id,
+                                                    std::string renderer_id, int count,
+                                                    bool cancel)
+{
+  auto dev = validate_unigddev(devnum);
+
+  auto reference = dev->api_render(renderer_id.c_str(), plot_id, -1, -1, 1);
+  if (!reference)
+  {
+    cpp11::stop("Plot does not exist.");
+  }
+  const uint8_t* ref_buf;
+  size_t ref_size;
+  reference->get_data(&ref_buf, &ref_size);
+
+  std::atomic<int> callbacks{0};
+  const auto callback = [](void* user_data, unigd_async_status, unigd_render_access)
+  { ++*static_cast<std::atomic<int>*>(user_data); };
+
+  std::vector<std::shared_ptr<unigd::ex::async_render>> renders;
+  for (int i = 0; i < count; ++i)
+  {
+    renders.push_back(std::make_shared<unigd::ex::async_render>(callback, &callbacks));
+    dev->api_render_async(renderer_id.c_str(), plot_id, -1, -1, 1, renders.back());
+    if (cancel)
+    {
+      renders.back()->cancel();
+    }
+  }
+
+  int done = 0;
+  int cancelled = 0;
+  int pending = 0;
+  int mismatches = 0;
+  const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+  for (const auto& render : renders)
+  {
+    unigd_render_access access;
+    auto status = render->status(&access);
+    while (status == UNIGD_ASYNC_PENDING && std::chrono::steady_clock::now() < deadline)
+    {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+      status = render->status(&access);
+    }
+    switch (status)
+    {
+      case UNIGD_ASYNC_PENDING:
+        ++pending;
+        break;
+      case UNIGD_ASYNC_CANCELLED:
+        ++cancelled;
+        break;
+      case UNIGD_ASYNC_DONE:
+        ++done;
+        if (access.size != ref_size ||
+            !std::equal(access.buffer, access.buffer + access.size, ref_buf))
+        {
+          ++mismatches;
+        }
+        break;
+      default:
+        ++mismatches;
+        break;
+    }
+  }
+
+  using namespace cpp11::literals;
+  return cpp11::writable::list{"done"_nm = done, "cancelled"_nm = cancelled,
+                               "pending"_nm = pending, "callbacks"_nm = callbacks.load(),
+                               "mismatches"_nm = mismatches};
+}
+
+// Streams a plot at its current size through the C API code path. The chunk function
+// stops the render after t_limit chunks (0 for no limit).
+[[cpp11::register]] cpp11::list unigd_render_stream_(int devnum, int plot_id,
+                                                     std::string renderer_id, int limit)
+{
+  auto dev = validate_unigddev(devnum);
+
+  std::vector<uint8_t> output;
+  int chunks = 0;
+  double max_chunk = 0;
+  const bool complete = dev->api_render_stream(
+      renderer_id.c_str(), plot_id, -1, -1, 1,
+      [&](const uint8_t* t_data, std::size_t t_size)
+      {
+        output.insert(output.end(), t_data, t_data + t_size);
+        max_chunk = std::max(max_chunk, static_cast<double>(t_size));
+        return limit == 0 || ++chunks < limit;
+      });
+
+  using namespace cpp11::literals;
+  return cpp11::writable::list{
+      "output"_nm = cpp11::writable::raws(output.begin(), output.end()),
+      "chunks"_nm = chunks, "max_chunk"_nm = max_chunk, "complete"_nm = complete};
+}
+
+// Renders a plot at its current size into a buffer of capacity bytes through the C API
+// code path. With grow, the buffer is grown when the output does not fit.
+[[cpp11::register]] cpp11::list unigd_render_into_(int devnum, int plot_id,
+                                                   std::string renderer_id,
+                                                   double capacity, bool grow)
+{
+  auto dev = validate_unigddev(devnum);
+
+  struct client
+  {
+    std::vector<uint8_t> memory;
+    int grows = 0;
+  } cl;
+  cl.memory.resize(static_cast<std::size_t>(capacity));
+  const auto grow_fn = [](void* user_data, uint8_t*, uint64_t,
+                          uint64_t new_capacity) -> uint8_t*
+  {
+    auto* c = static_cast<client*>(user_data);
+    c->grows++;
+    c->memory.resize(new_capacity);
+    return c->memory.data();
+  };
+  unigd_render_buffer buffer{cl.memory.data(), cl.memory.size(),
+                             grow ? +grow_fn : nullptr, &cl};
+  uint64_t size = 0;
+  const bool ok =
+      dev->api_render_into(renderer_id.c_str(), plot_id, -1, -1, 1, &buffer, &size);
+
+  using namespace cpp11::literals;
+  const auto written = std::min<uint64_t>(size, buffer.capacity);
+  return cpp11::writable::list{
+      "output"_nm = cpp11::writable::raws(buffer.buffer, buffer.buffer + written),
+      "size"_nm = static_cast<double>(size), "grows"_nm = cl.grows, "ok"_nm = ok};
+}
+
 [[cpp11::register]] bool unigd_remove_(int devnum, int page)
 {
   auto dev = validate_unigddev(devnum);
@@ -218,3 +752,121 @@ inline std::shared_ptr<unigd::unigd_device> validate_unigddev(int devnum)
 {
   unigd::async::ipc_close();
 }
+
+namespace
+{
+// Milliseconds taken by t_fn(buffer) for t_iterations runs into a cleared buffer.
+template <class F>
+double bench_writer_case(int t_iterations, F t_fn)
+{
+  fmt::memory_buffer buf;
+  const auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < t_iterations; ++i)
+  {
+    buf.clear();
+    t_fn(buf);
+  }
+  const std::chrono::duration<double, std::milli> elapsed =
+      std::chrono::steady_clock::now() - start;
+  return elapsed.count();
+}
+}  // namespace
+
+[[cpp11::register]] cpp11::data_frame unigd_bench_writer_(int iterations)
+{
+  using namespace cpp11::literals;
+  using namespace unigd::renderers;
+
+  std::vector<double> numbers;
+  std::vector<std::string> texts;
+  std::vector<unigd::color_t> colors;
+  for (int i = 0; i < 1000; ++i)
+  {
+    numbers.push_back(std::sin(i) * std::pow(10.0, i % 5));
+    texts.push_back("Label " + std::to_string(i) + (i % 8 == 0 ? " <a & b>" : ""));
+    colors.push_back(color::rgba(i % 256, (i * 7) % 256, (i * 13) % 256, 255));
+  }
+
+  cpp11::writable::strings names{"numbers", "escaping", "colors"};
+  cpp11::writable::doubles fmt_ms{
+      bench_writer_case(iterations,
+                        [&](fmt::memory_buffer& t_os)
+                        {
+                          for (double x : numbers)
+                          {
+                            fmt::format_to(std::back_inserter(t_os), "{:.2f} ", x);
+                          }
+                        }),
+      bench_writer_case(iterations,
+                        [&](fmt::memory_buffer& t_os)
+                        {
+                          for (const auto& text : texts)
+                          {
+                            for (const char& c : text)
+                            {
+                              switch (c)
+                              {
+                                case '&':
+                                  fmt::format_to(std::back_inserter(t_os), "&amp;");
+                                  break;
+                                case '<':
+                                  fmt::format_to(std::back_inserter(t_os), "&lt;");
+                                  break;
+                                case '>':
+                                  fmt::format_to(std::back_inserter(t_os), "&gt;");
+                                  break;
+                                default:
+                                  fmt::format_to(std::back_inserter(t_os), "{}", c);
+                              }
+                            }
+                          }
+                        }),
+      bench_writer_case(iterations,
+                        [&](fmt::memory_buffer& t_os)
+                        {
+                          for (auto col : colors)
+                          {
+                            fmt::format_to(std::back_inserter(t_os),
+                                           "fill: #{:02X}{:02X}{:02X};",
+                                           color::red(col), color::green(col),
+                                           color::blue(col));
+                          }
+                        })};
+  cpp11::writable::doubles writer_ms{
+      bench_writer_case(iterations,
+                        [&](fmt::memory_buffer& t_os)
+                        {
+                          for (double x : numbers)
+                          {
+                            write_all(t_os, x, " ");
+                          }
+                        }),
+      bench_writer_case(iterations,
+                        [&](fmt::memory_buffer& t_os)
+                        {
+                          for (const auto& text : texts)
+                          {
+                            write_xml_escaped(t_os, text);
+                          }
+                        }),
+      bench_writer_case(iterations,
+                        [&](fmt::memory_buffer& t_os)
+                        {
+                          for (auto col : colors)
+                          {
+                            write_literal(t_os, "fill: #");
+                            write_hex_color(t_os, col);
+                            write_literal(t_os, ";");
+                          }
+                        })};
+
+  return cpp11::writable::data_frame(
+      {"case"_nm = names, "fmt_ms"_nm = fmt_ms, "writer_ms"_nm = writer_ms});
+}
+
+// Bytes the output buffers of the binary renderers moved while growing (since the
+// package was loaded).
+[[cpp11::register]] double unigd_copied_bytes_()
+{
+  return static_cast<double>(unigd::byte_sink::total_copied());
+}
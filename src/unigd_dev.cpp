@@ -1,11 +1,14 @@
 
 #include "unigd_dev.h"
 
+#include <algorithm>
 #include <cmath>
 #include <cstring>
 #include <memory>
 #include <string>
 #include <string_view>
+#include <tuple>
+#include <thread>
 
 #include <cpp11/as.hpp>
 #include <cpp11/doubles.hpp>
@@ -16,6 +19,8 @@
 #include <systemfonts.h>
 
 #include "debug_print.h"
+#include "page_index.h"
+#include "page_lod.h"
 #include "r_thread.h"
 #include "renderers.h"
 
@@ -125,11 +130,18 @@ unigd_device::unigd_device(const device_params& t_params)
     , system_aliases(cpp11::as_cpp<cpp11::list>(t_params.aliases["system"]))
     , user_aliases(cpp11::as_cpp<cpp11::list>(t_params.aliases["user"]))
     , m_history()
+    , m_render_cache(t_params.render_cache_size)
     , m_client(nullptr)
+    , m_notifier(std::chrono::milliseconds(t_params.notify_window))
+    , m_primitive_runs(t_params.primitive_runs)
+    , m_raster_threads(t_params.raster_threads > 0
+                           ? t_params.raster_threads
+                           : std::max(std::thread::hardware_concurrency(), 1U))
+    , m_render_pool(std::thread::hardware_concurrency())
 {
   m_df_displaylist = true;
 
-  m_data_store = std::make_shared<page_store>();
+  m_data_store = std::make_shared<page_store>(t_params.memory_limit, t_params.spill_dir);
 
   m_reset_par = t_params.reset_par ? r_graphics_par_get() : cpp11::list();
 
@@ -147,6 +159,7 @@ bool unigd_device::attach_client(ex::graphics_client* t_client,
   m_client_id = t_client_id;
   m_client_data = t_client_data;
   m_client->start(m_client_data);
+  m_notifier.attach(m_client, m_client_data);
   return true;
 }
 
@@ -176,6 +189,7 @@ bool unigd_device::remove_client()
   {
     return false;
   }
+  m_notifier.detach();
   m_client->close(m_client_data);
   m_client = nullptr;
   m_client_data = nullptr;
@@ -262,10 +276,7 @@ void unigd_device::dev_activate(pDevDesc dd)
   }
   debug_println("ACTIVATE");
   m_data_store->set_device_active(true);
-  if (m_client)
-  {
-    m_client->state_change(m_client_data);
-  }
+  m_notifier.notify();
 }
 
 void unigd_device::dev_deactivate(pDevDesc dd)
@@ -276,10 +287,7 @@ void unigd_device::dev_deactivate(pDevDesc dd)
   }
   debug_println("DEACTIVATE");
   m_data_store->set_device_active(false);
-  if (m_client)
-  {
-    m_client->state_change(m_client_data);
-  }
+  m_notifier.notify();
 }
 
 void unigd_device::dev_mode(int mode, pDevDesc dd)
@@ -291,14 +299,12 @@ void unigd_device::dev_mode(int mode, pDevDesc dd)
   }
 
   // flush buffer
-  m_data_store->add_dc(m_target.get_index(), std::move(m_dc_buffer), replaying);
-  m_dc_buffer =
-      std::vector<std::unique_ptr<unigd::renderers::DrawCall>>();  // reinitialize
+  m_data_store->add_dc(m_target.get_index(), std::move(m_dc_buffer), m_dc_styles,
+                       replaying);
+  m_dc_buffer.clear();  // reinitialize
+  m_dc_styles.clear();
 
-  if (m_client)
-  {
-    m_client->state_change(m_client_data);
-  }
+  m_notifier.notify();
 }
 
 void unigd_device::dev_close(pDevDesc dd)
@@ -446,11 +452,16 @@ inline color_t gc_fill(pGEcontext gc)
   return gc->fill;
 }
 
+renderers::style_id_t unigd_device::line_style(pGEcontext gc)
+{
+  return m_dc_styles.intern(gc_lineinfo(gc));
+}
+
 void unigd_device::dev_line(double x1, double y1, double x2, double y2, pGEcontext gc,
                             pDevDesc dd)
 {
-  put(std::make_unique<renderers::Line>(gc_lineinfo(gc), gvertex<double>{x1, y1},
-                                        gvertex<double>{x2, y2}));
+  put_primitive(
+      renderers::Line(line_style(gc), gvertex<double>{x1, y1}, gvertex<double>{x2, y2}));
 }
 
 void unigd_device::dev_text(double x, double y, const char* str, double rot, double hadj,
@@ -458,23 +469,25 @@ void unigd_device::dev_text(double x, double y, const char* str, double rot, dou
 {
   const auto& font = resolve_font(gc->fontfamily, gc->fontface);
 
-  put(std::make_unique<renderers::Text>(
-      gc->col, gvertex<double>{x, y}, str, rot, hadj,
-      renderers::TextInfo{font.weight, font.features_css, font.name, gc->cex * gc->ps,
-                          is_italic(gc->fontface), dev_strWidth(str, gc, dd)}));
+  const auto text_style =
+      m_dc_styles.intern(renderers::TextInfo{font.weight, font.features_css, font.name,
+                                             gc->cex * gc->ps, is_italic(gc->fontface)});
+
+  put<renderers::Text>(gc->col, gvertex<double>{x, y}, str, rot, hadj, text_style,
+                       dev_strWidth(str, gc, dd));
 }
 
 void unigd_device::dev_rect(double x0, double y0, double x1, double y1, pGEcontext gc,
                             pDevDesc dd)
 {
-  put(std::make_unique<renderers::Rect>(gc_lineinfo(gc), gc_fill(gc),
-                                        normalize_rect(x0, y0, x1, y1)));
+  put_primitive(
+      renderers::Rect(line_style(gc), gc_fill(gc), normalize_rect(x0, y0, x1, y1)));
 }
 
 void unigd_device::dev_circle(double x, double y, double r, pGEcontext gc, pDevDesc dd)
 {
-  put(std::make_unique<renderers::Circle>(gc_lineinfo(gc), gc_fill(gc),
-                                          gvertex<double>{x, y}, r));
+  put_primitive(
+      renderers::Circle(line_style(gc), gc_fill(gc), gvertex<double>{x, y}, r));
 }
 
 void unigd_device::dev_polygon(int n, double* x, double* y, pGEcontext gc, pDevDesc dd)
@@ -484,8 +497,7 @@ void unigd_device::dev_polygon(int n, double* x, double* y, pGEcontext gc, pDevD
   {
     points[i] = {x[i], y[i]};
   }
-  put(std::make_unique<renderers::Polygon>(gc_lineinfo(gc), gc_fill(gc),
-                                           std::move(points)));
+  put<renderers::Polygon>(line_style(gc), gc_fill(gc), std::move(points));
 }
 
 void unigd_device::dev_polyline(int n, double* x, double* y, pGEcontext gc, pDevDesc dd)
@@ -495,7 +507,7 @@ void unigd_device::dev_polyline(int n, double* x, double* y, pGEcontext gc, pDev
   {
     points[i] = {x[i], y[i]};
   }
-  put(std::make_unique<renderers::Polyline>(gc_lineinfo(gc), std::move(points)));
+  put<renderers::Polyline>(line_style(gc), std::move(points));
 }
 
 void unigd_device::dev_path(double* x, double* y, int npoly, int* nper, Rboolean winding,
@@ -513,8 +525,8 @@ void unigd_device::dev_path(double* x, double* y, int npoly, int* nper, Rboolean
     points[i] = {x[i], y[i]};
   }
 
-  put(std::make_unique<renderers::Path>(gc_lineinfo(gc), gc_fill(gc), std::move(points),
-                                        std::move(vnper), winding));
+  put<renderers::Path>(line_style(gc), gc_fill(gc), std::move(points), std::move(vnper),
+                       winding);
 }
 
 void unigd_device::dev_raster(unsigned int* raster, int w, int h, double x, double y,
@@ -525,25 +537,13 @@ void unigd_device::dev_raster(unsigned int* raster, int w, int h, double x, doub
   const double abs_width = std::fabs(width);
 
   std::vector<unsigned int> vraster(raster, raster + (w * h));
-  put(std::make_unique<renderers::Raster>(
+  put<renderers::Raster>(
       std::move(vraster), gvertex<int>{w, h},
-      grect<double>{x, y - abs_height, abs_width, abs_height}, rot, interpolate));
+      grect<double>{x, y - abs_height, abs_width, abs_height}, rot, interpolate);
 }
 
 // OTHER
 
-void unigd_device::put(std::unique_ptr<renderers::DrawCall>&& t_dc)
-{
-  if (m_target.is_void())
-  {
-    return;
-  }
-
-  // debug_println("DC put");
-  m_dc_buffer.emplace_back(std::move(t_dc));
-  // m_data_store->add_dc(m_target.get_index(), dc, replaying);
-}
-
 void unigd_device::plt_prerender(int index, double width, double height)
 {
   if (index == -1)
@@ -585,6 +585,7 @@ bool unigd_device::plt_clear()
 {
   // clear store
   bool r = m_data_store->remove_all();
+  m_render_cache.clear();
 
   // clear history
   m_history.clear();
@@ -597,10 +598,7 @@ bool unigd_device::plt_clear()
     par(m_reset_par);
   }
 
-  if (m_client)
-  {
-    m_client->state_change(m_client_data);
-  }
+  m_notifier.notify();
 
   return r;
 }
@@ -613,7 +611,12 @@ bool unigd_device::plt_remove(int index)
   }
 
   // remove from store
+  const auto removed = m_data_store->query(index, 1).ids;
   bool r = m_data_store->remove(index, false);
+  for (const auto id : removed)
+  {
+    m_render_cache.erase(id);
+  }
 
   // remove from history
 
@@ -633,16 +636,14 @@ bool unigd_device::plt_remove(int index)
   m_target.set_newest_index(m_target.get_newest_index() - 1);
   replaying = false;
 
-  if (m_client)
-  {
-    m_client->state_change(m_client_data);
-  }
+  m_notifier.notify();
 
   return r;
 }
 
 bool unigd_device::plt_render(int index, double width, double height,
-                              renderers::render_target* t_renderer, double t_scale)
+                              renderers::render_target* t_renderer, double t_scale,
+                              page_version_t* t_version)
 {
   const auto index_norm = m_data_store->normalize_index(index);
 
@@ -650,19 +651,78 @@ bool unigd_device::plt_render(int index, double width, double height,
   {
     return false;
   }
+  t_renderer->raster_threads(m_raster_threads);
 
   debug_println("check cached size");
-  if (m_data_store->render_if_size(*index_norm, t_renderer, t_scale, {width, height}))
+  if (m_data_store->render_if_size(*index_norm, t_renderer, t_scale, {width, height},
+                                   t_version))
   {
     return true;
   }
-  else
+  if (!plt_replay(*index_norm, width, height))
   {
-    debug_println("graphics engine rerender");
-    plt_prerender(*index_norm, width, height);
+    return false;
   }
   debug_println("render");
-  return m_data_store->render(*index_norm, t_renderer, t_scale);
+  return m_data_store->render(*index_norm, t_renderer, t_scale, t_version);
+}
+
+std::experimental::optional<ex::plot_relative_t> unigd_device::plt_replay(int index,
+                                                                          double width,
+                                                                          double height)
+{
+  const auto index_norm = m_data_store->normalize_index(index);
+  if (!index_norm.has_value())
+  {
+    return std::experimental::nullopt;
+  }
+  // Pages that have been evicted are rebuilt at their last size
+  const auto page_size = m_data_store->size(*index_norm);
+  if (width < 0.1)
+  {
+    width = page_size.x;
+  }
+  if (height < 0.1)
+  {
+    height = page_size.y;
+  }
+  debug_println("graphics engine rerender");
+  plt_prerender(*index_norm, width, height);
+  return index_norm;
+}
+
+bool unigd_device::m_render_plot(int t_index, double t_width, double t_height,
+                                 renderers::render_target* t_renderer, double t_scale,
+                                 page_version_t* t_version)
+{
+  const auto render_sized = [&](ex::plot_relative_t t_at)
+  {
+    return m_data_store->render_if_size(t_at, t_renderer, t_scale, {t_width, t_height},
+                                        t_version);
+  };
+  if (render_sized(t_index))
+  {
+    return true;
+  }
+  const auto index =
+      async::r_thread([&]() { return plt_replay(t_index, t_width, t_height); }).get();
+  if (!index)
+  {
+    return false;
+  }
+  if (render_sized(*index))
+  {
+    return true;
+  }
+  // Another replay at a different size or an eviction got in between the replay and the
+  // render. Replaying and rendering in one step on the R thread can not be interrupted.
+  return async::r_thread(
+             [&]()
+             {
+               return plt_render(*index, t_width, t_height, t_renderer, t_scale,
+                                 t_version);
+             })
+      .get();
 }
 
 int unigd_device::plt_index(int32_t id)
@@ -670,6 +730,27 @@ int unigd_device::plt_index(int32_t id)
   return m_data_store->find_index(id).value_or(-1);
 }
 
+bool unigd_device::plt_hit_test(int index, grect<double> t_rect,
+                                std::vector<std::size_t>* t_out)
+{
+  return m_data_store->hit_test(index, t_rect, t_out);
+}
+
+render_cache_stats unigd_device::plt_cache_stats()
+{
+  return m_render_cache.stats();
+}
+
+page_store_memory unigd_device::plt_memory()
+{
+  return m_data_store->memory();
+}
+
+state_notifier_stats unigd_device::plt_notify_stats()
+{
+  return m_notifier.stats();
+}
+
 ex::device_state unigd_device::plt_state()
 {
   return m_data_store->state();
@@ -708,7 +789,9 @@ bool unigd_device::api_clear()
 std::unique_ptr<ex::render_data> unigd_device::api_render(ex::renderer_id_t t_renderer_id,
                                                           int32_t t_plot_id,
                                                           double t_width, double t_height,
-                                                          double t_scale)
+                                                          double t_scale,
+                                                          const grect<double>* t_region,
+                                                          double t_lod)
 {
   const auto plot_idx = plt_index(t_plot_id);
 
@@ -719,19 +802,507 @@ std::unique_ptr<ex::render_data> unigd_device::api_render(ex::renderer_id_t t_re
     return nullptr;
   }
 
+  render_cache_key key{static_cast<ex::plot_id_t>(t_plot_id), t_renderer_id,
+                       {t_width, t_height}, t_scale};
+  key.lod = t_lod > 0 ? t_lod : 0;
+  page_version_t version;
+  // Regions are not cached, they rarely repeat (think panning).
+  if (!t_region && m_data_store->version_if_size(plot_idx, &key.size, &version))
+  {
+    if (auto cached = m_render_cache.find(key, version))
+    {
+      return cached;
+    }
+  }
+
   auto renderer = ren.generator();
-  if (!m_data_store->render_if_size(plot_idx, renderer.get(), t_scale,
-                                    {t_width, t_height}))
+  if (key.lod > 0)
   {
-    if (!async::r_thread(
-             [&]()
-             { return plt_render(plot_idx, t_width, t_height, renderer.get(), t_scale); })
-             .get())
+    renderer = std::make_unique<renderers::lod_target>(std::move(renderer), key.lod);
+  }
+  if (t_region)
+  {
+    renderer =
+        std::make_unique<renderers::region_target>(std::move(renderer), *t_region);
+  }
+  renderer->raster_threads(m_raster_threads);
+  if (!m_render_plot(plot_idx, t_width, t_height, renderer.get(), t_scale, &version))
+  {
+    return nullptr;
+  }
+  if (t_region)
+  {
+    return renderer;
+  }
+  return m_render_cache.insert(key, version, std::move(renderer));
+}
+
+bool unigd_device::api_render_stream(ex::renderer_id_t t_renderer_id, int32_t t_plot_id,
+                                     double t_width, double t_height, double t_scale,
+                                     const chunk_fn& t_chunk)
+{
+  const auto plot_idx = plt_index(t_plot_id);
+
+  renderers::renderer_map_entry ren;
+  if (!renderers::find(t_renderer_id, &ren))
+  {
+    return false;
+  }
+
+  render_cache_key key{static_cast<ex::plot_id_t>(t_plot_id), t_renderer_id,
+                       {t_width, t_height}, t_scale};
+  page_version_t version;
+  if (m_data_store->version_if_size(plot_idx, &key.size, &version))
+  {
+    if (auto cached = m_render_cache.find(key, version))
     {
-      return nullptr;
+      const uint8_t* buf;
+      size_t size;
+      cached->get_data(&buf, &size);
+      return renderers::stream_buffer(buf, size, t_chunk);
     }
   }
-  return std::move(renderer);
+
+  auto renderer = ren.generator();
+  renderer->raster_threads(m_raster_threads);
+  renderers::stream_target target(renderer.get(), &t_chunk);
+  if (!m_render_plot(plot_idx, t_width, t_height, &target, t_scale, &version))
+  {
+    return false;
+  }
+  return target.complete();
+}
+
+bool unigd_device::api_render_into(ex::renderer_id_t t_renderer_id, int32_t t_plot_id,
+                                   double t_width, double t_height, double t_scale,
+                                   unigd_render_buffer* t_buffer, uint64_t* t_size)
+{
+  uint64_t used = 0;
+  bool fits = true;
+  const bool complete = api_render_stream(
+      t_renderer_id, t_plot_id, t_width, t_height, t_scale,
+      [&](const uint8_t* t_data, std::size_t t_chunk_size)
+      {
+        if (fits && used + t_chunk_size > t_buffer->capacity)
+        {
+          const uint64_t capacity =
+              std::max<uint64_t>(used + t_chunk_size, 2 * t_buffer->capacity);
+          uint8_t* grown =
+              t_buffer->grow
+                  ? t_buffer->grow(t_buffer->user_data, t_buffer->buffer, used, capacity)
+                  : nullptr;
+          if (grown)
+          {
+            t_buffer->buffer = grown;
+            t_buffer->capacity = capacity;
+          }
+          else
+          {
+            // Keep going to find out the size of the output.
+            fits = false;
+          }
+        }
+        if (fits)
+        {
+          std::memcpy(t_buffer->buffer + used, t_data, t_chunk_size);
+        }
+        used += t_chunk_size;
+        return true;
+      });
+  *t_size = complete ? used : 0;
+  return complete && fits;
+}
+
+namespace
+{
+struct batch_job
+{
+  std::size_t pos;  // in the batch
+  int index;
+  double width;
+  double height;
+  render_cache_key key;
+  std::unique_ptr<renderers::render_target> renderer;
+  page_version_t version;
+  bool rendered;
+};
+}  // namespace
+
+std::vector<std::unique_ptr<ex::render_data>> unigd_device::plt_render_batch(
+    const std::vector<render_request>& t_requests)
+{
+  return m_render_batch(t_requests, true);
+}
+
+std::vector<std::unique_ptr<ex::render_data>> unigd_device::api_render_batch(
+    const std::vector<render_request>& t_requests)
+{
+  return m_render_batch(t_requests, false);
+}
+
+std::vector<std::unique_ptr<ex::render_data>> unigd_device::m_render_batch(
+    const std::vector<render_request>& t_requests, bool t_on_r_thread)
+{
+  std::vector<std::unique_ptr<ex::render_data>> result(t_requests.size());
+  std::vector<batch_job> jobs;
+  jobs.reserve(t_requests.size());
+  for (std::size_t i = 0; i != t_requests.size(); ++i)
+  {
+    const auto& request = t_requests[i];
+    renderers::renderer_map_entry ren;
+    // Normalized, so replays of the same plot are recognized
+    const auto index = m_data_store->normalize_index(plt_index(request.plot_id));
+    if (!index || !renderers::find(request.renderer, &ren))
+    {
+      continue;
+    }
+    batch_job job{i,
+                  *index,
+                  request.width,
+                  request.height,
+                  {static_cast<ex::plot_id_t>(request.plot_id), request.renderer,
+                   {request.width, request.height}, request.scale},
+                  nullptr,
+                  0,
+                  false};
+    if (m_data_store->version_if_size(job.index, &job.key.size, &job.version))
+    {
+      if (auto cached = m_render_cache.find(job.key, job.version))
+      {
+        result[i] = std::move(cached);
+        continue;
+      }
+    }
+    job.renderer = ren.generator();
+    job.renderer->raster_threads(m_raster_threads);
+    jobs.push_back(std::move(job));
+  }
+
+  const auto render_all = [this](const std::vector<batch_job*>& t_jobs)
+  {
+    async::parallel_for(t_jobs.size(), std::thread::hardware_concurrency(),
+                        [this, &t_jobs](std::size_t t_i)
+                        {
+                          auto* job = t_jobs[t_i];
+                          try
+                          {
+                            job->rendered = m_data_store->render_if_size(
+                                job->index, job->renderer.get(), job->key.scale,
+                                {job->width, job->height}, &job->version);
+                          }
+                          catch (...)
+                          {
+                            job->rendered = false;
+                          }
+                        });
+  };
+
+  std::vector<batch_job*> replay;
+  for (auto& job : jobs)
+  {
+    replay.push_back(&job);
+  }
+  render_all(replay);
+  replay.erase(std::remove_if(replay.begin(), replay.end(),
+                              [](const batch_job* t_job) { return t_job->rendered; }),
+               replay.end());
+
+  // Replay every plot and size only once. Each replay is rendered before the next one,
+  // which may resize the page or (with a memory limit) evict it.
+  const auto same_replay = [](const batch_job* t_a, const batch_job* t_b)
+  {
+    return t_a->index == t_b->index && t_a->width == t_b->width &&
+           t_a->height == t_b->height;
+  };
+  std::stable_sort(replay.begin(), replay.end(),
+                   [](const batch_job* t_a, const batch_job* t_b)
+                   {
+                     return std::tie(t_a->index, t_a->width, t_a->height) <
+                            std::tie(t_b->index, t_b->width, t_b->height);
+                   });
+  const auto replay_all = [&]()
+  {
+    for (std::size_t a = 0, b = 0; a != replay.size(); a = b)
+    {
+      const auto* first = replay[a];
+      b = a + 1;
+      while (b != replay.size() && same_replay(first, replay[b]))
+      {
+        ++b;
+      }
+      const auto index = plt_replay(first->index, first->width, first->height);
+      if (!index)
+      {
+        continue;
+      }
+      std::vector<batch_job*> group(replay.begin() + a, replay.begin() + b);
+      for (auto* job : group)
+      {
+        job->index = *index;
+      }
+      render_all(group);
+    }
+  };
+  if (!replay.empty())
+  {
+    try
+    {
+      if (t_on_r_thread)
+      {
+        replay_all();
+      }
+      else
+      {
+        async::r_thread(replay_all).get();
+      }
+    }
+    catch (...)
+    {
+    }
+  }
+
+  for (auto& job : jobs)
+  {
+    if (job.rendered)
+    {
+      result[job.pos] =
+          m_render_cache.insert(job.key, job.version, std::move(job.renderer));
+    }
+  }
+  return result;
+}
+
+struct unigd_device::async_job
+{
+  render_cache_key key;
+  int index;
+  double width;
+  double height;
+  std::unique_ptr<renderers::render_target> renderer;
+  page_version_t version;
+  std::shared_ptr<ex::async_render> render;
+};
+
+void unigd_device::api_render_async(ex::renderer_id_t t_renderer_id, int32_t t_plot_id,
+                                    double t_width, double t_height, double t_scale,
+                                    std::shared_ptr<ex::async_render> t_render)
+{
+  renderers::renderer_map_entry ren;
+  if (!renderers::find(t_renderer_id, &ren))
+  {
+    t_render->finish(nullptr);
+    return;
+  }
+
+  auto job = std::make_shared<async_job>(
+      async_job{{static_cast<ex::plot_id_t>(t_plot_id), t_renderer_id,
+                 {t_width, t_height}, t_scale},
+                plt_index(t_plot_id),
+                t_width,
+                t_height,
+                ren.generator(),
+                0,
+                std::move(t_render)});
+  if (m_data_store->version_if_size(job->index, &job->key.size, &job->version))
+  {
+    if (auto cached = m_render_cache.find(job->key, job->version))
+    {
+      job->render->finish(std::move(cached));
+      return;
+    }
+  }
+  job->renderer->raster_threads(m_raster_threads);
+  m_async_render(std::move(job));
+}
+
+void unigd_device::m_async_render(std::shared_ptr<async_job> t_job)
+{
+  m_render_pool.submit(
+      [this, t_job]()
+      {
+        if (t_job->render->cancelled())
+        {
+          return;
+        }
+        if (m_data_store->render_if_size(t_job->index, t_job->renderer.get(),
+                                         t_job->key.scale, {t_job->width, t_job->height},
+                                         &t_job->version))
+        {
+          m_async_finish(t_job, true);
+        }
+        else
+        {
+          m_async_replay(t_job);
+        }
+      });
+}
+
+void unigd_device::m_async_replay(std::shared_ptr<async_job> t_job)
+{
+  // Queued pool work is finished before the device is destroyed, R thread work is not.
+  // Only the R thread holds on to the device, so it is never destroyed by a worker.
+  std::weak_ptr<generic_dev<unigd_device>> weak = weak_from_this();
+  async::r_thread(
+      [weak, t_job]()
+      {
+        const auto dev = std::static_pointer_cast<unigd_device>(weak.lock());
+        if (!dev)
+        {
+          t_job->render->finish(nullptr);
+          return;
+        }
+        if (t_job->render->cancelled())
+        {
+          return;
+        }
+        const auto index = dev->plt_replay(t_job->index, t_job->width, t_job->height);
+        if (!index)
+        {
+          dev->m_render_pool.submit([dev = dev.get(), t_job]()
+                                    { dev->m_async_finish(t_job, false); });
+          return;
+        }
+        t_job->index = *index;
+        dev->m_render_pool.submit(
+            [dev = dev.get(), t_job]()
+            {
+              if (t_job->render->cancelled())
+              {
+                return;
+              }
+              if (dev->m_data_store->render_if_size(
+                      t_job->index, t_job->renderer.get(), t_job->key.scale,
+                      {t_job->width, t_job->height}, &t_job->version))
+              {
+                dev->m_async_finish(t_job, true);
+              }
+              else
+              {
+                // Another replay or an eviction got in between, see m_render_plot()
+                dev->m_async_fallback(t_job);
+              }
+            });
+      });
+}
+
+void unigd_device::m_async_fallback(std::shared_ptr<async_job> t_job)
+{
+  std::weak_ptr<generic_dev<unigd_device>> weak = weak_from_this();
+  async::r_thread(
+      [weak, t_job]()
+      {
+        const auto dev = std::static_pointer_cast<unigd_device>(weak.lock());
+        if (!dev)
+        {
+          t_job->render->finish(nullptr);
+          return;
+        }
+        if (t_job->render->cancelled())
+        {
+          return;
+        }
+        const bool rendered =
+            dev->plt_render(t_job->index, t_job->width, t_job->height,
+                            t_job->renderer.get(), t_job->key.scale, &t_job->version);
+        dev->m_render_pool.submit([dev = dev.get(), t_job, rendered]()
+                                  { dev->m_async_finish(t_job, rendered); });
+      });
+}
+
+void unigd_device::m_async_finish(const std::shared_ptr<async_job>& t_job,
+                                  bool t_rendered)
+{
+  if (!t_rendered)
+  {
+    t_job->render->finish(nullptr);
+    return;
+  }
+  t_job->render->finish(
+      m_render_cache.insert(t_job->key, t_job->version, std::move(t_job->renderer)));
+}
+
+std::vector<std::unique_ptr<ex::render_data>> unigd_device::api_render_tiles(
+    ex::renderer_id_t t_renderer_id, int32_t t_plot_id,
+    const std::vector<renderers::tile_id>& t_tiles, uint32_t t_tile_size)
+{
+  std::vector<std::unique_ptr<ex::render_data>> result;
+  const auto plot_idx = plt_index(t_plot_id);
+
+  renderers::renderer_map_entry ren;
+  if (!renderers::find(t_renderer_id, &ren) || t_tile_size == 0)
+  {
+    return result;
+  }
+  result.resize(t_tiles.size());
+
+  auto key = [&](gvertex<double> t_size, const renderers::tile_id& t_tile)
+  {
+    return render_cache_key{static_cast<ex::plot_id_t>(t_plot_id), t_renderer_id, t_size,
+                            renderers::tile_scale(t_tile.zoom),
+                            renderers::tile_region(t_tile, t_tile_size)};
+  };
+
+  std::vector<renderers::tile_id> missing;
+  std::vector<std::size_t> missing_pos;
+  gvertex<double> size{-1, -1};
+  page_version_t version;
+  const bool current = m_data_store->version_if_size(plot_idx, &size, &version);
+  for (std::size_t i = 0; i != t_tiles.size(); ++i)
+  {
+    if (current)
+    {
+      result[i] = m_render_cache.find(key(size, t_tiles[i]), version);
+    }
+    if (!result[i])
+    {
+      missing.push_back(t_tiles[i]);
+      missing_pos.push_back(i);
+    }
+  }
+  if (missing.empty())
+  {
+    return result;
+  }
+
+  renderers::tile_target target(ren.generator, std::move(missing), t_tile_size,
+                                std::thread::hardware_concurrency());
+  if (!m_render_plot(plot_idx, -1, -1, &target, 1, &version))
+  {
+    return {};
+  }
+  for (std::size_t k = 0; k != missing_pos.size(); ++k)
+  {
+    auto tile = target.take(k);
+    if (tile)
+    {
+      const auto pos = missing_pos[k];
+      result[pos] = m_render_cache.insert(key(target.page_size(), t_tiles[pos]), version,
+                                          std::move(tile));
+    }
+  }
+  return result;
+}
+
+bool unigd_device::api_hit_test(int32_t t_plot_id, grect<double> t_rect,
+                                std::vector<std::size_t>* t_out)
+{
+  const auto plot_idx = m_data_store->find_index(t_plot_id);
+  if (!plot_idx)
+  {
+    return false;
+  }
+  return plt_hit_test(*plot_idx, t_rect, t_out);
+}
+
+bool unigd_device::api_delta(int32_t t_plot_id, uint64_t t_cursor,
+                             ex::delta_results* t_out)
+{
+  const auto plot_idx = m_data_store->find_index(t_plot_id);
+  if (!plot_idx)
+  {
+    return false;
+  }
+  return m_data_store->delta(*plot_idx, t_cursor, t_out);
 }
 
 }  // namespace unigd
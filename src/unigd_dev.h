@@ -11,9 +11,13 @@
 
 #include <cpp11/list.hpp>
 
+#include "async_utils.h"
 #include "generic_dev.h"
 #include "page_store.h"
+#include "page_tiles.h"
 #include "plot_history.h"
+#include "render_cache.h"
+#include "state_notifier.h"
 #include "unigd_commons.h"
 #include "unigd_external.h"
 
@@ -27,6 +31,22 @@ struct device_params
   double pointsize;
   cpp11::list aliases;
   bool reset_par;
+  std::size_t render_cache_size;  // bytes
+  std::size_t memory_limit;       // bytes, 0 = unlimited
+  std::string spill_dir;          // empty = do not spill
+  bool primitive_runs;            // merge consecutive primitives into runs
+  unsigned raster_threads;        // threads per raster render, 0 = all cores
+  unsigned notify_window;         // ms state changes are merged for, 0 = off
+};
+
+// One render of a batch, see unigd_device::api_render_batch.
+struct render_request
+{
+  int32_t plot_id;
+  std::string renderer;
+  double width;
+  double height;
+  double scale;
 };
 
 struct FontCacheEntry
@@ -80,22 +100,75 @@ class unigd_device : public generic_dev<unigd_device>
   // Synchronous access
 
   void plt_prerender(int index, double width, double height);
+  // Replays a plot in the graphics engine at the given size (unset dimensions keep the
+  // current page size). Returns the normalized index, nullopt if there is no such plot.
+  std::experimental::optional<ex::plot_relative_t> plt_replay(int index, double width,
+                                                              double height);
   bool plt_remove(int index);
   bool plt_clear();
   bool plt_render(int index, double width, double height,
-                  renderers::render_target* t_renderer, double t_scale);
+                  renderers::render_target* t_renderer, double t_scale,
+                  page_version_t* t_version = nullptr);
+
+  // Renders every request of a batch, replays run directly (call on the R thread).
+  std::vector<std::unique_ptr<ex::render_data>> plt_render_batch(
+      const std::vector<render_request>& t_requests);
 
   // Datastore only access
 
   ex::device_state plt_state();
   ex::find_results plt_query(int offset, int limit);
   int plt_index(int32_t id);
+  bool plt_hit_test(int index, grect<double> t_rect, std::vector<std::size_t>* t_out);
+  render_cache_stats plt_cache_stats();
+  page_store_memory plt_memory();
+  state_notifier_stats plt_notify_stats();
 
   // Asynchronous access
 
+  // With a t_lod greater than 0, the plot is simplified to that tolerance in output
+  // pixels (see page_lod.h).
   std::unique_ptr<ex::render_data> api_render(ex::renderer_id_t t_renderer_id,
                                               int32_t t_plot_id, double t_width,
-                                              double t_height, double t_scale);
+                                              double t_height, double t_scale,
+                                              const grect<double>* t_region = nullptr,
+                                              double t_lod = 0);
+  // Starts a render without waiting for it, t_render is finished when it is done. The
+  // render runs on the render pool, a replay at a new size is posted to the R thread.
+  // t_render is never finished on the R thread, so its callback may render synchronously.
+  void api_render_async(ex::renderer_id_t t_renderer_id, int32_t t_plot_id,
+                        double t_width, double t_height, double t_scale,
+                        std::shared_ptr<ex::async_render> t_render);
+  // Renders a plot and hands the output to t_chunk while it is produced (see
+  // renderers::render_target::stream()). The output is not cached. t_chunk runs while
+  // the page is locked against drawing and replays. Returns false if the plot could not
+  // be rendered or t_chunk stopped the output.
+  bool api_render_stream(ex::renderer_id_t t_renderer_id, int32_t t_plot_id,
+                         double t_width, double t_height, double t_scale,
+                         const chunk_fn& t_chunk);
+  // Renders a plot into client memory (through api_render_stream(), so streaming
+  // renderers write straight into it). t_size is set to the size of the output, also
+  // when it did not fit. Returns false if the plot could not be rendered or the output
+  // did not fit.
+  bool api_render_into(ex::renderer_id_t t_renderer_id, int32_t t_plot_id,
+                       double t_width, double t_height, double t_scale,
+                       unigd_render_buffer* t_buffer, uint64_t* t_size);
+  // Renders a batch of requests. Plots that are stored at the requested size are
+  // rendered in parallel right away, the others are replayed in a single R thread task
+  // (once per plot and size) and rendered in parallel afterwards. Requests that could
+  // not be rendered are nullptr.
+  std::vector<std::unique_ptr<ex::render_data>> api_render_batch(
+      const std::vector<render_request>& t_requests);
+  bool api_hit_test(int32_t t_plot_id, grect<double> t_rect,
+                    std::vector<std::size_t>* t_out);
+  // Draw calls of a plot added since a cursor, see page_store::delta().
+  bool api_delta(int32_t t_plot_id, uint64_t t_cursor, ex::delta_results* t_out);
+  // Renders tiles (see renderers::tile_id) of a plot at its current size in parallel.
+  // Cached tiles are only rendered again after the plot changed. Tiles that could
+  // not be rendered are nullptr, the result is empty if the plot does not exist.
+  std::vector<std::unique_ptr<ex::render_data>> api_render_tiles(
+      ex::renderer_id_t t_renderer_id, int32_t t_plot_id,
+      const std::vector<renderers::tile_id>& t_tiles, uint32_t t_tile_size);
   bool api_remove(int32_t t_id);
   bool api_clear();
 
@@ -131,29 +204,81 @@ class unigd_device : public generic_dev<unigd_device>
  private:
   PlotHistory m_history;
   std::shared_ptr<page_store> m_data_store;
+  render_cache m_render_cache;
 
   ex::graphics_client* m_client{nullptr};
   UNIGD_CLIENT_ID m_client_id = 0;
   void* m_client_data{nullptr};
+  state_notifier m_notifier;
 
   bool replaying{false};  // Is the device replaying
   DeviceTarget m_target;
 
   bool m_initialized{false};
-
-  void put(std::unique_ptr<renderers::DrawCall>&& t_dc);
+  bool m_primitive_runs{true};
+  unsigned m_raster_threads{1};
+
+  template <class T, class... Args>
+  void put(Args&&... t_args)
+  {
+    if (m_target.is_void())
+    {
+      return;
+    }
+    m_dc_buffer.emplace<T>(std::forward<Args>(t_args)...);
+  }
+
+  template <class T>
+  void put_primitive(T&& t_dc)
+  {
+    if (m_target.is_void())
+    {
+      return;
+    }
+    if (m_primitive_runs)
+    {
+      renderers::append_primitive(&m_dc_buffer, std::move(t_dc));
+    }
+    else
+    {
+      m_dc_buffer.emplace<T>(std::move(t_dc));
+    }
+  }
 
   const FontCacheEntry& resolve_font(const char* family, int face);
+  renderers::style_id_t line_style(pGEcontext gc);
 
   // set device size
   void resize_device_to_page(pDevDesc dd);
 
+  // Renders a stored plot on the calling thread. Only the graphics engine replay (needed
+  // when the plot does not have the requested size yet) runs on the R thread.
+  // Should another replay or an eviction get in between, the plot is replayed and rendered
+  // in one step on the R thread instead.
+  bool m_render_plot(int t_index, double t_width, double t_height,
+                     renderers::render_target* t_renderer, double t_scale,
+                     page_version_t* t_version);
+  std::vector<std::unique_ptr<ex::render_data>> m_render_batch(
+      const std::vector<render_request>& t_requests, bool t_on_r_thread);
+  struct async_job;
+  // Steps of api_render_async, none of them waits for another thread.
+  void m_async_render(std::shared_ptr<async_job> t_job);
+  void m_async_replay(std::shared_ptr<async_job> t_job);
+  void m_async_fallback(std::shared_ptr<async_job> t_job);
+  void m_async_finish(const std::shared_ptr<async_job>& t_job, bool t_rendered);
+
   // graphical parameters for reseting
   cpp11::list m_reset_par;
 
   std::map<std::pair<std::string, int>, FontCacheEntry> m_font_cache;
 
-  std::vector<std::unique_ptr<unigd::renderers::DrawCall>> m_dc_buffer{};
+  unigd::renderers::draw_call_list m_dc_buffer{};
+  unigd::renderers::style_table m_dc_styles{};  // styles of the buffered draw calls
+
+  // Runs the renders of api_render_async(), synchronous renders never wait for it.
+  // Declared last so the workers are joined before anything a queued render uses is
+  // destroyed.
+  async::thread_pool m_render_pool;
 };
 
 }  // namespace unigd
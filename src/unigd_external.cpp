@@ -16,6 +16,62 @@ unigd_find_results find_results::c_repr()
   return {state, static_cast<plot_index_t>(ids.size()), ids.data()};
 }
 
+unigd_hit_results hit_results::c_repr()
+{
+  return {indices.size(), indices.data()};
+}
+
+unigd_delta_results delta_results::c_repr()
+{
+  return {{id, sequence}, reset, data.data(), data.size()};
+}
+
+async_render::async_render(unigd_render_callback t_callback, void* t_user_data)
+    : m_callback(t_callback), m_user_data(t_user_data)
+{
+}
+
+bool async_render::cancel()
+{
+  int expected = UNIGD_ASYNC_PENDING;
+  return m_status.compare_exchange_strong(expected, UNIGD_ASYNC_CANCELLED);
+}
+
+bool async_render::cancelled() const
+{
+  return m_status.load() == UNIGD_ASYNC_CANCELLED;
+}
+
+void async_render::finish(std::unique_ptr<render_data> t_data)
+{
+  const int result = t_data ? UNIGD_ASYNC_DONE : UNIGD_ASYNC_FAILED;
+  // Only read by others once the status says done
+  m_data = std::move(t_data);
+  int expected = UNIGD_ASYNC_PENDING;
+  if (!m_status.compare_exchange_strong(expected, result))
+  {
+    return;
+  }
+  if (m_callback)
+  {
+    unigd_render_access access;
+    m_callback(m_user_data, status(&access), access);
+  }
+}
+
+unigd_async_status async_render::status(unigd_render_access* t_access) const
+{
+  const auto result = static_cast<unigd_async_status>(m_status.load());
+  *t_access = {nullptr, 0};
+  if (result == UNIGD_ASYNC_DONE)
+  {
+    size_t buf_size;
+    m_data->get_data(&t_access->buffer, &buf_size);
+    t_access->size = buf_size;
+  }
+  return result;
+}
+
 int api_test_fun()
 {
   return 7;
@@ -123,6 +179,183 @@ void api_render_destroy(UNIGD_RENDER_HANDLE handle)
   delete static_cast<unigd::ex::render_data*>(handle);
 }
 
+UNIGD_RENDER_HANDLE api_render_region_create(UNIGD_HANDLE ugd_handle,
+                                             UNIGD_RENDERER_ID renderer_id,
+                                             UNIGD_PLOT_ID plot_id,
+                                             unigd_render_args render_args,
+                                             unigd_rect region,
+                                             unigd_render_access* render_access)
+{
+  const auto ugd = static_cast<unigd_handle_t*>(ugd_handle);
+  const grect<double> rect{region.x, region.y, region.width, region.height};
+  auto handle = ugd->device
+                    ->api_render(renderer_id, plot_id, render_args.width,
+                                 render_args.height, render_args.scale, &rect)
+                    .release();
+  if (handle)
+  {
+    size_t buf_size;
+    handle->get_data(&render_access->buffer, &buf_size);
+    render_access->size = buf_size;
+  }
+  else
+  {
+    render_access->buffer = nullptr;
+    render_access->size = 0;
+  }
+  return handle;
+}
+
+UNIGD_RENDER_HANDLE api_render_lod_create(UNIGD_HANDLE ugd_handle,
+                                          UNIGD_RENDERER_ID renderer_id,
+                                          UNIGD_PLOT_ID plot_id,
+                                          unigd_render_args render_args, double lod,
+                                          unigd_render_access* render_access)
+{
+  const auto ugd = static_cast<unigd_handle_t*>(ugd_handle);
+  auto handle = ugd->device
+                    ->api_render(renderer_id, plot_id, render_args.width,
+                                 render_args.height, render_args.scale, nullptr, lod)
+                    .release();
+  if (handle)
+  {
+    size_t buf_size;
+    handle->get_data(&render_access->buffer, &buf_size);
+    render_access->size = buf_size;
+  }
+  else
+  {
+    render_access->buffer = nullptr;
+    render_access->size = 0;
+  }
+  return handle;
+}
+
+UNIGD_TILES_HANDLE api_render_tiles_create(UNIGD_HANDLE ugd_handle,
+                                           UNIGD_RENDERER_ID renderer_id,
+                                           UNIGD_PLOT_ID plot_id,
+                                           const unigd_tile_args* tiles, uint64_t count,
+                                           uint32_t tile_size,
+                                           unigd_render_access* results)
+{
+  const auto ugd = static_cast<unigd_handle_t*>(ugd_handle);
+  std::vector<renderers::tile_id> ids;
+  ids.reserve(count);
+  for (uint64_t i = 0; i != count; ++i)
+  {
+    ids.push_back({tiles[i].zoom, tiles[i].x, tiles[i].y});
+  }
+
+  auto* re = new tile_results{};
+  re->tiles = ugd->device->api_render_tiles(renderer_id, plot_id, ids, tile_size);
+  for (uint64_t i = 0; i != count; ++i)
+  {
+    results[i] = {nullptr, 0};
+    if (i < re->tiles.size() && re->tiles[i])
+    {
+      size_t buf_size;
+      re->tiles[i]->get_data(&results[i].buffer, &buf_size);
+      results[i].size = buf_size;
+    }
+  }
+  return re;
+}
+
+void api_render_tiles_destroy(UNIGD_TILES_HANDLE handle)
+{
+  delete static_cast<unigd::ex::tile_results*>(handle);
+}
+
+UNIGD_BATCH_HANDLE api_render_batch_create(UNIGD_HANDLE ugd_handle,
+                                           const unigd_batch_args* requests,
+                                           uint64_t count, unigd_render_access* results)
+{
+  const auto ugd = static_cast<unigd_handle_t*>(ugd_handle);
+  std::vector<render_request> batch;
+  batch.reserve(count);
+  for (uint64_t i = 0; i != count; ++i)
+  {
+    batch.push_back({static_cast<int32_t>(requests[i].id),
+                     requests[i].renderer ? requests[i].renderer : "",
+                     requests[i].args.width, requests[i].args.height,
+                     requests[i].args.scale});
+  }
+
+  auto* re = new batch_results{};
+  re->renders = ugd->device->api_render_batch(batch);
+  for (uint64_t i = 0; i != count; ++i)
+  {
+    results[i] = {nullptr, 0};
+    if (re->renders[i])
+    {
+      size_t buf_size;
+      re->renders[i]->get_data(&results[i].buffer, &buf_size);
+      results[i].size = buf_size;
+    }
+  }
+  return re;
+}
+
+void api_render_batch_destroy(UNIGD_BATCH_HANDLE handle)
+{
+  delete static_cast<unigd::ex::batch_results*>(handle);
+}
+
+bool api_render_stream(UNIGD_HANDLE ugd_handle, UNIGD_RENDERER_ID renderer_id,
+                       UNIGD_PLOT_ID plot_id, unigd_render_args render_args,
+                       unigd_chunk_callback callback, void* user_data)
+{
+  const auto ugd = static_cast<unigd_handle_t*>(ugd_handle);
+  return ugd->device->api_render_stream(
+      renderer_id, plot_id, render_args.width, render_args.height, render_args.scale,
+      [&](const uint8_t* t_data, std::size_t t_size)
+      { return callback(user_data, t_data, t_size); });
+}
+
+bool api_render_into(UNIGD_HANDLE ugd_handle, UNIGD_RENDERER_ID renderer_id,
+                     UNIGD_PLOT_ID plot_id, unigd_render_args render_args,
+                     unigd_render_buffer* buffer, uint64_t* size)
+{
+  const auto ugd = static_cast<unigd_handle_t*>(ugd_handle);
+  return ugd->device->api_render_into(renderer_id, plot_id, render_args.width,
+                                      render_args.height, render_args.scale, buffer,
+                                      size);
+}
+
+UNIGD_ASYNC_RENDER_HANDLE api_render_async_create(UNIGD_HANDLE ugd_handle,
+                                                  UNIGD_RENDERER_ID renderer_id,
+                                                  UNIGD_PLOT_ID plot_id,
+                                                  unigd_render_args render_args,
+                                                  unigd_render_callback callback,
+                                                  void* user_data)
+{
+  const auto ugd = static_cast<unigd_handle_t*>(ugd_handle);
+  auto* handle =
+      new async_render_handle{std::make_shared<async_render>(callback, user_data)};
+  ugd->device->api_render_async(renderer_id, plot_id, render_args.width,
+                                render_args.height, render_args.scale, handle->render);
+  return handle;
+}
+
+unigd_async_status api_render_async_poll(UNIGD_ASYNC_RENDER_HANDLE handle,
+                                         unigd_render_access* render_access)
+{
+  return static_cast<async_render_handle*>(handle)->render->status(render_access);
+}
+
+bool api_render_async_cancel(UNIGD_ASYNC_RENDER_HANDLE handle)
+{
+  return static_cast<async_render_handle*>(handle)->render->cancel();
+}
+
+void api_render_async_destroy(UNIGD_ASYNC_RENDER_HANDLE handle)
+{
+  auto* h = static_cast<async_render_handle*>(handle);
+  // Workers still holding the render drop their result
+  h->render->cancel();
+  delete h;
+}
+
 UNIGD_FIND_HANDLE api_plots_find(UNIGD_HANDLE ugd_handle, UNIGD_PLOT_RELATIVE offset,
                                  UNIGD_PLOT_INDEX limit, unigd_find_results* results)
 {
@@ -139,6 +372,50 @@ void api_plots_find_destroy(UNIGD_FIND_HANDLE handle)
   delete static_cast<unigd::ex::find_results*>(handle);
 }
 
+UNIGD_HIT_HANDLE api_plots_hit_test(UNIGD_HANDLE ugd_handle, UNIGD_PLOT_ID plot_id,
+                                    unigd_rect rect, unigd_hit_results* results)
+{
+  const auto ugd = static_cast<unigd_handle_t*>(ugd_handle);
+
+  std::vector<std::size_t> indices;
+  if (!ugd->device->api_hit_test(plot_id, {rect.x, rect.y, rect.width, rect.height},
+                                 &indices))
+  {
+    *results = {0, nullptr};
+    return nullptr;
+  }
+  auto* re = new hit_results{};
+  re->indices.assign(indices.begin(), indices.end());
+  *results = re->c_repr();
+  return re;
+}
+
+void api_plots_hit_test_destroy(UNIGD_HIT_HANDLE handle)
+{
+  delete static_cast<unigd::ex::hit_results*>(handle);
+}
+
+UNIGD_DELTA_HANDLE api_plots_delta(UNIGD_HANDLE ugd_handle, unigd_delta_cursor cursor,
+                                   unigd_delta_results* results)
+{
+  const auto ugd = static_cast<unigd_handle_t*>(ugd_handle);
+
+  auto* re = new delta_results{};
+  if (!ugd->device->api_delta(cursor.id, cursor.sequence, re))
+  {
+    delete re;
+    *results = {cursor, false, nullptr, 0};
+    return nullptr;
+  }
+  *results = re->c_repr();
+  return re;
+}
+
+void api_plots_delta_destroy(UNIGD_DELTA_HANDLE handle)
+{
+  delete static_cast<unigd::ex::delta_results*>(handle);
+}
+
 UNIGD_RENDERERS_ENTRY_HANDLE api_renderers_find(UNIGD_RENDERER_ID id,
                                                 unigd_renderer_info* renderer)
 {
@@ -208,6 +485,28 @@ int api_v1_create(unigd_api_v1** api_)
   api->renderers_find = api_renderers_find;
   api->renderers_find_destroy = api_renderers_find_destroy;
 
+  api->device_render_region_create = api_render_region_create;
+  api->device_plots_hit_test = api_plots_hit_test;
+  api->device_plots_hit_test_destroy = api_plots_hit_test_destroy;
+
+  api->device_render_tiles_create = api_render_tiles_create;
+  api->device_render_tiles_destroy = api_render_tiles_destroy;
+
+  api->device_render_async_create = api_render_async_create;
+  api->device_render_async_poll = api_render_async_poll;
+  api->device_render_async_cancel = api_render_async_cancel;
+  api->device_render_async_destroy = api_render_async_destroy;
+
+  api->device_render_batch_create = api_render_batch_create;
+  api->device_render_batch_destroy = api_render_batch_destroy;
+  api->device_render_stream = api_render_stream;
+  api->device_render_into = api_render_into;
+
+  api->device_plots_delta = api_plots_delta;
+  api->device_plots_delta_destroy = api_plots_delta_destroy;
+
+  api->device_render_lod_create = api_render_lod_create;
+
   *api_ = api;
   return 0;
 }
@@ -1,6 +1,7 @@
 #ifndef __UNIGD_UNIGD_EXTERNAL_H__
 #define __UNIGD_UNIGD_EXTERNAL_H__
 
+#include <atomic>
 #include <cstring>
 #include <memory>
 #include <stdlib.h>
@@ -48,6 +49,23 @@ struct find_results
   unigd_find_results c_repr();
 };
 
+struct hit_results
+{
+  std::vector<uint64_t> indices;
+
+  unigd_hit_results c_repr();
+};
+
+struct delta_results
+{
+  plot_id_t id;
+  uint64_t sequence;
+  bool reset;
+  std::vector<uint8_t> data;
+
+  unigd_delta_results c_repr();
+};
+
 class render_data
 {
  public:
@@ -56,6 +74,43 @@ class render_data
 
   virtual void get_data(const uint8_t** t_buf, size_t* t_size) const = 0;
 };
+
+struct tile_results
+{
+  std::vector<std::unique_ptr<render_data>> tiles;
+};
+
+struct batch_results
+{
+  std::vector<std::unique_ptr<render_data>> renders;
+};
+
+// Shared state of a render started with device_render_async_create. It finishes
+// exactly once: done, failed or cancelled.
+class async_render
+{
+ public:
+  async_render(unigd_render_callback t_callback, void* t_user_data);
+
+  // Returns false if the render has already finished.
+  bool cancel();
+  bool cancelled() const;
+  // Finishes the render (failed for nullptr) and calls the callback. Does nothing if
+  // the render has been cancelled.
+  void finish(std::unique_ptr<render_data> t_data);
+  unigd_async_status status(unigd_render_access* t_access) const;
+
+ private:
+  unigd_render_callback m_callback;
+  void* m_user_data;
+  std::atomic<int> m_status{UNIGD_ASYNC_PENDING};
+  std::unique_ptr<render_data> m_data;
+};
+
+struct async_render_handle
+{
+  std::shared_ptr<async_render> render;
+};
 }  // namespace ex
 
 }  // namespace unigd
@@ -8,13 +8,14 @@ namespace unigd
 {
 namespace uuid
 {
-static std::random_device rd;
-static std::mt19937 gen(rd());
-static std::uniform_int_distribution<> dis(0, 15);
-static std::uniform_int_distribution<> dis2(8, 11);
-
 std::string uuid()
 {
+  // Renderers may run on several threads at once, so every thread gets its own
+  // generator.
+  thread_local std::mt19937 gen(std::random_device{}());
+  std::uniform_int_distribution<> dis(0, 15);
+  std::uniform_int_distribution<> dis2(8, 11);
+
   std::stringstream ss;
   int i;
   ss << std::hex;